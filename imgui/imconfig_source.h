@@ -40,9 +40,9 @@ IMGUI_API uint64		ImFileWrite( const void *data, uint64 size, uint64 count, ImFi
 #endif
 
 
-//---- Use stb_sprintf.h for a faster implementation of vsnprintf instead of the one from libc (unless IMGUI_DISABLE_DEFAULT_FORMAT_FUNCTIONS is defined)
-// Compatibility checks of arguments and formats done by clang and GCC will be disabled in order to support the extra formats provided by stb_sprintf.h.
-//#define IMGUI_USE_STB_SPRINTF
+// ImFormatString and ImFormatStringV are implemented in imgui_format.cpp, which formats the common
+// conversions without the CRT. Unlike IMGUI_USE_STB_SPRINTF, this keeps the compiler's format checks.
+#define IMGUI_DISABLE_DEFAULT_FORMAT_FUNCTIONS
 
 
 #include "mathlib/vector2d.h"
@@ -0,0 +1,375 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#include "imgui_allocstats.h"
+#include "imgui_window.h"
+
+#include "igamesystem.h"
+#include "imgui_format.h"
+#include "tier0/vprof.h"
+#include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
+
+#include <math.h>
+
+#include "tier0/memdbgon.h"
+
+CDearImGuiAllocStats g_ImGuiAllocStats;
+
+static CThreadLocalPtr<void> s_pAllocThreadCounters;
+static CThreadLocalPtr<const CDearImGuiAllocScope> s_pAllocScope;
+
+CDearImGuiAllocStats::~CDearImGuiAllocStats()
+{
+	m_Threads.PurgeAndDeleteElements();
+}
+
+int CDearImGuiAllocStats::FindOrAddTag( const char *pszName )
+{
+	AUTO_LOCK( m_Mutex );
+	for ( int i = 0; i < m_nTags; i++ )
+	{
+		if ( m_pszTags[i] == pszName || !V_strcmp( m_pszTags[i], pszName ) )
+			return i;
+	}
+
+	if ( m_nTags >= IMGUI_ALLOC_MAX_TAGS )
+		return -1;
+
+	m_pszTags[m_nTags] = pszName;
+	++m_nTags;
+	return m_nTags - 1;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: The calling thread's counters, created the first time it records anything
+//---------------------------------------------------------------------------------------//
+CDearImGuiAllocStats::ThreadCounters_t *CDearImGuiAllocStats::GetThreadCounters()
+{
+	ThreadCounters_t *pCounters = static_cast<ThreadCounters_t *>( s_pAllocThreadCounters.Get() );
+	if ( pCounters )
+		return pCounters;
+
+	pCounters = new ThreadCounters_t();
+	s_pAllocThreadCounters.Set( pCounters );
+
+	AUTO_LOCK( m_Mutex );
+	m_Threads.AddToTail( pCounters );
+	return pCounters;
+}
+
+void CDearImGuiAllocStats::Record( int nTag, int nBytes )
+{
+	if ( nTag < 0 )
+		return;
+
+	// Only this thread writes its counters, Sample's reads can be a frame behind
+	ThreadCounters_t *pCounters = GetThreadCounters();
+	pCounters->nCount[nTag]++;
+	pCounters->nBytes[nTag] += nBytes;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Add up every thread's counters and store the difference from the last frame
+//---------------------------------------------------------------------------------------//
+void CDearImGuiAllocStats::Sample( float flFrameTime )
+{
+	VPROF_BUDGET( "CDearImGuiAllocStats::Sample", VPROF_BUDGETGROUP_IMGUI );
+
+	Sample_t totals[IMGUI_ALLOC_MAX_TAGS] = {};
+	const int nTags = m_nTags;
+	{
+		AUTO_LOCK( m_Mutex );
+		FOR_EACH_VEC( m_Threads, i )
+		{
+			const ThreadCounters_t *pCounters = m_Threads[i];
+			for ( int nTag = 0; nTag < nTags; nTag++ )
+			{
+				totals[nTag].nCount += pCounters->nCount[nTag];
+				totals[nTag].nBytes += pCounters->nBytes[nTag];
+			}
+		}
+	}
+
+	// Keep the totals moving while paused, so resuming doesn't show one huge frame
+	if ( !m_bPaused )
+	{
+		Frame_t &frame = m_History[m_nFrames % IMGUI_ALLOC_HISTORY];
+		frame.flFrameTime = flFrameTime;
+		for ( int nTag = 0; nTag < IMGUI_ALLOC_MAX_TAGS; nTag++ )
+		{
+			frame.samples[nTag].nCount = totals[nTag].nCount - m_Totals[nTag].nCount;
+			frame.samples[nTag].nBytes = totals[nTag].nBytes - m_Totals[nTag].nBytes;
+		}
+		m_nFrames++;
+	}
+
+	V_memcpy( m_Totals, totals, sizeof( m_Totals ) );
+}
+
+CDearImGuiAllocScope::CDearImGuiAllocScope( const char *pszTag, int nTag ) : m_pszTag( pszTag ), m_nTag( nTag )
+{
+	m_pOuter = s_pAllocScope.Get();
+	s_pAllocScope.Set( this );
+}
+
+CDearImGuiAllocScope::~CDearImGuiAllocScope()
+{
+	Assert( s_pAllocScope.Get() == this );
+	s_pAllocScope.Set( m_pOuter );
+}
+
+const CDearImGuiAllocScope *CDearImGuiAllocScope::GetCurrent()
+{
+	return s_pAllocScope.Get();
+}
+
+class CDearImGuiAllocStatsSystem : public CAutoGameSystemPerFrame
+{
+public:
+	CDearImGuiAllocStatsSystem() : CAutoGameSystemPerFrame( "CDearImGuiAllocStatsSystem" ) {}
+
+	void Update( float frametime ) override
+	{
+		g_ImGuiAllocStats.Sample( frametime );
+	}
+};
+
+static CDearImGuiAllocStatsSystem s_ImGuiAllocStatsSystem;
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Allocations window. A heatmap of bytes per tag and frame, the tags by rate
+//  over the history, and the per-frame churn of the selected tag.
+//---------------------------------------------------------------------------------------//
+class CDearImGuiAllocationsWindow : public IImguiWindow
+{
+public:
+	CDearImGuiAllocationsWindow() : IImguiWindow( "allocations", "Allocations" ) {}
+
+	bool Draw() override;
+
+private:
+	struct TagSummary_t
+	{
+		int nTag;
+		float flCountRate;		// Per second
+		float flByteRate;
+		float flAverageCount;	// Per frame
+		uint32 nPeakBytes;
+	};
+
+	void UpdateSummaries();
+	void DrawHeatmap();
+	void DrawTable();
+	void DrawChurn();
+
+	CUtlVector<TagSummary_t> m_Summaries;	// Highest byte rate first
+	int m_nSelectedTag = -1;
+};
+
+DEFINE_IMGUI_WINDOW( CDearImGuiAllocationsWindow );
+
+bool CDearImGuiAllocationsWindow::Draw()
+{
+	CDearImGuiAllocStats &stats = g_ImGuiAllocStats;
+
+	bool bPaused = stats.IsPaused();
+	if ( ImGui::Checkbox( "Pause", &bPaused ) )
+		stats.SetPaused( bPaused );
+
+	ImGui::SameLine();
+	ImGui::TextDisabled( "%d tags, %d frames", stats.GetTagCount(), stats.GetFrameCount() );
+
+	if ( !stats.GetTagCount() || !stats.GetFrameCount() )
+	{
+		ImGui::TextUnformatted( "Nothing has been recorded yet." );
+		return true;
+	}
+
+	UpdateSummaries();
+	DrawHeatmap();
+	DrawTable();
+	DrawChurn();
+	return true;
+}
+
+void CDearImGuiAllocationsWindow::UpdateSummaries()
+{
+	const CDearImGuiAllocStats &stats = g_ImGuiAllocStats;
+	const int nFrames = stats.GetFrameCount();
+
+	float flTime = 0.0f;
+	for ( int nFrame = 0; nFrame < nFrames; nFrame++ )
+		flTime += stats.GetFrameTime( nFrame );
+	flTime = MAX( flTime, 0.001f );
+
+	m_Summaries.SetCount( stats.GetTagCount() );
+	FOR_EACH_VEC( m_Summaries, nTag )
+	{
+		double flCount = 0.0, flBytes = 0.0;
+		uint32 nPeak = 0;
+		for ( int nFrame = 0; nFrame < nFrames; nFrame++ )
+		{
+			const CDearImGuiAllocStats::Sample_t &sample = stats.GetSample( nFrame, nTag );
+			flCount += sample.nCount;
+			flBytes += sample.nBytes;
+			nPeak = MAX( nPeak, sample.nBytes );
+		}
+
+		TagSummary_t &summary = m_Summaries[nTag];
+		summary.nTag = nTag;
+		summary.flCountRate = flCount / flTime;
+		summary.flByteRate = flBytes / flTime;
+		summary.flAverageCount = flCount / nFrames;
+		summary.nPeakBytes = nPeak;
+	}
+
+	m_Summaries.Sort( []( const TagSummary_t *a, const TagSummary_t *b ) -> int
+	{
+		if ( a->flByteRate != b->flByteRate )
+			return a->flByteRate > b->flByteRate ? -1 : 1;
+		return a->nTag - b->nTag;
+	} );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: One row per tag in table order, one column per frame, brighter for more
+//  bytes on a log scale. Clicking a cell picks its tag.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiAllocationsWindow::DrawHeatmap()
+{
+	const CDearImGuiAllocStats &stats = g_ImGuiAllocStats;
+	const int nFrames = stats.GetFrameCount();
+	const int nRows = m_Summaries.Count();
+
+	uint32 nMax = 1;
+	FOR_EACH_VEC( m_Summaries, i )
+		nMax = MAX( nMax, m_Summaries[i].nPeakBytes );
+	const float flLogMax = logf( 1.0f + nMax );
+
+	const float flRowHeight = ImGui::GetFontSize() * 0.5f;
+	const ImVec2 vecPos = ImGui::GetCursorScreenPos();
+	const ImVec2 vecSize( MAX( ImGui::GetContentRegionAvail().x, 64.0f ), flRowHeight * nRows );
+	ImGui::InvisibleButton( "##heatmap", vecSize );
+
+	ImDrawList *pDrawList = ImGui::GetWindowDrawList();
+	pDrawList->AddRectFilled( vecPos, ImVec2( vecPos.x + vecSize.x, vecPos.y + vecSize.y ), ImGui::GetColorU32( ImGuiCol_FrameBg ) );
+
+	const float flColumnWidth = vecSize.x / IMGUI_ALLOC_HISTORY;
+	const float flLeft = vecPos.x + vecSize.x - nFrames * flColumnWidth;
+	for ( int nRow = 0; nRow < nRows; nRow++ )
+	{
+		const int nTag = m_Summaries[nRow].nTag;
+		const float y = vecPos.y + nRow * flRowHeight;
+		for ( int nFrame = 0; nFrame < nFrames; nFrame++ )
+		{
+			const uint32 nBytes = stats.GetSample( nFrame, nTag ).nBytes;
+			if ( !nBytes )
+				continue;
+
+			const float flHeat = logf( 1.0f + nBytes ) / flLogMax;
+			const ImU32 color = ImGui::GetColorU32( ImVec4( flHeat, 0.25f * flHeat, 1.0f - flHeat, 0.35f + 0.65f * flHeat ) );
+			const float x = flLeft + nFrame * flColumnWidth;
+			pDrawList->AddRectFilled( ImVec2( x, y ), ImVec2( x + MAX( flColumnWidth, 1.0f ), y + flRowHeight - 1.0f ), color );
+		}
+
+		if ( nTag == m_nSelectedTag )
+			pDrawList->AddRect( ImVec2( vecPos.x, y ), ImVec2( vecPos.x + vecSize.x, y + flRowHeight ), ImGui::GetColorU32( ImGuiCol_Text ) );
+	}
+
+	if ( !ImGui::IsItemHovered() )
+		return;
+
+	const ImVec2 vecMouse = ImGui::GetIO().MousePos;
+	const int nRow = (int)( ( vecMouse.y - vecPos.y ) / flRowHeight );
+	const int nFrame = (int)floorf( ( vecMouse.x - flLeft ) / flColumnWidth );
+	if ( nRow < 0 || nRow >= nRows || nFrame < 0 || nFrame >= nFrames )
+		return;
+
+	const int nTag = m_Summaries[nRow].nTag;
+	const CDearImGuiAllocStats::Sample_t &sample = stats.GetSample( nFrame, nTag );
+	ImGui::SetTooltip( "%s\n%d frames ago: %u allocations, %.1f KB", stats.GetTagName( nTag ), nFrames - 1 - nFrame, sample.nCount, sample.nBytes / 1024.0f );
+
+	if ( ImGui::IsItemClicked() )
+		m_nSelectedTag = nTag;
+}
+
+void CDearImGuiAllocationsWindow::DrawTable()
+{
+	const CDearImGuiAllocStats &stats = g_ImGuiAllocStats;
+
+	const float flHeight = ImGui::GetFontSize() * 12.0f;
+	if ( !ImGui::BeginTable( "##tags", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp, ImVec2( 0.0f, flHeight ) ) )
+		return;
+
+	ImGui::TableSetupScrollFreeze( 0, 1 );
+	ImGui::TableSetupColumn( "Tag" );
+	ImGui::TableSetupColumn( "Allocs/s" );
+	ImGui::TableSetupColumn( "KB/s" );
+	ImGui::TableSetupColumn( "Allocs/frame" );
+	ImGui::TableSetupColumn( "Peak KB/frame" );
+	ImGui::TableHeadersRow();
+
+	FOR_EACH_VEC( m_Summaries, i )
+	{
+		const TagSummary_t &summary = m_Summaries[i];
+
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+		ImGui::PushID( summary.nTag );
+		if ( ImGui::Selectable( stats.GetTagName( summary.nTag ), summary.nTag == m_nSelectedTag, ImGuiSelectableFlags_SpanAllColumns ) )
+			m_nSelectedTag = summary.nTag;
+		ImGui::PopID();
+		ImGui::TableNextColumn();
+		g_ImGuiTextCache.Text( "%.0f", summary.flCountRate );
+		ImGui::TableNextColumn();
+		g_ImGuiTextCache.Text( "%.1f", summary.flByteRate / 1024.0f );
+		ImGui::TableNextColumn();
+		g_ImGuiTextCache.Text( "%.1f", summary.flAverageCount );
+		ImGui::TableNextColumn();
+		g_ImGuiTextCache.Text( "%.1f", summary.nPeakBytes / 1024.0f );
+	}
+
+	ImGui::EndTable();
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Bytes allocated in each frame of the history by the selected tag
+//---------------------------------------------------------------------------------------//
+void CDearImGuiAllocationsWindow::DrawChurn()
+{
+	const CDearImGuiAllocStats &stats = g_ImGuiAllocStats;
+	if ( m_nSelectedTag < 0 || m_nSelectedTag >= stats.GetTagCount() )
+	{
+		ImGui::TextDisabled( "Pick a tag to see its churn per frame." );
+		return;
+	}
+
+	auto getter = []( void *pData, int nFrame ) -> float
+	{
+		return g_ImGuiAllocStats.GetSample( nFrame, *static_cast<int *>( pData ) ).nBytes / 1024.0f;
+	};
+
+	ImGui::Text( "%s, KB per frame", stats.GetTagName( m_nSelectedTag ) );
+	ImGui::PlotHistogram( "##churn", getter, &m_nSelectedTag, stats.GetFrameCount(), 0, nullptr, 0.0f, FLT_MAX, ImVec2( ImGui::GetContentRegionAvail().x, ImGui::GetFontSize() * 5.0f ) );
+}
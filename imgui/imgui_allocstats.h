@@ -0,0 +1,141 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#pragma once
+
+#include "tier0/threadtools.h"
+#include "utlvector.h"
+
+#define IMGUI_ALLOC_MAX_TAGS	64
+#define IMGUI_ALLOC_HISTORY		256		// Frames
+
+//--------------------------------------------------------------------------------//
+// Purpose: Allocation counts and bytes per tag, for the allocations window. Tags
+//  are the names passed to MemAlloc_Alloc as its file, so the same allocations
+//  show up under the same name in tier0's dumps. Each thread counts into its own
+//  block of counters with plain stores, and Sample adds the blocks up once per
+//  frame into a history of per-frame totals.
+//
+//  tier0 has no hook for other modules' allocations, so code has to count its own
+//  with IMGUI_ALLOC_RECORD next to the allocation. imgui's own allocations are
+//  counted under the innermost IMGUI_ALLOC_SCOPE on their thread, which splits them
+//  into frame building, windows, rendering, fonts and retained output. Anything
+//  outside a scope is counted under "Dear ImGui".
+//--------------------------------------------------------------------------------//
+class CDearImGuiAllocStats
+{
+public:
+	~CDearImGuiAllocStats();
+
+	struct Sample_t
+	{
+		uint32 nCount;
+		uint32 nBytes;
+	};
+
+	// Tag names must be static strings. Returns -1 once IMGUI_ALLOC_MAX_TAGS are in use.
+	int FindOrAddTag( const char *pszName );
+
+	// Any thread
+	void Record( int nTag, int nBytes );
+
+	// Once per frame, on the main thread
+	void Sample( float flFrameTime );
+
+	void SetPaused( bool bPaused ) { m_bPaused = bPaused; }
+	bool IsPaused() const { return m_bPaused; }
+
+	int GetTagCount() const { return m_nTags; }
+	const char *GetTagName( int nTag ) const { return m_pszTags[nTag]; }
+
+	// Frames in the history, oldest first
+	int GetFrameCount() const { return MIN( m_nFrames, IMGUI_ALLOC_HISTORY ); }
+	const Sample_t &GetSample( int nFrame, int nTag ) const { return m_History[GetHistoryIndex( nFrame )].samples[nTag]; }
+	float GetFrameTime( int nFrame ) const { return m_History[GetHistoryIndex( nFrame )].flFrameTime; }
+
+private:
+	struct ThreadCounters_t
+	{
+		volatile uint32 nCount[IMGUI_ALLOC_MAX_TAGS];
+		volatile uint32 nBytes[IMGUI_ALLOC_MAX_TAGS];
+	};
+
+	struct Frame_t
+	{
+		float flFrameTime;
+		Sample_t samples[IMGUI_ALLOC_MAX_TAGS];
+	};
+
+	ThreadCounters_t *GetThreadCounters();
+	int GetHistoryIndex( int nFrame ) const { return ( m_nFrames - GetFrameCount() + nFrame ) % IMGUI_ALLOC_HISTORY; }
+
+	// Names are only appended, and the count is raised after the name is stored
+	const char *m_pszTags[IMGUI_ALLOC_MAX_TAGS] = {};
+	CInterlockedInt m_nTags;
+
+	// Counter blocks live as long as the process, threads that exit keep theirs
+	CThreadFastMutex m_Mutex;
+	CUtlVector<ThreadCounters_t *> m_Threads;
+
+	// Totals at the previous sample, the counters wrap so only differences are used
+	Sample_t m_Totals[IMGUI_ALLOC_MAX_TAGS] = {};
+	Frame_t m_History[IMGUI_ALLOC_HISTORY];
+	int m_nFrames = 0;
+	bool m_bPaused = false;
+};
+
+extern CDearImGuiAllocStats g_ImGuiAllocStats;
+
+//--------------------------------------------------------------------------------//
+// Purpose: Tag imgui's allocations on this thread are counted under while it's in
+//  scope. Scopes nest, the innermost one wins.
+//--------------------------------------------------------------------------------//
+class CDearImGuiAllocScope
+{
+public:
+	CDearImGuiAllocScope( const char *pszTag, int nTag );
+	~CDearImGuiAllocScope();
+
+	const char *GetTagName() const { return m_pszTag; }
+	int GetTag() const { return m_nTag; }
+
+	// Innermost scope of the calling thread, or null
+	static const CDearImGuiAllocScope *GetCurrent();
+
+private:
+	const char *m_pszTag;
+	int m_nTag;
+	const CDearImGuiAllocScope *m_pOuter;
+};
+
+#define IMGUI_ALLOC_SCOPE( pszTag )															\
+	static const int s_nImGuiAllocScopeTag = g_ImGuiAllocStats.FindOrAddTag( pszTag );		\
+	CDearImGuiAllocScope imguiAllocScope( pszTag, s_nImGuiAllocScopeTag )
+
+// Counts an allocation of nBytes under a tag, looking the tag up once per call site
+#define IMGUI_ALLOC_RECORD( pszTag, nBytes )										\
+	do																				\
+	{																				\
+		static const int s_nImGuiAllocTag = g_ImGuiAllocStats.FindOrAddTag( pszTag );	\
+		g_ImGuiAllocStats.Record( s_nImGuiAllocTag, ( nBytes ) );					\
+	} while ( 0 )
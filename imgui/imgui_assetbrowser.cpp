@@ -0,0 +1,651 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#include "cbase.h"
+#include "imgui_assetbrowser.h"
+#include "imgui_window.h"
+
+#include "checksum_crc.h"
+#include "filesystem.h"
+#include "fmtstr.h"
+#include "igamesystem.h"
+#include "tier0/vprof.h"
+#include "imgui/imgui.h"
+
+#include "tier0/memdbgon.h"
+
+#define ASSET_CACHE_MAGIC		MAKEID( 'I', 'G', 'A', 'I' )
+#define ASSET_CACHE_VERSION		1
+
+CDearImGuiAssetIndex g_ImGuiAssetIndex;
+
+static const struct
+{
+	const char *pszName;
+	const char *pszExtensions[6];
+} s_AssetTypes[IMGUI_ASSET_TYPE_COUNT] =
+{
+	{ "Other",		{} },
+	{ "Material",	{ "vmt" } },
+	{ "Texture",	{ "vtf" } },
+	{ "Model",		{ "mdl", "vvd", "vtx", "phy", "ani" } },
+	{ "Sound",		{ "wav", "mp3", "ogg" } },
+	{ "Particles",	{ "pcf" } },
+	{ "Map",		{ "bsp", "nav", "ain", "lmp" } },
+	{ "Text",		{ "txt", "cfg", "res", "nut", "vdf", "lst" } },
+};
+
+static int GetAssetType( const char *pszPath )
+{
+	const char *pszExtension = V_GetFileExtension( pszPath );
+	if ( !pszExtension )
+		return IMGUI_ASSET_OTHER;
+
+	for ( int i = 1; i < IMGUI_ASSET_TYPE_COUNT; i++ )
+	{
+		for ( int j = 0; j < ARRAYSIZE( s_AssetTypes[i].pszExtensions ) && s_AssetTypes[i].pszExtensions[j]; j++ )
+		{
+			if ( !V_strcmp( pszExtension, s_AssetTypes[i].pszExtensions[j] ) )
+				return i;
+		}
+	}
+	return IMGUI_ASSET_OTHER;
+}
+
+const char *CDearImGuiAssetIndex::GetTypeName( int nType )
+{
+	return s_AssetTypes[nType < IMGUI_ASSET_TYPE_COUNT ? nType : IMGUI_ASSET_OTHER].pszName;
+}
+
+CDearImGuiAssetIndex::~CDearImGuiAssetIndex()
+{
+	Stop();
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Starting and finishing builds, on the main thread
+//---------------------------------------------------------------------------------------//
+void CDearImGuiAssetIndex::Load()
+{
+	if ( !IsLoaded() && !IsBuilding() )
+		Start( true );
+}
+
+void CDearImGuiAssetIndex::Rebuild()
+{
+	Stop();
+	Start( false );
+}
+
+void CDearImGuiAssetIndex::Start( bool bUseCache )
+{
+	m_nKey = ComputeKey();
+	m_bUseCache = bUseCache;
+	m_bStop = 0;
+	m_bDone = 0;
+	m_nScanned = 0;
+	m_hThread = CreateSimpleThread( ThreadProc, this );
+}
+
+void CDearImGuiAssetIndex::Stop()
+{
+	if ( !IsBuilding() )
+		return;
+
+	m_bStop = 1;
+	ThreadJoin( m_hThread );
+	ReleaseThreadHandle( m_hThread );
+	m_hThread = nullptr;
+	m_Pending.Purge();
+}
+
+bool CDearImGuiAssetIndex::Update()
+{
+	if ( !IsBuilding() || !m_bDone )
+		return false;
+
+	ThreadJoin( m_hThread );
+	ReleaseThreadHandle( m_hThread );
+	m_hThread = nullptr;
+
+	if ( !m_Pending.TellPut() )
+		return false;
+
+	m_Data.Swap( m_Pending );
+	m_Pending.Purge();
+	Attach();
+	return true;
+}
+
+void CDearImGuiAssetIndex::Attach()
+{
+	const uint8 *pBase = (const uint8 *)m_Data.Base();
+	m_pHeader = (const Header_t *)pBase;
+	m_pEntries = (const Entry_t *)( m_pHeader + 1 );
+	m_pOrigins = (const uint32 *)( m_pEntries + m_pHeader->nEntries );
+	m_pStrings = (const char *)( m_pOrigins + m_pHeader->nOrigins );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Gather the search paths, normalised like the indexed paths, and hash them
+//  with the timestamps of their directories and VPKs
+//---------------------------------------------------------------------------------------//
+uint32 CDearImGuiAssetIndex::ComputeKey()
+{
+	CUtlVector<char> searchPath;
+	searchPath.SetCount( 4096 );
+	int nLength = g_pFullFileSystem->GetSearchPath( "GAME", true, searchPath.Base(), searchPath.Count() );
+	if ( nLength > searchPath.Count() )
+	{
+		searchPath.SetCount( nLength );
+		g_pFullFileSystem->GetSearchPath( "GAME", true, searchPath.Base(), searchPath.Count() );
+	}
+	searchPath.Tail() = '\0';
+
+	CUtlStringList paths;
+	V_SplitString( searchPath.Base(), ";", paths );
+
+	m_SearchPaths.RemoveAll();
+	CRC32_t nKey;
+	CRC32_Init( &nKey );
+	FOR_EACH_VEC( paths, i )
+	{
+		char szPath[MAX_PATH];
+		V_strncpy( szPath, paths[i], sizeof( szPath ) );
+		V_FixSlashes( szPath, '/' );
+		V_strlower( szPath );
+		m_SearchPaths.AddToTail( szPath );
+
+		// VPKs are listed by their base name, their directory file is what changes
+		long nTime = g_pFullFileSystem->GetFileTime( paths[i] );
+		if ( !nTime && V_stristr( szPath, ".vpk" ) )
+		{
+			char szDir[MAX_PATH];
+			V_StripExtension( paths[i], szDir, sizeof( szDir ) );
+			V_strncat( szDir, "_dir.vpk", sizeof( szDir ) );
+			nTime = g_pFullFileSystem->GetFileTime( szDir );
+		}
+
+		CRC32_ProcessBuffer( &nKey, szPath, V_strlen( szPath ) );
+		CRC32_ProcessBuffer( &nKey, &nTime, sizeof( nTime ) );
+	}
+	CRC32_Final( &nKey );
+	return nKey;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Build thread. Uses the cache when its key matches, otherwise walks the
+//  filesystem and writes a new one.
+//---------------------------------------------------------------------------------------//
+unsigned CDearImGuiAssetIndex::ThreadProc( void *pParam )
+{
+	static_cast<CDearImGuiAssetIndex *>( pParam )->Run();
+	return 0;
+}
+
+void CDearImGuiAssetIndex::Run()
+{
+	if ( !m_bUseCache || !ReadCache( m_Pending ) )
+	{
+		m_Pending.Purge();
+		if ( Scan( m_Pending ) )
+		{
+			if ( !g_pFullFileSystem->WriteFile( IMGUI_ASSET_CACHE, "MOD", m_Pending ) )
+				Warning( "Failed to write %s\n", IMGUI_ASSET_CACHE );
+		}
+		else
+		{
+			m_Pending.Purge();
+		}
+	}
+
+	m_bDone = 1;
+}
+
+bool CDearImGuiAssetIndex::ReadCache( CUtlBuffer &buf )
+{
+	if ( !g_pFullFileSystem->ReadFile( IMGUI_ASSET_CACHE, "MOD", buf ) || buf.TellPut() < (int)sizeof( Header_t ) )
+		return false;
+
+	const Header_t *pHeader = (const Header_t *)buf.Base();
+	if ( pHeader->nMagic != ASSET_CACHE_MAGIC || pHeader->nVersion != ASSET_CACHE_VERSION || pHeader->nKey != m_nKey )
+		return false;
+
+	if ( pHeader->nEntries < 0 || pHeader->nOrigins <= 0 || pHeader->nStringBytes <= 0 )
+		return false;
+
+	// The strings must end where the file does, and every offset has to land in them
+	const int64 nSize = (int64)sizeof( Header_t ) + (int64)pHeader->nEntries * sizeof( Entry_t ) + (int64)pHeader->nOrigins * sizeof( uint32 ) + pHeader->nStringBytes;
+	if ( nSize != buf.TellPut() || ( (const char *)buf.Base() )[nSize - 1] != '\0' )
+		return false;
+
+	const Entry_t *pEntries = (const Entry_t *)( pHeader + 1 );
+	const uint32 *pOrigins = (const uint32 *)( pEntries + pHeader->nEntries );
+	for ( int i = 0; i < pHeader->nOrigins; i++ )
+	{
+		if ( pOrigins[i] >= (uint32)pHeader->nStringBytes )
+			return false;
+	}
+	for ( int i = 0; i < pHeader->nEntries; i++ )
+	{
+		if ( pEntries[i].nPath >= (uint32)pHeader->nStringBytes || pEntries[i].nOrigin >= pHeader->nOrigins )
+			return false;
+	}
+
+	return true;
+}
+
+bool CDearImGuiAssetIndex::Scan( CUtlBuffer &buf )
+{
+	tmZone( TELEMETRY_LEVEL1, TMZF_NONE, "%s", __FUNCTION__ );
+
+	CUtlVector<char> strings;
+	CUtlVector<uint32> origins;
+	CUtlVector<Entry_t> entries;
+
+	// Origins are matched by prefix, VPKs without their extension so both the base
+	// name and the _dir name match
+	CUtlVector<CUtlString> prefixes;
+	FOR_EACH_VEC( m_SearchPaths, i )
+	{
+		const char *pszPath = m_SearchPaths[i].Get();
+		origins.AddToTail( strings.Count() );
+		strings.AddMultipleToTail( V_strlen( pszPath ) + 1, pszPath );
+
+		char szPrefix[MAX_PATH];
+		V_strncpy( szPrefix, pszPath, sizeof( szPrefix ) );
+		if ( V_stristr( szPrefix, ".vpk" ) )
+			V_StripExtension( pszPath, szPrefix, sizeof( szPrefix ) );
+		prefixes.AddToTail( szPrefix );
+	}
+	const int nUnknownOrigin = origins.AddToTail( strings.Count() );
+	strings.AddMultipleToTail( sizeof( "unknown" ), "unknown" );
+
+	CUtlStringList directories;
+	directories.CopyAndAddToTail( "" );
+
+	char szWildcard[MAX_PATH], szPath[MAX_PATH], szFullPath[MAX_PATH];
+	while ( directories.Count() )
+	{
+		char *pszDirectory = directories.Tail();
+		directories.RemoveMultipleFromTail( 1 );
+		V_snprintf( szWildcard, sizeof( szWildcard ), "%s*", pszDirectory );
+
+		FileFindHandle_t hFind;
+		for ( const char *pszName = g_pFullFileSystem->FindFirstEx( szWildcard, "GAME", &hFind ); pszName && !m_bStop; pszName = g_pFullFileSystem->FindNext( hFind ) )
+		{
+			if ( !V_strcmp( pszName, "." ) || !V_strcmp( pszName, ".." ) )
+				continue;
+
+			V_snprintf( szPath, sizeof( szPath ), "%s%s", pszDirectory, pszName );
+			V_FixSlashes( szPath, '/' );
+			V_strlower( szPath );
+
+			if ( g_pFullFileSystem->FindIsDirectory( hFind ) )
+			{
+				V_strncat( szPath, "/", sizeof( szPath ) );
+				directories.CopyAndAddToTail( szPath );
+				continue;
+			}
+
+			Entry_t &entry = entries[entries.AddToTail()];
+			entry.nPath = strings.Count();
+			entry.nSize = g_pFullFileSystem->Size( szPath, "GAME" );
+			entry.nType = GetAssetType( szPath );
+			entry.nOrigin = nUnknownOrigin;
+
+			if ( g_pFullFileSystem->RelativePathToFullPath( szPath, "GAME", szFullPath, sizeof( szFullPath ) ) )
+			{
+				V_FixSlashes( szFullPath, '/' );
+				V_strlower( szFullPath );
+
+				int nLongest = 0;
+				FOR_EACH_VEC( prefixes, i )
+				{
+					const int nPrefix = prefixes[i].Length();
+					if ( nPrefix > nLongest && !V_strncmp( szFullPath, prefixes[i].Get(), nPrefix ) )
+					{
+						nLongest = nPrefix;
+						entry.nOrigin = i;
+					}
+				}
+			}
+
+			strings.AddMultipleToTail( V_strlen( szPath ) + 1, szPath );
+			m_nScanned++;
+		}
+		g_pFullFileSystem->FindClose( hFind );
+		delete[] pszDirectory;
+
+		if ( m_bStop )
+			return false;
+	}
+
+	// Sort by path, and drop files found in more than one search path
+	struct SortEntry_t
+	{
+		const char *pszPath;
+		Entry_t entry;
+	};
+
+	CUtlVector<SortEntry_t> sorted;
+	sorted.SetCount( entries.Count() );
+	FOR_EACH_VEC( entries, i )
+	{
+		sorted[i].pszPath = strings.Base() + entries[i].nPath;
+		sorted[i].entry = entries[i];
+	}
+	sorted.Sort( []( const SortEntry_t *a, const SortEntry_t *b )
+	{
+		return V_strcmp( a->pszPath, b->pszPath );
+	} );
+
+	entries.RemoveAll();
+	FOR_EACH_VEC( sorted, i )
+	{
+		if ( i == 0 || V_strcmp( sorted[i].pszPath, sorted[i - 1].pszPath ) )
+			entries.AddToTail( sorted[i].entry );
+	}
+
+	Header_t header;
+	header.nMagic = ASSET_CACHE_MAGIC;
+	header.nVersion = ASSET_CACHE_VERSION;
+	header.nKey = m_nKey;
+	header.nEntries = entries.Count();
+	header.nOrigins = origins.Count();
+	header.nStringBytes = strings.Count();
+
+	buf.EnsureCapacity( sizeof( header ) + entries.Count() * sizeof( Entry_t ) + origins.Count() * sizeof( uint32 ) + strings.Count() );
+	buf.Put( &header, sizeof( header ) );
+	buf.Put( entries.Base(), entries.Count() * sizeof( Entry_t ) );
+	buf.Put( origins.Base(), origins.Count() * sizeof( uint32 ) );
+	buf.Put( strings.Base(), strings.Count() );
+	return true;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Stop the build thread before the filesystem goes away
+//---------------------------------------------------------------------------------------//
+class CDearImGuiAssetIndexSystem : public CAutoGameSystem
+{
+public:
+	CDearImGuiAssetIndexSystem() : CAutoGameSystem( "CDearImGuiAssetIndexSystem" ) {}
+
+	void Shutdown() override
+	{
+		g_ImGuiAssetIndex.Stop();
+	}
+};
+
+static CDearImGuiAssetIndexSystem s_ImGuiAssetIndexSystem;
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Asset browser window. Filters the index by substring, or by glob when the
+//  filter has wildcards, and draws only the visible rows of the result.
+//---------------------------------------------------------------------------------------//
+class CDearImGuiAssetBrowser : public IImguiWindow
+{
+public:
+	CDearImGuiAssetBrowser() : IImguiWindow( "assets", "Asset Browser" ) {}
+
+	bool Draw() override;
+	void OnChangeVisibility() override;
+
+private:
+	void UpdateFilter( bool bIndexChanged );
+	void DrawContextMenu( const CDearImGuiAssetIndex::Entry_t &entry );
+
+	char m_szFilter[MAX_PATH] = {};
+	uint32 m_nTypeMask = ( 1u << IMGUI_ASSET_TYPE_COUNT ) - 1;
+
+	// Filter m_Filtered was built with
+	char m_szApplied[MAX_PATH] = {};
+	uint32 m_nAppliedMask = 0;
+	bool m_bAppliedGlob = false;
+
+	CUtlVector<int> m_Filtered;
+	int m_nSelected = -1;
+};
+
+DEFINE_IMGUI_WINDOW( CDearImGuiAssetBrowser );
+
+void CDearImGuiAssetBrowser::OnChangeVisibility()
+{
+	if ( ShouldDraw() )
+	{
+		g_ImGuiAssetIndex.Load();
+		m_nAppliedMask = 0;
+	}
+	else
+	{
+		m_Filtered.Purge();
+	}
+}
+
+static bool MatchGlob( const char *pszPattern, const char *pszText )
+{
+	const char *pszStar = nullptr;
+	const char *pszResume = nullptr;
+	while ( *pszText )
+	{
+		if ( *pszPattern == '?' || *pszPattern == *pszText )
+		{
+			pszPattern++;
+			pszText++;
+		}
+		else if ( *pszPattern == '*' )
+		{
+			pszStar = pszPattern++;
+			pszResume = pszText;
+		}
+		else if ( pszStar )
+		{
+			pszPattern = pszStar + 1;
+			pszText = ++pszResume;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	while ( *pszPattern == '*' )
+		pszPattern++;
+	return !*pszPattern;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Typing more of a substring only narrows the result, so the previous result is
+//  filtered again instead of the whole index
+//---------------------------------------------------------------------------------------//
+void CDearImGuiAssetBrowser::UpdateFilter( bool bIndexChanged )
+{
+	char szFilter[MAX_PATH];
+	V_strncpy( szFilter, m_szFilter, sizeof( szFilter ) );
+	V_FixSlashes( szFilter, '/' );
+	V_strlower( szFilter );
+
+	const bool bGlob = strpbrk( szFilter, "*?" ) != nullptr;
+	if ( !bIndexChanged && m_nAppliedMask == m_nTypeMask && m_bAppliedGlob == bGlob && !V_strcmp( m_szApplied, szFilter ) )
+		return;
+
+	VPROF_BUDGET( "CDearImGuiAssetBrowser::UpdateFilter", VPROF_BUDGETGROUP_IMGUI );
+
+	const CDearImGuiAssetIndex &index = g_ImGuiAssetIndex;
+	const bool bRefine = !bIndexChanged && m_nAppliedMask == m_nTypeMask && !bGlob && !m_bAppliedGlob && V_strstr( szFilter, m_szApplied );
+
+	auto Matches = [&]( int i )
+	{
+		const CDearImGuiAssetIndex::Entry_t &entry = index.GetEntry( i );
+		if ( !( m_nTypeMask & ( 1u << entry.nType ) ) )
+			return false;
+		if ( !szFilter[0] )
+			return true;
+		return bGlob ? MatchGlob( szFilter, index.GetPath( entry ) ) : V_strstr( index.GetPath( entry ), szFilter ) != nullptr;
+	};
+
+	if ( bRefine )
+	{
+		int nKept = 0;
+		FOR_EACH_VEC( m_Filtered, i )
+		{
+			if ( Matches( m_Filtered[i] ) )
+				m_Filtered[nKept++] = m_Filtered[i];
+		}
+		m_Filtered.SetCountNonDestructively( nKept );
+	}
+	else
+	{
+		m_Filtered.RemoveAll();
+		for ( int i = 0; i < index.GetCount(); i++ )
+		{
+			if ( Matches( i ) )
+				m_Filtered.AddToTail( i );
+		}
+	}
+
+	V_strncpy( m_szApplied, szFilter, sizeof( m_szApplied ) );
+	m_nAppliedMask = m_nTypeMask;
+	m_bAppliedGlob = bGlob;
+
+	if ( bIndexChanged )
+		m_nSelected = -1;
+}
+
+// The last two components, "hl2/hl2_textures.vpk" or "hl2/"
+static const char *GetOriginLabel( const char *pszOrigin )
+{
+	const char *pszLabel = pszOrigin + V_strlen( pszOrigin );
+	for ( int nSlashes = 0; pszLabel > pszOrigin; pszLabel-- )
+	{
+		if ( pszLabel[-1] == '/' && pszLabel[0] && ++nSlashes == 2 )
+			break;
+	}
+	return pszLabel;
+}
+
+void CDearImGuiAssetBrowser::DrawContextMenu( const CDearImGuiAssetIndex::Entry_t &entry )
+{
+	const char *pszPath = g_ImGuiAssetIndex.GetPath( entry );
+	if ( ImGui::MenuItem( "Copy Path" ) )
+		ImGui::SetClipboardText( pszPath );
+
+	if ( ImGui::MenuItem( "Copy Origin" ) )
+		ImGui::SetClipboardText( g_ImGuiAssetIndex.GetOrigin( entry ) );
+
+	if ( entry.nType == IMGUI_ASSET_TEXT || entry.nType == IMGUI_ASSET_MATERIAL )
+	{
+		if ( ImGui::MenuItem( "Open in Text Editor" ) )
+			engine->ClientCmd_Unrestricted( CFmtStr( "imgui_edit \"%s\"\n", pszPath ) );
+	}
+}
+
+bool CDearImGuiAssetBrowser::Draw()
+{
+	CDearImGuiAssetIndex &index = g_ImGuiAssetIndex;
+	const bool bIndexChanged = index.Update();
+
+	if ( index.IsBuilding() )
+	{
+		ImGui::Text( "Indexing, %d files", index.GetScanned() );
+		ImGui::SameLine();
+		if ( ImGui::SmallButton( "Cancel" ) )
+			index.Stop();
+	}
+	else
+	{
+		ImGui::Text( "%d files, %d shown", index.GetCount(), m_Filtered.Count() );
+		ImGui::SameLine();
+		if ( ImGui::SmallButton( "Rebuild" ) )
+			index.Rebuild();
+	}
+
+	ImGui::SetNextItemWidth( -FLT_MIN );
+	ImGui::InputTextWithHint( "##filter", "Filter, * and ? for wildcards", m_szFilter, sizeof( m_szFilter ) );
+
+	for ( int i = 0; i < IMGUI_ASSET_TYPE_COUNT; i++ )
+	{
+		if ( i > 0 )
+			ImGui::SameLine();
+		ImGui::CheckboxFlags( CDearImGuiAssetIndex::GetTypeName( i ), &m_nTypeMask, 1u << i );
+	}
+
+	if ( !index.IsLoaded() )
+		return true;
+
+	UpdateFilter( bIndexChanged );
+
+	const ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable | ImGuiTableFlags_BordersInnerV;
+	if ( !ImGui::BeginTable( "##assets", 4, flags ) )
+		return true;
+
+	ImGui::TableSetupScrollFreeze( 0, 1 );
+	ImGui::TableSetupColumn( "Path", ImGuiTableColumnFlags_WidthStretch );
+	ImGui::TableSetupColumn( "Type", ImGuiTableColumnFlags_WidthFixed, ImGui::GetFontSize() * 5.0f );
+	ImGui::TableSetupColumn( "Size", ImGuiTableColumnFlags_WidthFixed, ImGui::GetFontSize() * 5.0f );
+	ImGui::TableSetupColumn( "Origin", ImGuiTableColumnFlags_WidthFixed, ImGui::GetFontSize() * 12.0f );
+	ImGui::TableHeadersRow();
+
+	ImGuiListClipper clipper;
+	clipper.Begin( m_Filtered.Count() );
+	while ( clipper.Step() )
+	{
+		for ( int nRow = clipper.DisplayStart; nRow < clipper.DisplayEnd; nRow++ )
+		{
+			const int nEntry = m_Filtered[nRow];
+			const CDearImGuiAssetIndex::Entry_t &entry = index.GetEntry( nEntry );
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::PushID( nEntry );
+			if ( ImGui::Selectable( index.GetPath( entry ), m_nSelected == nEntry, ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowOverlap ) )
+				m_nSelected = nEntry;
+
+			if ( ImGui::BeginPopupContextItem() )
+			{
+				m_nSelected = nEntry;
+				DrawContextMenu( entry );
+				ImGui::EndPopup();
+			}
+			ImGui::PopID();
+
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted( CDearImGuiAssetIndex::GetTypeName( entry.nType ) );
+
+			ImGui::TableNextColumn();
+			if ( entry.nSize >= 1024 * 1024 )
+				ImGui::Text( "%.1f MB", entry.nSize / ( 1024.0f * 1024.0f ) );
+			else
+				ImGui::Text( "%.1f KB", entry.nSize / 1024.0f );
+
+			ImGui::TableNextColumn();
+			const char *pszOrigin = index.GetOrigin( entry );
+			ImGui::TextUnformatted( GetOriginLabel( pszOrigin ) );
+			if ( ImGui::IsItemHovered() )
+				ImGui::SetTooltip( "%s", pszOrigin );
+		}
+	}
+
+	ImGui::EndTable();
+	return true;
+}
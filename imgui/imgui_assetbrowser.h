@@ -0,0 +1,129 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#pragma once
+
+#include "utlbuffer.h"
+#include "utlstring.h"
+#include "utlvector.h"
+#include "tier0/threadtools.h"
+
+#define IMGUI_ASSET_CACHE "imgui_assets.cache"
+
+enum ImGuiAssetType_t
+{
+	IMGUI_ASSET_OTHER = 0,
+	IMGUI_ASSET_MATERIAL,
+	IMGUI_ASSET_TEXTURE,
+	IMGUI_ASSET_MODEL,
+	IMGUI_ASSET_SOUND,
+	IMGUI_ASSET_PARTICLES,
+	IMGUI_ASSET_MAP,
+	IMGUI_ASSET_TEXT,
+
+	IMGUI_ASSET_TYPE_COUNT
+};
+
+//--------------------------------------------------------------------------------//
+// Purpose: Index of every file visible in the GAME search path, with its size and
+//  the search path or VPK it comes from. Building it means walking the whole
+//  filesystem, so it's done on a thread and saved to IMGUI_ASSET_CACHE. The cache
+//  is laid out exactly as the index is held in memory, it's used in place after a
+//  single read with no parsing. It's keyed on the search paths and the timestamps
+//  of their directories and VPKs, and rebuilt when any of them changes.
+//--------------------------------------------------------------------------------//
+class CDearImGuiAssetIndex
+{
+public:
+	struct Entry_t
+	{
+		uint32 nPath;		// Offset into the strings, lowercase with forward slashes
+		uint32 nSize;
+		uint16 nType;		// ImGuiAssetType_t
+		uint16 nOrigin;		// Search path the file was found in
+	};
+
+	~CDearImGuiAssetIndex();
+
+	// Loads the cache, or builds the index if it's missing or stale. Rebuild ignores the cache.
+	void Load();
+	void Rebuild();
+
+	// Stops a build in progress, keeping the index already loaded
+	void Stop();
+
+	// Swaps in the finished index, returns true if the entries changed
+	bool Update();
+
+	bool IsBuilding() const { return m_hThread != nullptr; }
+	int GetScanned() const { return m_nScanned; }
+	bool IsLoaded() const { return m_pEntries != nullptr; }
+
+	// Entries are sorted by path
+	int GetCount() const { return m_pEntries ? m_pHeader->nEntries : 0; }
+	const Entry_t &GetEntry( int i ) const { return m_pEntries[i]; }
+	const char *GetPath( const Entry_t &entry ) const { return m_pStrings + entry.nPath; }
+	const char *GetOrigin( const Entry_t &entry ) const { return m_pStrings + m_pOrigins[entry.nOrigin]; }
+
+	static const char *GetTypeName( int nType );
+
+private:
+	// Start of the cache file, followed by the entries, the origin string offsets and the strings
+	struct Header_t
+	{
+		uint32 nMagic;
+		uint32 nVersion;
+		uint32 nKey;
+		int nEntries;
+		int nOrigins;
+		int nStringBytes;
+	};
+
+	void Start( bool bUseCache );
+	void Attach();
+	uint32 ComputeKey();
+
+	static unsigned ThreadProc( void *pParam );
+	void Run();
+	bool ReadCache( CUtlBuffer &buf );
+	bool Scan( CUtlBuffer &buf );
+
+	// Loaded index, pointing into m_Data
+	CUtlBuffer m_Data;
+	const Header_t *m_pHeader = nullptr;
+	const Entry_t *m_pEntries = nullptr;
+	const uint32 *m_pOrigins = nullptr;
+	const char *m_pStrings = nullptr;
+
+	// Build in progress, m_Pending and the search paths belong to the thread until it's done
+	ThreadHandle_t m_hThread = nullptr;
+	CUtlBuffer m_Pending;
+	CUtlVector<CUtlString> m_SearchPaths;
+	uint32 m_nKey = 0;
+	bool m_bUseCache = true;
+	CInterlockedInt m_bStop;
+	CInterlockedInt m_bDone;
+	CInterlockedInt m_nScanned;
+};
+
+extern CDearImGuiAssetIndex g_ImGuiAssetIndex;
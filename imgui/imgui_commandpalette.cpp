@@ -0,0 +1,613 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#include "imgui_commandpalette.h"
+#include "imgui_window.h"
+
+#include "cdll_client_int.h"
+#include "convar.h"
+#include "icvar.h"
+#include "strtools.h"
+#include "tier0/fasttimer.h"
+#include "tier0/vprof.h"
+#include "imgui/imgui.h"
+
+#include "tier0/memdbgon.h"
+
+CDearImGuiCommandPalette g_ImGuiCommandPalette;
+
+// Marks the start of a name, so "^sv" style trigrams find word starts
+#define TRIGRAM_START	'\x01'
+
+static inline uint32 MakeTrigram( char a, char b, char c )
+{
+	return ( (uint32)(uint8)a << 16 ) | ( (uint32)(uint8)b << 8 ) | (uint32)(uint8)c;
+}
+
+static inline bool IsWordSeparator( char c )
+{
+	return c == TRIGRAM_START || c == '_' || c == '.' || c == ' ' || c == '+' || c == '-';
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Walk the window and command registries, rebuild if they changed
+//---------------------------------------------------------------------------------------//
+bool CDearImGuiCommandIndex::Update()
+{
+	VPROF_BUDGET( "CDearImGuiCommandIndex::Update", VPROF_BUDGETGROUP_IMGUI );
+
+	m_Sources.RemoveAll();
+
+	CUtlVector<IImguiWindow *> windows;
+	g_pImguiSystem->GetAllWindows( windows );
+	FOR_EACH_VEC( windows, i )
+	{
+		Source_t &source = m_Sources[m_Sources.AddToTail()];
+		source.pszName = windows[i]->GetName();
+		source.nType = ENTRY_WINDOW;
+		source.pObject = windows[i];
+	}
+
+	ICvar::Iterator iter( g_pCVar );
+	for ( iter.SetFirst(); iter.IsValid(); iter.Next() )
+	{
+		ConCommandBase *pCommand = iter.Get();
+		if ( pCommand->IsFlagSet( FCVAR_HIDDEN | FCVAR_DEVELOPMENTONLY ) )
+			continue;
+
+		Source_t &source = m_Sources[m_Sources.AddToTail()];
+		source.pszName = pCommand->GetName();
+		source.nType = pCommand->IsCommand() ? ENTRY_CONCOMMAND : ENTRY_CONVAR;
+		source.pObject = pCommand;
+	}
+
+	// Registering or unloading anything changes the set of pointers
+	uintp nSignature = 0;
+	FOR_EACH_VEC( m_Sources, i )
+		nSignature = nSignature * 31 + reinterpret_cast<uintp>( m_Sources[i].pObject );
+
+	if ( nSignature == m_nSignature && m_Sources.Count() == m_nSourceCount )
+		return false;
+
+	m_nSignature = nSignature;
+	m_nSourceCount = m_Sources.Count();
+	Build();
+	return true;
+}
+
+static int SortTrigrams( const uint64 *a, const uint64 *b )
+{
+	if ( *a == *b )
+		return 0;
+	return *a < *b ? -1 : 1;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Copy the names, sort them and build the trigram posting lists
+//---------------------------------------------------------------------------------------//
+void CDearImGuiCommandIndex::Build()
+{
+	VPROF_BUDGET( "CDearImGuiCommandIndex::Build", VPROF_BUDGETGROUP_IMGUI );
+
+	// Names can go away with the DLL that registered them, so keep copies
+	int nNameBytes = 0;
+	FOR_EACH_VEC( m_Sources, i )
+		nNameBytes += 2 * ( V_strlen( m_Sources[i].pszName ) + 1 );
+
+	m_Names.SetCount( nNameBytes );
+	m_Entries.SetCount( m_Sources.Count() );
+
+	char *pNames = m_Names.Base();
+	FOR_EACH_VEC( m_Sources, i )
+	{
+		const int nLength = V_strlen( m_Sources[i].pszName );
+
+		Entry_t &entry = m_Entries[i];
+		entry.pszLower = pNames;
+		V_memcpy( pNames, m_Sources[i].pszName, nLength + 1 );
+		V_strlower( pNames );
+		pNames += nLength + 1;
+
+		entry.pszName = pNames;
+		V_memcpy( pNames, m_Sources[i].pszName, nLength + 1 );
+		pNames += nLength + 1;
+
+		entry.nLength = nLength;
+		entry.nType = m_Sources[i].nType;
+		entry.pObject = m_Sources[i].pObject;
+	}
+
+	m_Entries.Sort( []( const Entry_t *a, const Entry_t *b )
+		{
+			return V_strcmp( a->pszLower, b->pszLower );
+		} );
+
+	// Every trigram of "^name" paired with its entry, as key << 32 | entry
+	CUtlVector<uint64> pairs;
+	FOR_EACH_VEC( m_Entries, i )
+	{
+		const Entry_t &entry = m_Entries[i];
+		char prev2 = TRIGRAM_START, prev1 = entry.pszLower[0];
+		for ( int c = 1; c < entry.nLength; c++ )
+		{
+			const char cur = entry.pszLower[c];
+			pairs.AddToTail( ( (uint64)MakeTrigram( prev2, prev1, cur ) << 32 ) | (uint32)i );
+			prev2 = prev1;
+			prev1 = cur;
+		}
+	}
+
+	pairs.Sort( SortTrigrams );
+
+	m_TrigramKeys.RemoveAll();
+	m_TrigramStarts.RemoveAll();
+	m_Postings.RemoveAll();
+	m_Postings.EnsureCapacity( pairs.Count() );
+
+	FOR_EACH_VEC( pairs, i )
+	{
+		// The same trigram can show up more than once in a name
+		if ( i > 0 && pairs[i] == pairs[i - 1] )
+			continue;
+
+		const uint32 nKey = (uint32)( pairs[i] >> 32 );
+		if ( !m_TrigramKeys.Count() || m_TrigramKeys.Tail() != nKey )
+		{
+			m_TrigramKeys.AddToTail( nKey );
+			m_TrigramStarts.AddToTail( m_Postings.Count() );
+		}
+
+		m_Postings.AddToTail( (int)( pairs[i] & 0xFFFFFFFF ) );
+	}
+	m_TrigramStarts.AddToTail( m_Postings.Count() );
+
+	m_Hits.SetCount( m_Entries.Count() );
+	if ( m_Hits.Count() )
+		V_memset( m_Hits.Base(), 0, m_Hits.Count() * sizeof( uint16 ) );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Index of a trigram's posting list, or -1
+//---------------------------------------------------------------------------------------//
+int CDearImGuiCommandIndex::FindTrigram( uint32 nKey ) const
+{
+	int nLow = 0, nHigh = m_TrigramKeys.Count() - 1;
+	while ( nLow <= nHigh )
+	{
+		const int nMid = ( nLow + nHigh ) / 2;
+		if ( m_TrigramKeys[nMid] == nKey )
+			return nMid;
+
+		if ( m_TrigramKeys[nMid] < nKey )
+			nLow = nMid + 1;
+		else
+			nHigh = nMid - 1;
+	}
+
+	return -1;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Ranks a candidate, -1 if it doesn't match at all. Exact matches beat
+//  prefixes, which beat word starts, substrings, abbreviations ("svch" for sv_cheats)
+//  and finally names sharing enough trigrams to be a typo away. Shorter names and
+//  earlier matches win within each group.
+//---------------------------------------------------------------------------------------//
+int CDearImGuiCommandIndex::Score( const Entry_t &entry, const char *pszQuery, int nLength, int nHits, int nTrigrams ) const
+{
+	const char *pszName = entry.pszLower;
+	const char *pszFound = V_strstr( pszName, pszQuery );
+
+	if ( pszFound == pszName )
+		return ( entry.nLength == nLength ? 600000 : 500000 ) - entry.nLength;
+
+	if ( pszFound )
+	{
+		const int nOffset = pszFound - pszName;
+		return ( IsWordSeparator( pszFound[-1] ) ? 400000 : 300000 ) - nOffset * 64 - entry.nLength;
+	}
+
+	// Abbreviation, every query character in order. Gaps cost less when the next match
+	// starts a word.
+	int nPenalty = 0;
+	const char *pszQ = pszQuery;
+	for ( const char *pszC = pszName; *pszC && *pszQ; pszC++ )
+	{
+		if ( *pszC == *pszQ )
+		{
+			pszQ++;
+			continue;
+		}
+
+		if ( pszQ != pszQuery )
+			nPenalty += IsWordSeparator( *pszC ) ? 8 : 32;
+	}
+
+	if ( !*pszQ )
+		return 200000 - nPenalty * 16 - entry.nLength;
+
+	if ( nTrigrams > 0 && nHits * 2 >= nTrigrams )
+		return 100000 + ( nHits * 10000 ) / nTrigrams - entry.nLength;
+
+	return -1;
+}
+
+static int SortResults( const CDearImGuiCommandIndex::Result_t *a, const CDearImGuiCommandIndex::Result_t *b )
+{
+	if ( a->nScore != b->nScore )
+		return a->nScore > b->nScore ? -1 : 1;
+
+	// Entries are alphabetical
+	return a->nEntry - b->nEntry;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Candidates are the names sharing trigrams with the query (word starts for
+//  two character queries), plus the names starting with its first character for
+//  prefixes and abbreviations. Only those get scored.
+//---------------------------------------------------------------------------------------//
+int CDearImGuiCommandIndex::Query( const char *pszQuery, int nTypes, Result_t *pResults, int nMaxResults )
+{
+	VPROF_BUDGET( "CDearImGuiCommandIndex::Query", VPROF_BUDGETGROUP_IMGUI );
+
+	while ( *pszQuery == ' ' )
+		pszQuery++;
+
+	char szQuery[128];
+	V_strncpy( szQuery, pszQuery, sizeof( szQuery ) );
+	V_strlower( szQuery );
+
+	int nLength = V_strlen( szQuery );
+	while ( nLength > 0 && szQuery[nLength - 1] == ' ' )
+		szQuery[--nLength] = '\0';
+
+	if ( !nLength )
+	{
+		int nCount = 0;
+		for ( int i = 0; i < m_Entries.Count() && nCount < nMaxResults; i++ )
+		{
+			if ( !( m_Entries[i].nType & nTypes ) )
+				continue;
+
+			pResults[nCount].nEntry = i;
+			pResults[nCount].nScore = 0;
+			nCount++;
+		}
+		return nCount;
+	}
+
+	// Count how many of the query's trigrams each name has
+	int nTrigrams = 0;
+	if ( nLength >= 3 )
+	{
+		nTrigrams = nLength - 2;
+		for ( int c = 0; c < nTrigrams; c++ )
+		{
+			const int nKey = FindTrigram( MakeTrigram( szQuery[c], szQuery[c + 1], szQuery[c + 2] ) );
+			if ( nKey < 0 )
+				continue;
+
+			for ( int p = m_TrigramStarts[nKey]; p < m_TrigramStarts[nKey + 1]; p++ )
+			{
+				const int nEntry = m_Postings[p];
+				if ( m_Hits[nEntry]++ == 0 )
+					m_Touched.AddToTail( nEntry );
+			}
+		}
+	}
+	else if ( nLength == 2 )
+	{
+		static const char s_Separators[] = { TRIGRAM_START, '_', '.', ' ', '+', '-' };
+		for ( int s = 0; s < ARRAYSIZE( s_Separators ); s++ )
+		{
+			const int nKey = FindTrigram( MakeTrigram( s_Separators[s], szQuery[0], szQuery[1] ) );
+			if ( nKey < 0 )
+				continue;
+
+			for ( int p = m_TrigramStarts[nKey]; p < m_TrigramStarts[nKey + 1]; p++ )
+			{
+				const int nEntry = m_Postings[p];
+				if ( m_Hits[nEntry]++ == 0 )
+					m_Touched.AddToTail( nEntry );
+			}
+		}
+	}
+
+	m_Scored.RemoveAll();
+	FOR_EACH_VEC( m_Touched, i )
+	{
+		const int nEntry = m_Touched[i];
+		const Entry_t &entry = m_Entries[nEntry];
+		if ( entry.nType & nTypes )
+		{
+			const int nScore = Score( entry, szQuery, nLength, m_Hits[nEntry], nTrigrams );
+			if ( nScore >= 0 )
+			{
+				Result_t &result = m_Scored[m_Scored.AddToTail()];
+				result.nEntry = nEntry;
+				result.nScore = nScore;
+			}
+		}
+	}
+
+	// Names starting with the same character, found by binary search since entries are sorted
+	int nLow = 0, nHigh = m_Entries.Count();
+	while ( nLow < nHigh )
+	{
+		const int nMid = ( nLow + nHigh ) / 2;
+		if ( (uint8)m_Entries[nMid].pszLower[0] < (uint8)szQuery[0] )
+			nLow = nMid + 1;
+		else
+			nHigh = nMid;
+	}
+
+	for ( int i = nLow; i < m_Entries.Count() && m_Entries[i].pszLower[0] == szQuery[0]; i++ )
+	{
+		const Entry_t &entry = m_Entries[i];
+		if ( m_Hits[i] || !( entry.nType & nTypes ) )
+			continue;
+
+		const int nScore = Score( entry, szQuery, nLength, 0, nTrigrams );
+		if ( nScore >= 0 )
+		{
+			Result_t &result = m_Scored[m_Scored.AddToTail()];
+			result.nEntry = i;
+			result.nScore = nScore;
+		}
+	}
+
+	FOR_EACH_VEC( m_Touched, i )
+		m_Hits[m_Touched[i]] = 0;
+	m_Touched.RemoveAll();
+
+	m_Scored.Sort( SortResults );
+
+	const int nCount = MIN( nMaxResults, m_Scored.Count() );
+	if ( nCount )
+		V_memcpy( pResults, m_Scored.Base(), nCount * sizeof( Result_t ) );
+	return nCount;
+}
+
+IImguiWindow *CDearImGuiCommandIndex::GetWindow( int nEntry ) const
+{
+	return m_Entries[nEntry].nType == ENTRY_WINDOW ? static_cast<IImguiWindow *>( m_Entries[nEntry].pObject ) : nullptr;
+}
+
+ConCommandBase *CDearImGuiCommandIndex::GetCommand( int nEntry ) const
+{
+	return m_Entries[nEntry].nType != ENTRY_WINDOW ? static_cast<ConCommandBase *>( m_Entries[nEntry].pObject ) : nullptr;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Palette
+//---------------------------------------------------------------------------------------//
+void CDearImGuiCommandPalette::Open()
+{
+	m_bOpen = true;
+	m_bFocusInput = true;
+	m_szQuery[0] = '\0';
+
+	m_Index.Update();
+	Search();
+}
+
+void CDearImGuiCommandPalette::Search()
+{
+	// Anything after the first space is arguments
+	char szName[sizeof( m_szQuery )];
+	V_strncpy( szName, m_szQuery, sizeof( szName ) );
+	char *pszName = szName;
+	while ( *pszName == ' ' )
+		pszName++;
+	if ( char *pszSpace = V_strstr( pszName, " " ) )
+		*pszSpace = '\0';
+
+	CFastTimer timer;
+	timer.Start();
+	m_nResults = m_Index.Query( pszName, CDearImGuiCommandIndex::ENTRY_ALL, m_Results, ARRAYSIZE( m_Results ) );
+	timer.End();
+
+	m_flSearchTime = timer.GetDuration().GetMillisecondsF();
+	m_nSelected = 0;
+	m_bScrollToSelected = true;
+}
+
+void CDearImGuiCommandPalette::Execute( int nResult )
+{
+	const int nEntry = m_Results[nResult].nEntry;
+	const char *pszName = m_Index.GetName( nEntry );
+
+	switch ( m_Index.GetType( nEntry ) )
+	{
+	case CDearImGuiCommandIndex::ENTRY_WINDOW:
+	{
+		IImguiWindow *pWindow = m_Index.GetWindow( nEntry );
+		pWindow->SetDraw( true );
+		ImGui::SetWindowFocus( pWindow->GetWindowTitle() );
+		Close();
+		break;
+	}
+
+	case CDearImGuiCommandIndex::ENTRY_CONVAR:
+	{
+		// Leave it in the box for a value to be typed after it. The input box isn't active
+		// after enter or a click, so it picks the new text up when it's focused again.
+		V_snprintf( m_szQuery, sizeof( m_szQuery ), "%s ", pszName );
+		m_bFocusInput = true;
+		Search();
+		break;
+	}
+
+	case CDearImGuiCommandIndex::ENTRY_CONCOMMAND:
+		engine->ClientCmd_Unrestricted( pszName );
+		Close();
+		break;
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Tab fills in the selected name
+//---------------------------------------------------------------------------------------//
+int CDearImGuiCommandPalette::InputCallback( ImGuiInputTextCallbackData *data )
+{
+	CDearImGuiCommandPalette *pPalette = static_cast<CDearImGuiCommandPalette *>( data->UserData );
+	if ( pPalette->m_nSelected >= pPalette->m_nResults )
+		return 0;
+
+	data->DeleteChars( 0, data->BufTextLen );
+	data->InsertChars( 0, pPalette->m_Index.GetName( pPalette->m_Results[pPalette->m_nSelected].nEntry ) );
+	data->InsertChars( data->BufTextLen, " " );
+	return 0;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Draw the palette. Typing searches, up/down select, enter runs the selection
+//  (or the whole line once it has arguments), tab fills in the selected name.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiCommandPalette::Draw()
+{
+	// Something was registered or unloaded, the old results point at the wrong entries
+	if ( m_Index.Update() )
+		Search();
+
+	const ImVec2 &displaySize = ImGui::GetIO().DisplaySize;
+	const float flWidth = MIN( 640.0f, displaySize.x * 0.8f );
+	ImGui::SetNextWindowPos( ImVec2( displaySize.x * 0.5f, displaySize.y * 0.15f ), ImGuiCond_Always, ImVec2( 0.5f, 0.0f ) );
+	ImGui::SetNextWindowSize( ImVec2( flWidth, 0.0f ) );
+	if ( m_bFocusInput )
+		ImGui::SetNextWindowFocus();
+
+	const ImGuiWindowFlags flags = ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove |
+								   ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_AlwaysAutoResize;
+	if ( !ImGui::Begin( "Command Palette", &m_bOpen, flags ) )
+	{
+		ImGui::End();
+		return;
+	}
+
+	if ( m_bFocusInput )
+	{
+		ImGui::SetKeyboardFocusHere();
+		m_bFocusInput = false;
+	}
+
+	ImGui::SetNextItemWidth( -FLT_MIN );
+	if ( ImGui::InputTextWithHint( "##query", "Search windows, convars and commands", m_szQuery, sizeof( m_szQuery ), ImGuiInputTextFlags_CallbackCompletion, InputCallback, this ) )
+		Search();
+
+	int nExecute = -1;
+	if ( ImGui::IsItemActive() || ImGui::IsItemDeactivated() )
+	{
+		if ( ImGui::IsKeyPressed( ImGuiKey_Escape ) )
+			Close();
+
+		if ( ImGui::IsKeyPressed( ImGuiKey_DownArrow ) && m_nSelected + 1 < m_nResults )
+		{
+			m_nSelected++;
+			m_bScrollToSelected = true;
+		}
+
+		if ( ImGui::IsKeyPressed( ImGuiKey_UpArrow ) && m_nSelected > 0 )
+		{
+			m_nSelected--;
+			m_bScrollToSelected = true;
+		}
+
+		if ( ImGui::IsKeyPressed( ImGuiKey_Enter ) || ImGui::IsKeyPressed( ImGuiKey_KeypadEnter ) )
+		{
+			const char *pszLine = m_szQuery;
+			while ( *pszLine == ' ' )
+				pszLine++;
+
+			const char *pszSpace = V_strstr( pszLine, " " );
+			if ( pszSpace && pszSpace[1] )
+			{
+				engine->ClientCmd_Unrestricted( pszLine );
+				Close();
+			}
+			else if ( m_nSelected < m_nResults )
+			{
+				nExecute = m_nSelected;
+			}
+		}
+	}
+
+	const float flRowHeight = ImGui::GetTextLineHeightWithSpacing();
+	if ( m_nResults )
+	{
+		ImGui::BeginChild( "##results", ImVec2( 0.0f, flRowHeight * MIN( m_nResults, 12 ) + ImGui::GetStyle().WindowPadding.y ) );
+		const float flColumn = ImGui::GetContentRegionAvail().x * 0.5f;
+
+		ImGuiListClipper clipper;
+		clipper.Begin( m_nResults );
+		if ( m_bScrollToSelected )
+			clipper.IncludeItemByIndex( m_nSelected );
+
+		while ( clipper.Step() )
+		{
+			for ( int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++ )
+			{
+				const int nEntry = m_Results[i].nEntry;
+				ImGui::PushID( i );
+
+				if ( ImGui::Selectable( m_Index.GetName( nEntry ), i == m_nSelected, ImGuiSelectableFlags_AllowOverlap ) )
+					nExecute = i;
+
+				if ( i == m_nSelected && m_bScrollToSelected )
+				{
+					ImGui::SetScrollHereY();
+					m_bScrollToSelected = false;
+				}
+
+				ConCommandBase *pCommand = m_Index.GetCommand( nEntry );
+				if ( pCommand && pCommand->GetHelpText() && pCommand->GetHelpText()[0] )
+					ImGui::SetItemTooltip( "%s", pCommand->GetHelpText() );
+
+				ImGui::SameLine( flColumn );
+				switch ( m_Index.GetType( nEntry ) )
+				{
+				case CDearImGuiCommandIndex::ENTRY_WINDOW:
+					ImGui::TextDisabled( "window  %s", m_Index.GetWindow( nEntry )->ShouldDraw() ? "(open)" : "" );
+					break;
+				case CDearImGuiCommandIndex::ENTRY_CONVAR:
+					ImGui::TextDisabled( "convar  %s", static_cast<ConVar *>( pCommand )->GetString() );
+					break;
+				case CDearImGuiCommandIndex::ENTRY_CONCOMMAND:
+					ImGui::TextDisabled( "command" );
+					break;
+				}
+
+				ImGui::PopID();
+			}
+		}
+
+		ImGui::EndChild();
+	}
+
+	ImGui::TextDisabled( "%d of %d in %.3f ms", m_nResults, m_Index.Count(), m_flSearchTime );
+
+	if ( nExecute >= 0 )
+		Execute( nExecute );
+
+	ImGui::End();
+}
@@ -0,0 +1,150 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#pragma once
+
+#include "utlvector.h"
+
+class ConCommandBase;
+class IImguiWindow;
+struct ImGuiInputTextCallbackData;
+
+// Most results the palette lists for a query
+#define IMGUI_PALETTE_MAX_RESULTS	128
+
+//--------------------------------------------------------------------------------//
+// Purpose: Search index over registered windows, convars and concommands. Names are
+//  kept sorted for prefix lookups and have a trigram posting list each, so a query
+//  only scores the names that could match it instead of scanning all of them.
+//--------------------------------------------------------------------------------//
+class CDearImGuiCommandIndex
+{
+public:
+	enum EntryType_t
+	{
+		ENTRY_WINDOW		= 1 << 0,
+		ENTRY_CONVAR		= 1 << 1,
+		ENTRY_CONCOMMAND	= 1 << 2,
+
+		ENTRY_ALL			= ENTRY_WINDOW | ENTRY_CONVAR | ENTRY_CONCOMMAND,
+	};
+
+	struct Result_t
+	{
+		int nEntry;
+		int nScore;
+	};
+
+	// Rebuilds the index if windows or commands were registered or removed since it was
+	// last built. Only walks the registries when nothing changed, call it before querying.
+	// Returns true if the index was rebuilt.
+	bool Update();
+
+	// Fills pResults with up to nMaxResults matches for pszQuery, best first. An empty query
+	// lists everything of the requested types alphabetically.
+	int Query( const char *pszQuery, int nTypes, Result_t *pResults, int nMaxResults );
+
+	int Count() const { return m_Entries.Count(); }
+	int GetType( int nEntry ) const { return m_Entries[nEntry].nType; }
+	const char *GetName( int nEntry ) const { return m_Entries[nEntry].pszName; }
+
+	// Only valid until the next Update()
+	IImguiWindow *GetWindow( int nEntry ) const;
+	ConCommandBase *GetCommand( int nEntry ) const;
+
+private:
+	struct Entry_t
+	{
+		const char *pszName;
+		const char *pszLower;
+		int nLength;
+		int nType;
+		void *pObject;		// IImguiWindow or ConCommandBase, depending on nType
+	};
+
+	struct Source_t
+	{
+		const char *pszName;
+		int nType;
+		void *pObject;
+	};
+
+	void Build();
+	int FindTrigram( uint32 nKey ) const;
+	int Score( const Entry_t &entry, const char *pszQuery, int nLength, int nHits, int nTrigrams ) const;
+
+	CUtlVector<Entry_t> m_Entries;		// Sorted by lowercase name
+	CUtlVector<char> m_Names;			// Names, then their lowercase copies
+
+	// m_Postings[m_TrigramStarts[i]..m_TrigramStarts[i + 1]) are the entries containing
+	// m_TrigramKeys[i], keys are sorted
+	CUtlVector<uint32> m_TrigramKeys;
+	CUtlVector<int> m_TrigramStarts;
+	CUtlVector<int> m_Postings;
+
+	// What the registries held the last time Update() walked them
+	CUtlVector<Source_t> m_Sources;
+
+	// Query scratch, m_Hits has a counter per entry and is zeroed again after each query
+	CUtlVector<uint16> m_Hits;
+	CUtlVector<int> m_Touched;
+	CUtlVector<Result_t> m_Scored;
+
+	// Identifies what the index was built from
+	uintp m_nSignature = 0;
+	int m_nSourceCount = -1;
+};
+
+//--------------------------------------------------------------------------------//
+// Purpose: Search box over the command index. Opens windows, runs commands and
+//  fills in convars so a value can be typed after them.
+//--------------------------------------------------------------------------------//
+class CDearImGuiCommandPalette
+{
+public:
+	void Open();
+	void Close() { m_bOpen = false; }
+	bool IsOpen() const { return m_bOpen; }
+
+	// Main thread only, between NewFrame and Render
+	void Draw();
+
+	CDearImGuiCommandIndex &GetIndex() { return m_Index; }
+
+private:
+	void Search();
+	void Execute( int nResult );
+	static int InputCallback( ImGuiInputTextCallbackData *data );
+
+	CDearImGuiCommandIndex m_Index;
+	CDearImGuiCommandIndex::Result_t m_Results[IMGUI_PALETTE_MAX_RESULTS];
+	int m_nResults = 0;
+	int m_nSelected = 0;
+	float m_flSearchTime = 0.0f;
+	char m_szQuery[256] = {};
+	bool m_bOpen = false;
+	bool m_bFocusInput = false;
+	bool m_bScrollToSelected = false;
+};
+
+extern CDearImGuiCommandPalette g_ImGuiCommandPalette;
@@ -0,0 +1,166 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#pragma once
+
+#include "imgui_system.h"
+#include "imgui_window.h"
+#include "tier0/threadtools.h"
+
+//--------------------------------------------------------------------------------//
+// Purpose: Gathers data for a window away from its Draw(). The system runs each
+//  provider at its own rate on the thread pool while its window is shown, Draw() only
+//  reads the latest published snapshot. Use CImguiDataProvider below.
+//--------------------------------------------------------------------------------//
+class IImguiDataProvider
+{
+public:
+	// Rate in Hz the system runs the provider at, 0 runs it every frame
+	IImguiDataProvider( IImguiWindow *pOwner, float flRate ) :
+		m_pOwner( pOwner ),
+		m_flRate( flRate )
+	{
+	}
+
+	// Run() may still be going on a worker until the provider is unregistered, which has to
+	// happen before anything it uses is destroyed. The system unregisters providers whose
+	// window is hidden or unloaded; one destroyed while its window is shown must call
+	// Unregister() itself, see below.
+	virtual ~IImguiDataProvider()
+	{
+		Assert( !m_bRegistered );
+	}
+
+	// Called by the system, on a thread pool worker unless GatherOnMainThread() is true
+	virtual void Run() = 0;
+
+	// Most engine state (entities, the client's network state) is only safe to read on the
+	// main thread. Providers reading it still run at their own rate, just not in parallel.
+	virtual bool GatherOnMainThread() const { return false; }
+
+	// Providers only run while this is true, by default while the owning window is shown
+	virtual bool IsActive() const { return !m_pOwner || m_pOwner->ShouldDraw(); }
+
+	IImguiWindow *GetOwner() const { return m_pOwner; }
+	float GetUpdateRate() const { return m_flRate; }
+	void SetUpdateRate( float flRate ) { m_flRate = flRate; }
+
+	// Drops a queued Run() that hasn't started, waits for a running one and stops the system
+	// from running the provider again. Call it from the destructor of the most derived
+	// class, before its members are destroyed. GetSnapshot() registers it again.
+	void Unregister()
+	{
+		if ( m_bRegistered )
+			g_pImguiSystem->UnregisterDataProvider( this );
+	}
+
+	// Used by the system
+	bool IsRegistered() const { return m_bRegistered; }
+	void SetRegistered( bool bRegistered ) { m_bRegistered = bRegistered; }
+
+protected:
+	void EnsureRegistered()
+	{
+		if ( !m_bRegistered )
+			g_pImguiSystem->RegisterDataProvider( this );
+	}
+
+	IImguiWindow *m_pOwner;
+	float m_flRate;
+	bool m_bRegistered = false;
+};
+
+//--------------------------------------------------------------------------------//
+// Purpose: Triple buffered snapshots of T. The writer always has a buffer of its own
+//  and the reader keeps the one it's looking at, so neither waits on the other.
+//
+//	class CEntityListProvider : public CImguiDataProvider<CUtlVector<EntityRow_t>>
+//	{
+//		~CEntityListProvider() { Unregister(); }
+//		bool Gather( CUtlVector<EntityRow_t> &rows ) override;
+//	};
+//
+// By the time the destructor here runs, Gather() is gone. It asserts that nothing is
+// running, then unregisters so the base class' check holds.
+//
+//	// In Draw()
+//	if ( const CUtlVector<EntityRow_t> *pRows = m_Provider.GetSnapshot() )
+//		...
+//--------------------------------------------------------------------------------//
+template <class T>
+class CImguiDataProvider : public IImguiDataProvider
+{
+public:
+	CImguiDataProvider( IImguiWindow *pOwner, float flRate ) : IImguiDataProvider( pOwner, flRate ) {}
+
+	~CImguiDataProvider()
+	{
+		AssertMsg( !m_bRunning, "Data provider destroyed while Gather() runs, call Unregister() from the most derived destructor" );
+		Unregister();
+	}
+
+	// Fill snapshot with current data. It still holds data from an earlier update, so its
+	// allocations can be reused. Return false to keep publishing the previous snapshot.
+	virtual bool Gather( T &snapshot ) = 0;
+
+	// Latest published snapshot, or null until the first one is ready. Main thread only,
+	// the pointer stays valid until the next call.
+	const T *GetSnapshot()
+	{
+		EnsureRegistered();
+
+		if ( m_nShared & SNAPSHOT_FRESH )
+		{
+			m_nFront = ThreadInterlockedExchange( &m_nShared, m_nFront ) & SNAPSHOT_INDEX;
+			m_bHaveSnapshot = true;
+		}
+
+		return m_bHaveSnapshot ? &m_Buffers[m_nFront] : nullptr;
+	}
+
+	void Run() override
+	{
+		m_bRunning = true;
+		const bool bGathered = Gather( m_Buffers[m_nBack] );
+		m_bRunning = false;
+		if ( !bGathered )
+			return;
+
+		// Publish, and take whichever buffer was waiting in the middle to write into next
+		m_nBack = ThreadInterlockedExchange( &m_nShared, m_nBack | SNAPSHOT_FRESH ) & SNAPSHOT_INDEX;
+	}
+
+private:
+	enum
+	{
+		SNAPSHOT_INDEX = 0x3,
+		SNAPSHOT_FRESH = 0x4,	// Set when the middle buffer holds a snapshot the reader hasn't seen
+	};
+
+	T m_Buffers[3];
+	int m_nFront = 0;			// Reader's
+	volatile int32 m_nShared = 1;	// Middle buffer's index and SNAPSHOT_FRESH
+	int m_nBack = 2;			// Writer's
+	bool m_bHaveSnapshot = false;
+	volatile bool m_bRunning = false;
+};
@@ -0,0 +1,133 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#include "imgui_debugdraw.h"
+
+#include "convar.h"
+#include "tier0/vprof.h"
+#include "imgui/imgui.h"
+
+#include "tier0/memdbgon.h"
+
+static ConVar imgui_debugdraw_max( "imgui_debugdraw_max", "16384", FCVAR_NONE, "Most debug draw commands queued, and most timed ones kept alive, at once. More are dropped." );
+
+CDearImGuiDebugDraw g_ImGuiDebugDraw;
+
+bool CDearImGuiDebugDraw::Add( const DebugDrawCmd_t &cmd )
+{
+	// Reserve a slot first so producers can't overshoot the cap together
+	if ( ++m_nQueued > imgui_debugdraw_max.GetInt() )
+	{
+		--m_nQueued;
+		++m_nDropped;
+		return false;
+	}
+
+	m_Queue.PushItem( cmd );
+	return true;
+}
+
+bool CDearImGuiDebugDraw::HasWork() const
+{
+	return m_nQueued > 0 || m_Active.Count() > 0;
+}
+
+static void DrawCommand( ImDrawList *pDrawList, const CDearImGuiDebugDraw::DebugDrawCmd_t &cmd )
+{
+	const ImU32 col = IM_COL32( cmd.color.r(), cmd.color.g(), cmd.color.b(), cmd.color.a() );
+	const bool bFilled = ( cmd.nFlags & IMGUI_DEBUGDRAW_FILLED ) != 0;
+
+	switch ( cmd.nType )
+	{
+	case CDearImGuiDebugDraw::DEBUGDRAW_LINE:
+		pDrawList->AddLine( ImVec2( cmd.x1, cmd.y1 ), ImVec2( cmd.x2, cmd.y2 ), col );
+		break;
+	case CDearImGuiDebugDraw::DEBUGDRAW_RECT:
+		if ( bFilled )
+			pDrawList->AddRectFilled( ImVec2( cmd.x1, cmd.y1 ), ImVec2( cmd.x2, cmd.y2 ), col );
+		else
+			pDrawList->AddRect( ImVec2( cmd.x1, cmd.y1 ), ImVec2( cmd.x2, cmd.y2 ), col );
+		break;
+	case CDearImGuiDebugDraw::DEBUGDRAW_CIRCLE:
+		if ( bFilled )
+			pDrawList->AddCircleFilled( ImVec2( cmd.x1, cmd.y1 ), cmd.x2, col );
+		else
+			pDrawList->AddCircle( ImVec2( cmd.x1, cmd.y1 ), cmd.x2, col );
+		break;
+	case CDearImGuiDebugDraw::DEBUGDRAW_TEXT:
+		pDrawList->AddText( ImVec2( cmd.x1, cmd.y1 ), col, cmd.szText );
+		break;
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Drain the queue and draw everything that hasn't expired yet
+//---------------------------------------------------------------------------------------//
+void CDearImGuiDebugDraw::Flush( ImDrawList *pBackground, ImDrawList *pForeground )
+{
+	VPROF_BUDGET( "CDearImGuiDebugDraw::Flush", VPROF_BUDGETGROUP_IMGUI );
+
+	const double flNow = Plat_FloatTime();
+
+	// Timed commands from earlier frames
+	for ( int i = m_Active.Count() - 1; i >= 0; i-- )
+	{
+		if ( m_Active[i].flExpireTime <= flNow )
+		{
+			m_Active.FastRemove( i );
+			continue;
+		}
+
+		DrawCommand( ( m_Active[i].nFlags & IMGUI_DEBUGDRAW_BACKGROUND ) ? pBackground : pForeground, m_Active[i] );
+	}
+
+	// Single frame commands are drawn straight from the queue, timed ones are kept
+	DebugDrawCmd_t cmd;
+	while ( m_Queue.PopItem( &cmd ) )
+	{
+		--m_nQueued;
+		DrawCommand( ( cmd.nFlags & IMGUI_DEBUGDRAW_BACKGROUND ) ? pBackground : pForeground, cmd );
+
+		if ( cmd.flDuration > 0.0f )
+		{
+			// Long durations submitted every frame would otherwise pile up here
+			if ( m_Active.Count() >= imgui_debugdraw_max.GetInt() )
+			{
+				++m_nDropped;
+				continue;
+			}
+
+			cmd.flExpireTime = flNow + cmd.flDuration;
+			m_Active.AddToTail( cmd );
+		}
+	}
+}
+
+void CDearImGuiDebugDraw::Clear()
+{
+	DebugDrawCmd_t cmd;
+	while ( m_Queue.PopItem( &cmd ) )
+		--m_nQueued;
+
+	m_Active.Purge();
+}
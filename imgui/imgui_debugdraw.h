@@ -0,0 +1,84 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#pragma once
+
+#include "imgui_system.h"
+#include "tier0/tslist.h"
+#include "utlvector.h"
+
+struct ImDrawList;
+
+// Longest string AddDebugText keeps, anything past it is cut off
+#define IMGUI_DEBUGDRAW_MAX_TEXT	96
+
+//--------------------------------------------------------------------------------//
+// Purpose: Debug shapes submitted from any thread. Producers push into a lock-free
+//  queue, the main thread drains it once per frame into the imgui draw lists.
+//--------------------------------------------------------------------------------//
+class CDearImGuiDebugDraw
+{
+public:
+	enum DebugDrawType_t
+	{
+		DEBUGDRAW_LINE,
+		DEBUGDRAW_RECT,
+		DEBUGDRAW_CIRCLE,
+		DEBUGDRAW_TEXT,
+	};
+
+	struct DebugDrawCmd_t
+	{
+		uint8 nType;
+		uint8 nFlags;
+		Color color;
+		float flDuration;
+		double flExpireTime;	// Set when the main thread first picks it up
+		float x1, y1, x2, y2;	// Circles store the radius in x2
+		char szText[IMGUI_DEBUGDRAW_MAX_TEXT];
+	};
+
+	// Thread safe. Returns false if the queue is full and the command was dropped.
+	bool Add( const DebugDrawCmd_t &cmd );
+
+	// Main thread only. True if there is anything queued or still alive.
+	bool HasWork() const;
+
+	// Main thread only, between NewFrame and Render. Draws everything queued or still alive
+	// and forgets expired commands.
+	void Flush( ImDrawList *pBackground, ImDrawList *pForeground );
+
+	void Clear();
+
+	int GetDroppedCount() const { return m_nDropped; }
+
+private:
+	CTSQueue<DebugDrawCmd_t> m_Queue;
+	CInterlockedInt m_nQueued;
+	CInterlockedInt m_nDropped;
+
+	// Timed commands carried over between frames
+	CUtlVector<DebugDrawCmd_t> m_Active;
+};
+
+extern CDearImGuiDebugDraw g_ImGuiDebugDraw;
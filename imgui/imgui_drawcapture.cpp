@@ -0,0 +1,160 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#include "imgui_drawcapture.h"
+
+#include "imgui/imgui_internal.h"
+
+#include "tier0/memdbgon.h"
+
+static bool ClipRectsEqual( const ImVec4 &a, const ImVec4 &b )
+{
+	return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+}
+
+void CImDrawListCapture::Begin( const ImDrawList *pDrawList )
+{
+	m_BaseClipRect = pDrawList->_CmdHeader.ClipRect;
+	m_nStartCmd = MAX( pDrawList->CmdBuffer.Size - 1, 0 );
+	m_nStartIndex = pDrawList->IdxBuffer.Size;
+}
+
+void CImDrawListCapture::End( const ImDrawList *pDrawList )
+{
+	m_Segments.RemoveAll();
+	m_Vertices.RemoveAll();
+	m_Indices.RemoveAll();
+	CopyRange( pDrawList, m_nStartCmd, m_nStartIndex );
+}
+
+void CImDrawListCapture::AddDrawList( const ImDrawList *pDrawList )
+{
+	CopyRange( pDrawList, 0, 0 );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Copy each command's share of the index range, along with the vertices it uses
+//---------------------------------------------------------------------------------------//
+void CImDrawListCapture::CopyRange( const ImDrawList *pDrawList, int nFirstCmd, int nFirstIndex )
+{
+	for ( int nCmd = nFirstCmd; nCmd < pDrawList->CmdBuffer.Size; nCmd++ )
+	{
+		const ImDrawCmd &cmd = pDrawList->CmdBuffer[nCmd];
+		if ( cmd.UserCallback || !cmd.ElemCount )
+			continue;
+
+		const int nStart = MAX( (int)cmd.IdxOffset, nFirstIndex );
+		const int nEnd = cmd.IdxOffset + cmd.ElemCount;
+		if ( nStart >= nEnd )
+			continue;
+
+		const ImDrawIdx *pIdx = pDrawList->IdxBuffer.Data + nStart;
+		const int nIndexCount = nEnd - nStart;
+
+		unsigned int nMinVertex = ~0u, nMaxVertex = 0;
+		for ( int i = 0; i < nIndexCount; i++ )
+		{
+			nMinVertex = MIN( nMinVertex, (unsigned int)pIdx[i] );
+			nMaxVertex = MAX( nMaxVertex, (unsigned int)pIdx[i] );
+		}
+
+		Segment_t &seg = m_Segments[m_Segments.AddToTail()];
+		seg.clipRect = cmd.ClipRect;
+		seg.texId = cmd.GetTexID();
+		seg.bBaseClip = ClipRectsEqual( cmd.ClipRect, m_BaseClipRect );
+		seg.nFirstVertex = m_Vertices.Count();
+		seg.nVertexCount = nMaxVertex - nMinVertex + 1;
+		seg.nFirstIndex = m_Indices.Count();
+		seg.nIndexCount = nIndexCount;
+
+		m_Vertices.AddMultipleToTail( seg.nVertexCount, pDrawList->VtxBuffer.Data + cmd.VtxOffset + nMinVertex );
+
+		ImDrawIdx *pDst = m_Indices.Base() + m_Indices.AddMultipleToTail( nIndexCount );
+		for ( int i = 0; i < nIndexCount; i++ )
+			pDst[i] = static_cast<ImDrawIdx>( pIdx[i] - nMinVertex );
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Append the captured segments as if they had just been drawn
+//---------------------------------------------------------------------------------------//
+void CImDrawListCapture::Replay( ImDrawList *pDrawList, const ImVec2 &vecOffset ) const
+{
+	const ImVec4 currentClip = pDrawList->_CmdHeader.ClipRect;
+
+	FOR_EACH_VEC( m_Segments, i )
+	{
+		const Segment_t &seg = m_Segments[i];
+
+		ImVec4 clip = currentClip;
+		if ( !seg.bBaseClip )
+		{
+			clip.x = MAX( seg.clipRect.x + vecOffset.x, currentClip.x );
+			clip.y = MAX( seg.clipRect.y + vecOffset.y, currentClip.y );
+			clip.z = MIN( seg.clipRect.z + vecOffset.x, currentClip.z );
+			clip.w = MIN( seg.clipRect.w + vecOffset.y, currentClip.w );
+			if ( clip.z <= clip.x || clip.w <= clip.y )
+				continue;
+		}
+
+		pDrawList->PushClipRect( ImVec2( clip.x, clip.y ), ImVec2( clip.z, clip.w ), false );
+		pDrawList->PushTextureID( seg.texId );
+		pDrawList->PrimReserve( seg.nIndexCount, seg.nVertexCount );
+
+		const ImDrawVert *pSrcVtx = m_Vertices.Base() + seg.nFirstVertex;
+		ImDrawVert *pDstVtx = pDrawList->_VtxWritePtr;
+		for ( int v = 0; v < seg.nVertexCount; v++ )
+		{
+			pDstVtx[v] = pSrcVtx[v];
+			pDstVtx[v].pos.x += vecOffset.x;
+			pDstVtx[v].pos.y += vecOffset.y;
+		}
+
+		const ImDrawIdx *pSrcIdx = m_Indices.Base() + seg.nFirstIndex;
+		ImDrawIdx *pDstIdx = pDrawList->_IdxWritePtr;
+		const unsigned int nBase = pDrawList->_VtxCurrentIdx;
+		for ( int n = 0; n < seg.nIndexCount; n++ )
+			pDstIdx[n] = static_cast<ImDrawIdx>( nBase + pSrcIdx[n] );
+
+		pDrawList->_VtxWritePtr += seg.nVertexCount;
+		pDrawList->_IdxWritePtr += seg.nIndexCount;
+		pDrawList->_VtxCurrentIdx += seg.nVertexCount;
+
+		pDrawList->PopTextureID();
+		pDrawList->PopClipRect();
+	}
+}
+
+void CImDrawListCapture::Purge()
+{
+	m_Segments.Purge();
+	m_Vertices.Purge();
+	m_Indices.Purge();
+}
+
+size_t CImDrawListCapture::GetRetainedBytes() const
+{
+	return m_Segments.NumAllocated() * sizeof( Segment_t ) +
+		m_Vertices.NumAllocated() * sizeof( ImDrawVert ) +
+		m_Indices.NumAllocated() * sizeof( ImDrawIdx );
+}
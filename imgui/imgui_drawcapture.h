@@ -0,0 +1,76 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#pragma once
+
+#include "imgui/imgui.h"
+#include "utlvector.h"
+
+//--------------------------------------------------------------------------------//
+// Purpose: Copy of part of one or more draw lists, which can be appended to a
+//  draw list in a later frame, moved by an offset, without re-tessellating it
+//--------------------------------------------------------------------------------//
+class CImDrawListCapture
+{
+public:
+	// Starts a capture of everything added to pDrawList from this point on
+	void Begin( const ImDrawList *pDrawList );
+
+	// Copies everything added to pDrawList since Begin, replacing any previous capture
+	void End( const ImDrawList *pDrawList );
+
+	// Appends the whole of pDrawList to the capture, used for child windows
+	void AddDrawList( const ImDrawList *pDrawList );
+
+	// Appends the captured geometry to pDrawList, moved by vecOffset. Geometry that was
+	// clipped by the clip rect active at Begin uses the current clip rect instead.
+	void Replay( ImDrawList *pDrawList, const ImVec2 &vecOffset ) const;
+
+	void Purge();
+	bool IsEmpty() const { return m_Segments.IsEmpty(); }
+
+	// Memory held on to by this capture
+	size_t GetRetainedBytes() const;
+
+private:
+	void CopyRange( const ImDrawList *pDrawList, int nFirstCmd, int nFirstIndex );
+
+	struct Segment_t
+	{
+		ImVec4 clipRect;
+		ImTextureID texId;
+		bool bBaseClip;
+		int nFirstVertex;
+		int nVertexCount;
+		int nFirstIndex;
+		int nIndexCount;
+	};
+
+	CUtlVector<Segment_t> m_Segments;
+	CUtlVector<ImDrawVert> m_Vertices;
+	CUtlVector<ImDrawIdx> m_Indices;	// Relative to their segment's first vertex
+
+	ImVec4 m_BaseClipRect;
+	int m_nStartCmd = 0;
+	int m_nStartIndex = 0;
+};
@@ -0,0 +1,625 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#include "cbase.h"
+#include "imgui_window.h"
+
+#include "cliententitylist.h"
+#include "datamap.h"
+#include "dt_recv.h"
+#include "recvproxy.h"
+#include "utlmap.h"
+#include "imgui/imgui.h"
+
+#include "tier0/memdbgon.h"
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Flattened view of a RecvTable or prediction datamap. Built once per table and
+//  shared by every entity using it.
+//---------------------------------------------------------------------------------------//
+enum InspectorFieldType_t
+{
+	FIELD_TYPE_INT,
+	FIELD_TYPE_SHORT,
+	FIELD_TYPE_CHAR,
+	FIELD_TYPE_BOOL,
+	FIELD_TYPE_INT64,
+	FIELD_TYPE_FLOAT,
+	FIELD_TYPE_VECTOR,
+	FIELD_TYPE_VECTORXY,
+	FIELD_TYPE_STRING,
+	FIELD_TYPE_EHANDLE,
+};
+
+struct InspectorField_t
+{
+	int nName;			// Offset into the layout's names
+	int nOffset;		// From the start of the entity
+	int nSize;			// Bytes read, and hashed
+	int nType;
+};
+
+struct InspectorLayout_t
+{
+	CUtlVector<InspectorField_t> fields;
+	CUtlVector<char> names;
+
+	const char *GetName( int nField ) const { return &names[fields[nField].nName]; }
+
+	void AddField( const char *pszPath, const char *pszName, int nOffset, int nType, int nSize )
+	{
+		InspectorField_t &field = fields[fields.AddToTail()];
+		field.nName = names.Count();
+		field.nOffset = nOffset;
+		field.nSize = nSize;
+		field.nType = nType;
+
+		char szName[256];
+		if ( pszPath[0] )
+			V_snprintf( szName, sizeof( szName ), "%s.%s", pszPath, pszName );
+		else
+			V_strncpy( szName, pszName, sizeof( szName ) );
+		names.AddMultipleToTail( V_strlen( szName ) + 1, szName );
+	}
+};
+
+static int GetFieldTypeSize( int nType )
+{
+	switch ( nType )
+	{
+	case FIELD_TYPE_SHORT:		return sizeof( short );
+	case FIELD_TYPE_CHAR:		return sizeof( char );
+	case FIELD_TYPE_BOOL:		return sizeof( bool );
+	case FIELD_TYPE_INT64:		return sizeof( int64 );
+	case FIELD_TYPE_VECTOR:		return sizeof( Vector );
+	case FIELD_TYPE_VECTORXY:	return sizeof( float ) * 2;
+	default:					return sizeof( int );
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Networked fields. RecvProps don't know the size of the variable they write,
+//  the standard proxies give it away for the narrow ints.
+//---------------------------------------------------------------------------------------//
+static void FlattenRecvProp( InspectorLayout_t &layout, const char *pszPath, const RecvProp *pProp, int nBase, const char *pszName )
+{
+	const int nOffset = nBase + pProp->GetOffset();
+
+	switch ( pProp->GetType() )
+	{
+	case DPT_Int:
+	{
+		const RecvVarProxyFn proxy = pProp->GetProxyFn();
+		int nType = FIELD_TYPE_INT;
+		if ( proxy == RecvProxy_Int32ToInt8 )
+			nType = FIELD_TYPE_CHAR;
+		else if ( proxy == RecvProxy_Int32ToInt16 )
+			nType = FIELD_TYPE_SHORT;
+		else if ( proxy == RecvProxy_IntToEHandle )
+			nType = FIELD_TYPE_EHANDLE;
+		layout.AddField( pszPath, pszName, nOffset, nType, GetFieldTypeSize( nType ) );
+		break;
+	}
+	case DPT_Float:
+		layout.AddField( pszPath, pszName, nOffset, FIELD_TYPE_FLOAT, sizeof( float ) );
+		break;
+	case DPT_Vector:
+		layout.AddField( pszPath, pszName, nOffset, FIELD_TYPE_VECTOR, sizeof( Vector ) );
+		break;
+	case DPT_VectorXY:
+		layout.AddField( pszPath, pszName, nOffset, FIELD_TYPE_VECTORXY, sizeof( float ) * 2 );
+		break;
+	case DPT_String:
+		layout.AddField( pszPath, pszName, nOffset, FIELD_TYPE_STRING, pProp->m_StringBufferSize );
+		break;
+#ifdef SUPPORTS_INT64
+	case DPT_Int64:
+		layout.AddField( pszPath, pszName, nOffset, FIELD_TYPE_INT64, sizeof( int64 ) );
+		break;
+#endif
+	case DPT_Array:
+	{
+		const RecvProp *pElement = pProp->GetArrayProp();
+		for ( int i = 0; i < pProp->GetNumElements(); i++ )
+		{
+			char szElement[128];
+			V_snprintf( szElement, sizeof( szElement ), "%s[%d]", pszName, i );
+			FlattenRecvProp( layout, pszPath, pElement, nBase + i * pProp->GetElementStride(), szElement );
+		}
+		break;
+	}
+	case DPT_DataTable:
+	{
+		// Tables behind other proxies live somewhere else entirely, reading them at this
+		// offset would be reading garbage
+		if ( pProp->GetDataTableProxyFn() != DataTableRecvProxy_StaticDataTable )
+			break;
+
+		char szPath[256];
+		if ( !V_strcmp( pszName, "baseclass" ) )
+			V_strncpy( szPath, pszPath, sizeof( szPath ) );
+		else if ( pszPath[0] )
+			V_snprintf( szPath, sizeof( szPath ), "%s.%s", pszPath, pszName );
+		else
+			V_strncpy( szPath, pszName, sizeof( szPath ) );
+
+		const RecvTable *pTable = pProp->GetDataTable();
+		for ( int i = 0; i < pTable->GetNumProps(); i++ )
+		{
+			const RecvProp *pChild = pTable->GetProp( i );
+			if ( pChild->IsInsideArray() )
+				continue;
+			FlattenRecvProp( layout, szPath, pChild, nOffset, pChild->GetName() );
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void FlattenRecvTable( InspectorLayout_t &layout, RecvTable *pTable )
+{
+	for ( int i = 0; i < pTable->GetNumProps(); i++ )
+	{
+		const RecvProp *pProp = pTable->GetProp( i );
+		if ( pProp->IsInsideArray() )
+			continue;
+		FlattenRecvProp( layout, "", pProp, 0, pProp->GetName() );
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Predicted fields, from the entity's prediction datamap and its bases
+//---------------------------------------------------------------------------------------//
+static void FlattenDataMap( InspectorLayout_t &layout, const char *pszPath, const datamap_t *pMap, int nBase )
+{
+	for ( ; pMap; pMap = pMap->baseMap )
+	{
+		for ( int i = 0; i < pMap->dataNumFields; i++ )
+		{
+			const typedescription_t &desc = pMap->dataDesc[i];
+			if ( !desc.fieldName || desc.fieldType == FIELD_VOID )
+				continue;
+
+			const int nOffset = nBase + desc.fieldOffset[TD_OFFSET_NORMAL];
+
+			int nType;
+			switch ( desc.fieldType )
+			{
+			case FIELD_FLOAT:
+			case FIELD_TIME:
+				nType = FIELD_TYPE_FLOAT;
+				break;
+			case FIELD_INTEGER:
+			case FIELD_TICK:
+			case FIELD_MODELINDEX:
+			case FIELD_MATERIALINDEX:
+			case FIELD_COLOR32:
+				nType = FIELD_TYPE_INT;
+				break;
+			case FIELD_SHORT:
+				nType = FIELD_TYPE_SHORT;
+				break;
+			case FIELD_BOOLEAN:
+				nType = FIELD_TYPE_BOOL;
+				break;
+			case FIELD_CHARACTER:
+				nType = desc.fieldSize > 1 ? FIELD_TYPE_STRING : FIELD_TYPE_CHAR;
+				break;
+			case FIELD_VECTOR:
+			case FIELD_POSITION_VECTOR:
+			case FIELD_QUATERNION:
+				nType = FIELD_TYPE_VECTOR;
+				break;
+			case FIELD_EHANDLE:
+				nType = FIELD_TYPE_EHANDLE;
+				break;
+			case FIELD_EMBEDDED:
+			{
+				char szPath[256];
+				if ( pszPath[0] )
+					V_snprintf( szPath, sizeof( szPath ), "%s.%s", pszPath, desc.fieldName );
+				else
+					V_strncpy( szPath, desc.fieldName, sizeof( szPath ) );
+				FlattenDataMap( layout, szPath, desc.td, nOffset );
+				continue;
+			}
+			default:
+				continue;
+			}
+
+			if ( nType == FIELD_TYPE_STRING || desc.fieldSize <= 1 )
+			{
+				layout.AddField( pszPath, desc.fieldName, nOffset, nType, nType == FIELD_TYPE_STRING ? desc.fieldSize : GetFieldTypeSize( nType ) );
+				continue;
+			}
+
+			const int nStride = GetFieldTypeSize( nType );
+			for ( int e = 0; e < desc.fieldSize; e++ )
+			{
+				char szElement[128];
+				V_snprintf( szElement, sizeof( szElement ), "%s[%d]", desc.fieldName, e );
+				layout.AddField( pszPath, szElement, nOffset + e * nStride, nType, nStride );
+			}
+		}
+	}
+}
+
+static uint32 HashField( const byte *pData, const InspectorField_t &field )
+{
+	// FNV-1a, strings only up to their terminator
+	uint32 nHash = 2166136261u;
+	for ( int i = 0; i < field.nSize; i++ )
+	{
+		if ( field.nType == FIELD_TYPE_STRING && !pData[i] )
+			break;
+		nHash = ( nHash ^ pData[i] ) * 16777619u;
+	}
+
+	// 0 means not seen yet
+	return nHash ? nHash : 1;
+}
+
+static void FormatField( const byte *pData, const InspectorField_t &field, char *pszOut, int nOutSize )
+{
+	switch ( field.nType )
+	{
+	case FIELD_TYPE_INT:		V_snprintf( pszOut, nOutSize, "%d", *(const int *)pData ); break;
+	case FIELD_TYPE_SHORT:		V_snprintf( pszOut, nOutSize, "%d", *(const short *)pData ); break;
+	case FIELD_TYPE_CHAR:		V_snprintf( pszOut, nOutSize, "%d", *(const char *)pData ); break;
+	case FIELD_TYPE_BOOL:		V_strncpy( pszOut, *(const bool *)pData ? "true" : "false", nOutSize ); break;
+	case FIELD_TYPE_INT64:		V_snprintf( pszOut, nOutSize, "%lld", *(const int64 *)pData ); break;
+	case FIELD_TYPE_FLOAT:		V_snprintf( pszOut, nOutSize, "%g", *(const float *)pData ); break;
+	case FIELD_TYPE_VECTOR:
+	{
+		const float *v = (const float *)pData;
+		V_snprintf( pszOut, nOutSize, "%g %g %g", v[0], v[1], v[2] );
+		break;
+	}
+	case FIELD_TYPE_VECTORXY:
+	{
+		const float *v = (const float *)pData;
+		V_snprintf( pszOut, nOutSize, "%g %g", v[0], v[1] );
+		break;
+	}
+	case FIELD_TYPE_STRING:
+		V_strncpy( pszOut, (const char *)pData, MIN( nOutSize, field.nSize + 1 ) );
+		break;
+	case FIELD_TYPE_EHANDLE:
+	{
+		const CBaseHandle &handle = *(const CBaseHandle *)pData;
+		C_BaseEntity *pEntity = ClientEntityList().GetBaseEntityFromHandle( handle );
+		if ( pEntity )
+			V_snprintf( pszOut, nOutSize, "%d (%s)", handle.GetEntryIndex(), pEntity->GetClassname() );
+		else
+			V_strncpy( pszOut, handle.IsValid() ? "(gone)" : "null", nOutSize );
+		break;
+	}
+	default:
+		pszOut[0] = '\0';
+		break;
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Entity inspector. Entities and their fields are flattened into rows and
+//  drawn through a list clipper, so only rows on screen are read, hashed and
+//  formatted. Fields are diffed against the hash from the last time they were on
+//  screen and highlighted for a second when they change.
+//---------------------------------------------------------------------------------------//
+class CDearImGuiEntityInspector : public IImguiWindow
+{
+public:
+	CDearImGuiEntityInspector() :
+		IImguiWindow( "entities", "Entity Inspector" ),
+		m_Layouts( DefLessFunc( const void * ) ),
+		m_Expanded( DefLessFunc( unsigned long ) )
+	{
+	}
+
+	bool Draw() override;
+	void OnChangeVisibility() override;
+
+private:
+	// Only kept for expanded entities
+	struct EntityState_t
+	{
+		const InspectorLayout_t *pLayout;
+		CUtlVector<uint32> hashes;
+		CUtlVector<float> changed;		// Time each field last changed
+		float flLastChanged;
+		bool bSeen;
+		bool bCollapsed;
+	};
+
+	struct Row_t
+	{
+		C_BaseEntity *pEntity;
+		EntityState_t *pState;
+		int nField;						// -1 for the entity itself
+	};
+
+	const InspectorLayout_t *GetLayout( C_BaseEntity *pEntity );
+	void BuildRows();
+	void ClearState();
+
+	CUtlMap<const void *, InspectorLayout_t *> m_Layouts;
+	CUtlMap<unsigned long, EntityState_t *> m_Expanded;
+	CUtlVector<Row_t> m_Rows;
+
+	char m_szFilter[64] = {};
+	bool m_bPredicted = false;
+	int m_nEntities = 0;
+};
+
+DEFINE_IMGUI_WINDOW( CDearImGuiEntityInspector );
+
+const InspectorLayout_t *CDearImGuiEntityInspector::GetLayout( C_BaseEntity *pEntity )
+{
+	const void *pKey;
+	if ( m_bPredicted )
+		pKey = pEntity->GetPredDescMap();
+	else
+		pKey = pEntity->GetClientClass() ? pEntity->GetClientClass()->m_pRecvTable : nullptr;
+
+	if ( !pKey )
+		return nullptr;
+
+	auto it = m_Layouts.Find( pKey );
+	if ( it != m_Layouts.InvalidIndex() )
+		return m_Layouts[it];
+
+	InspectorLayout_t *pLayout = new InspectorLayout_t;
+	if ( m_bPredicted )
+		FlattenDataMap( *pLayout, "", (const datamap_t *)pKey, 0 );
+	else
+		FlattenRecvTable( *pLayout, (RecvTable *)pKey );
+
+	m_Layouts.Insert( pKey, pLayout );
+	return pLayout;
+}
+
+void CDearImGuiEntityInspector::ClearState()
+{
+	FOR_EACH_MAP_FAST( m_Expanded, i )
+		delete m_Expanded[i];
+	m_Expanded.RemoveAll();
+
+	FOR_EACH_MAP_FAST( m_Layouts, i )
+		delete m_Layouts[i];
+	m_Layouts.RemoveAll();
+
+	m_Rows.Purge();
+}
+
+void CDearImGuiEntityInspector::OnChangeVisibility()
+{
+	// Tables can be gone by the time the window is opened again
+	if ( !ShouldDraw() )
+		ClearState();
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: One row per entity passing the filter, plus one per field of the expanded
+//  ones. Nothing is read from the fields here.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiEntityInspector::BuildRows()
+{
+	m_Rows.RemoveAll();
+	m_nEntities = 0;
+
+	FOR_EACH_MAP_FAST( m_Expanded, i )
+		m_Expanded[i]->bSeen = false;
+
+	for ( C_BaseEntity *pEntity = ClientEntityList().FirstBaseEntity(); pEntity; pEntity = ClientEntityList().NextBaseEntity( pEntity ) )
+	{
+		if ( m_szFilter[0] && !V_stristr( pEntity->GetClassname(), m_szFilter ) )
+			continue;
+
+		EntityState_t *pState = nullptr;
+		auto it = m_Expanded.Find( pEntity->GetRefEHandle().ToInt() );
+		if ( it != m_Expanded.InvalidIndex() )
+		{
+			pState = m_Expanded[it];
+			pState->bSeen = true;
+		}
+
+		m_nEntities++;
+
+		Row_t &row = m_Rows[m_Rows.AddToTail()];
+		row.pEntity = pEntity;
+		row.pState = pState;
+		row.nField = -1;
+
+		if ( !pState || !pState->pLayout )
+			continue;
+
+		const int nFields = pState->pLayout->fields.Count();
+		m_Rows.EnsureCapacity( m_Rows.Count() + nFields );
+		for ( int f = 0; f < nFields; f++ )
+		{
+			Row_t &field = m_Rows[m_Rows.AddToTail()];
+			field.pEntity = pEntity;
+			field.pState = pState;
+			field.nField = f;
+		}
+	}
+
+	// Entities that were removed while expanded
+	for ( int i = m_Expanded.FirstInorder(); i != m_Expanded.InvalidIndex(); )
+	{
+		const int nNext = m_Expanded.NextInorder( i );
+		if ( !m_Expanded[i]->bSeen && !m_szFilter[0] )
+		{
+			delete m_Expanded[i];
+			m_Expanded.RemoveAt( i );
+		}
+		i = nNext;
+	}
+}
+
+bool CDearImGuiEntityInspector::Draw()
+{
+	ImGui::SetNextItemWidth( ImGui::GetFontSize() * 12.0f );
+	ImGui::InputTextWithHint( "##filter", "Class name", m_szFilter, sizeof( m_szFilter ) );
+
+	ImGui::SameLine();
+	if ( ImGui::RadioButton( "Networked", !m_bPredicted ) && m_bPredicted )
+	{
+		m_bPredicted = false;
+		ClearState();
+	}
+
+	ImGui::SameLine();
+	if ( ImGui::RadioButton( "Predicted", m_bPredicted ) && !m_bPredicted )
+	{
+		m_bPredicted = true;
+		ClearState();
+	}
+
+	BuildRows();
+
+	ImGui::SameLine();
+	ImGui::TextDisabled( "%d entities, %d expanded", m_nEntities, m_Expanded.Count() );
+
+	const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersV | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable;
+	if ( !ImGui::BeginTable( "##entities", 2, flags ) )
+		return true;
+
+	ImGui::TableSetupScrollFreeze( 0, 1 );
+	ImGui::TableSetupColumn( "Name", ImGuiTableColumnFlags_WidthStretch, 0.5f );
+	ImGui::TableSetupColumn( "Value", ImGuiTableColumnFlags_WidthStretch, 0.5f );
+	ImGui::TableHeadersRow();
+
+	const float flNow = gpGlobals->realtime;
+	const ImVec4 &highlight = ImGui::GetStyle().Colors[ImGuiCol_PlotHistogram];
+
+	ImGuiListClipper clipper;
+	clipper.Begin( m_Rows.Count() );
+	while ( clipper.Step() )
+	{
+		for ( int r = clipper.DisplayStart; r < clipper.DisplayEnd; r++ )
+		{
+			const Row_t &row = m_Rows[r];
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+
+			if ( row.nField < 0 )
+			{
+				C_BaseEntity *pEntity = row.pEntity;
+				const unsigned long nHandle = pEntity->GetRefEHandle().ToInt();
+
+				ImGui::PushID( (int)nHandle );
+				ImGui::SetNextItemOpen( row.pState != nullptr );
+				const bool bOpen = ImGui::TreeNodeEx( "##entity", ImGuiTreeNodeFlags_NoTreePushOnOpen | ImGuiTreeNodeFlags_SpanAllColumns, "%d %s", pEntity->entindex(), pEntity->GetClassname() );
+				ImGui::PopID();
+
+				if ( bOpen && !row.pState )
+				{
+					EntityState_t *pState = new EntityState_t;
+					pState->pLayout = GetLayout( pEntity );
+					pState->flLastChanged = -FLT_MAX;
+					pState->bSeen = true;
+					pState->bCollapsed = false;
+					if ( pState->pLayout )
+					{
+						pState->hashes.SetCount( pState->pLayout->fields.Count() );
+						pState->changed.SetCount( pState->pLayout->fields.Count() );
+						for ( int f = 0; f < pState->hashes.Count(); f++ )
+						{
+							pState->hashes[f] = 0;
+							pState->changed[f] = -FLT_MAX;
+						}
+					}
+					m_Expanded.Insert( nHandle, pState );
+				}
+				else if ( !bOpen && row.pState )
+				{
+					// The field rows after this one still point at it, it goes after the table
+					row.pState->bCollapsed = true;
+				}
+
+				ImGui::TableNextColumn();
+				if ( row.pState && row.pState->pLayout )
+					ImGui::TextDisabled( "%d fields", row.pState->pLayout->fields.Count() );
+				else if ( row.pState )
+					ImGui::TextDisabled( m_bPredicted ? "not predicted" : "not networked" );
+
+				if ( row.pState && flNow - row.pState->flLastChanged < 1.0f )
+				{
+					const ImVec4 col( highlight.x, highlight.y, highlight.z, 0.35f * ( 1.0f - ( flNow - row.pState->flLastChanged ) ) );
+					ImGui::TableSetBgColor( ImGuiTableBgTarget_RowBg1, ImGui::GetColorU32( col ) );
+				}
+				continue;
+			}
+
+			EntityState_t *pState = row.pState;
+			if ( pState->bCollapsed )
+				continue;
+
+			const InspectorField_t &field = pState->pLayout->fields[row.nField];
+			const byte *pData = (const byte *)row.pEntity + field.nOffset;
+
+			// First time on screen only records the value
+			const uint32 nHash = HashField( pData, field );
+			if ( pState->hashes[row.nField] && pState->hashes[row.nField] != nHash )
+			{
+				pState->changed[row.nField] = flNow;
+				pState->flLastChanged = flNow;
+			}
+			pState->hashes[row.nField] = nHash;
+
+			ImGui::Indent();
+			ImGui::TextUnformatted( pState->pLayout->GetName( row.nField ) );
+			ImGui::Unindent();
+
+			char szValue[256];
+			FormatField( pData, field, szValue, sizeof( szValue ) );
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted( szValue );
+
+			const float flAge = flNow - pState->changed[row.nField];
+			if ( flAge < 1.0f )
+			{
+				const ImVec4 col( highlight.x, highlight.y, highlight.z, 0.6f * ( 1.0f - flAge ) );
+				ImGui::TableSetBgColor( ImGuiTableBgTarget_RowBg1, ImGui::GetColorU32( col ) );
+			}
+		}
+	}
+
+	ImGui::EndTable();
+
+	for ( int i = m_Expanded.FirstInorder(); i != m_Expanded.InvalidIndex(); )
+	{
+		const int nNext = m_Expanded.NextInorder( i );
+		if ( m_Expanded[i]->bCollapsed )
+		{
+			delete m_Expanded[i];
+			m_Expanded.RemoveAt( i );
+		}
+		i = nNext;
+	}
+
+	return true;
+}
@@ -0,0 +1,235 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#include "imgui_fontatlas.h"
+
+#include "convar.h"
+#include "imgui_allocstats.h"
+#include "imgui_glyphcache.h"
+#include "imgui_impl_source.h"
+#include "imgui_system.h"
+#include "tier0/vprof.h"
+#include "vstdlib/jobthread.h"
+
+#include "tier0/memdbgon.h"
+
+static ConVar imgui_font_rebake( "imgui_font_rebake", "1", FCVAR_ARCHIVE, "Rebuild the font atlas at the current scale instead of stretching it" );
+static ConVar imgui_font_rebake_delay( "imgui_font_rebake_delay", "0.25", FCVAR_NONE, "Seconds the scale has to stay put before the font atlas is rebuilt" );
+static ConVar imgui_font_upload_rows( "imgui_font_upload_rows", "128", FCVAR_NONE, "Rows of a rebuilt font atlas uploaded per frame" );
+static ConVar imgui_font_sdf( "imgui_font_sdf", "0", FCVAR_ARCHIVE, "Bake fonts once as signed distance fields and scale them freely instead of rebaking" );
+static ConVar imgui_font_sdf_scale( "imgui_font_sdf_scale", "2", FCVAR_ARCHIVE, "Scale distance field fonts are baked at, larger keeps small details sharper", true, 1, true, 4 );
+
+CDearImGuiFontAtlas g_ImGuiFontAtlas;
+
+// Runs on a worker thread, the atlas isn't visible to imgui yet. Building a standalone
+// atlas doesn't use the context, only the allocator.
+static int BuildFontAtlas( ImFontAtlas *pAtlas, bool bSDF )
+{
+	tmZone( TELEMETRY_LEVEL1, TMZF_NONE, "%s", __FUNCTION__ );
+	IMGUI_ALLOC_SCOPE( "ImGui fonts" );
+
+	unsigned char *pPixels;
+	int nWidth, nHeight;
+	pAtlas->GetTexDataAsRGBA32( &pPixels, &nWidth, &nHeight );
+
+	if ( bSDF )
+		ImGui_ImplSource_BuildFontsSDF( pAtlas );
+	return 0;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Copy the fonts of the current atlas into a new one at the requested scale, and
+//  queue it to be built
+//---------------------------------------------------------------------------------------//
+void CDearImGuiFontAtlas::StartRebuild( float flScale, bool bSDF )
+{
+	IMGUI_ALLOC_SCOPE( "ImGui fonts" );
+	const ImFontAtlas *pSource = ImGui::GetIO().Fonts;
+
+	// SDF atlases change these, remember what the regular atlas had
+	if ( !m_bHaveBaseSettings )
+	{
+		m_nBaseFlags = pSource->Flags;
+		m_nBaseGlyphPadding = pSource->TexGlyphPadding;
+		m_bHaveBaseSettings = true;
+	}
+
+	m_pPending = IM_NEW( ImFontAtlas );
+	m_pPending->TexDesiredWidth = pSource->TexDesiredWidth;
+	if ( bSDF )
+	{
+		// Lines are drawn as geometry, baked ones would be distorted by the distance field
+		m_pPending->Flags = m_nBaseFlags | ImFontAtlasFlags_NoBakedLines | ImFontAtlasFlags_NoMouseCursors;
+		m_pPending->TexGlyphPadding = MAX( m_nBaseGlyphPadding, IMGUI_FONT_SDF_SPREAD );
+	}
+	else
+	{
+		m_pPending->Flags = m_nBaseFlags;
+		m_pPending->TexGlyphPadding = m_nBaseGlyphPadding;
+	}
+	m_flPendingScale = flScale;
+	m_bPendingSDF = bSDF;
+
+	const float flRatio = m_flPendingScale / m_flBakedScale;
+	for ( int i = 0; i < pSource->ConfigData.Size; i++ )
+	{
+		// AddFont makes its own copy of data it doesn't own
+		ImFontConfig config = pSource->ConfigData[i];
+		config.FontDataOwnedByAtlas = false;
+		config.DstFont = nullptr;
+		config.SizePixels *= flRatio;
+		config.GlyphOffset.x *= flRatio;
+		config.GlyphOffset.y *= flRatio;
+		config.GlyphMinAdvanceX *= flRatio;
+		config.GlyphMaxAdvanceX *= flRatio;
+		m_pPending->AddFont( &config );
+	}
+	g_ImGuiGlyphCache.Reserve( m_pPending );
+
+	m_pJob = g_pThreadPool->QueueCall( BuildFontAtlas, m_pPending, bSDF );
+}
+
+void CDearImGuiFontAtlas::CancelRebuild()
+{
+	if ( m_pJob )
+	{
+		m_pJob->WaitForFinishAndRelease();
+		m_pJob = nullptr;
+	}
+
+	if ( m_PendingTexture )
+	{
+		ImGui_ImplSource_DestroyFontsTexture( m_PendingTexture );
+		m_PendingTexture = nullptr;
+	}
+
+	if ( m_pPending )
+	{
+		IM_DELETE( m_pPending );
+		m_pPending = nullptr;
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Replace the live atlas with the uploaded one. The new fonts are moved into the
+//  old ImFont objects, so pointers kept by io.FontDefault, the font stack and windows
+//  stay valid.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiFontAtlas::Swap()
+{
+	ImGuiIO &io = ImGui::GetIO();
+	ImFontAtlas *pOld = io.Fonts;
+
+	// Both atlases were made from the same configs, so they have the same fonts in order
+	Assert( pOld->Fonts.Size == m_pPending->Fonts.Size );
+	for ( int i = 0; i < pOld->Fonts.Size && i < m_pPending->Fonts.Size; i++ )
+	{
+		ImFont *pKeep = pOld->Fonts[i];
+		ImFont *pNew = m_pPending->Fonts[i];
+		ImSwap( *pKeep, *pNew );
+		pOld->Fonts[i] = pNew;
+		m_pPending->Fonts[i] = pKeep;
+
+		for ( int j = 0; j < m_pPending->ConfigData.Size; j++ )
+		{
+			if ( m_pPending->ConfigData[j].DstFont == pNew )
+				m_pPending->ConfigData[j].DstFont = pKeep;
+		}
+		for ( int j = 0; j < m_pPending->CustomRects.Size; j++ )
+		{
+			if ( m_pPending->CustomRects[j].Font == pNew )
+				m_pPending->CustomRects[j].Font = pKeep;
+		}
+	}
+
+	io.Fonts = m_pPending;
+	if ( io.FontDefault && pOld->Fonts.find_index( io.FontDefault ) >= 0 )
+		io.FontDefault = nullptr;
+
+	ImGui_ImplSource_DestroyFontsTexture( pOld->TexID );
+	IM_DELETE( pOld );
+
+	m_flBakedScale = m_flPendingScale;
+	m_bBakedSDF = m_bPendingSDF;
+	m_pPending = nullptr;
+	m_PendingTexture = nullptr;
+}
+
+bool CDearImGuiFontAtlas::Update( float flScale )
+{
+	VPROF_BUDGET( "CDearImGuiFontAtlas::Update", VPROF_BUDGETGROUP_IMGUI );
+
+	const double flNow = Plat_FloatTime();
+	if ( flScale != m_flRequestedScale )
+	{
+		m_flRequestedScale = flScale;
+		m_flRequestTime = flNow;
+	}
+
+	// Distance fields are baked once at a fixed scale and stretched from there
+	const bool bSDF = imgui_font_sdf.GetBool();
+	const float flBakeScale = bSDF ? imgui_font_sdf_scale.GetFloat() : m_flRequestedScale;
+
+	if ( m_pPending && ( m_flPendingScale != flBakeScale || m_bPendingSDF != bSDF ) )
+		CancelRebuild();
+
+	bool bSwapped = false;
+	if ( m_pJob )
+	{
+		if ( !m_pJob->IsFinished() )
+			return false;
+
+		m_pJob->Release();
+		m_pJob = nullptr;
+		m_PendingTexture = ImGui_ImplSource_CreateFontsTexture( m_pPending, false, m_bPendingSDF );
+	}
+
+	if ( m_PendingTexture )
+	{
+		if ( !ImGui_ImplSource_UploadFontsTexture( m_PendingTexture, imgui_font_upload_rows.GetInt() ) )
+			return false;
+
+		Swap();
+		bSwapped = true;
+	}
+	else if ( m_flRequestedScale > 0.0f && flNow - m_flRequestTime >= imgui_font_rebake_delay.GetFloat() )
+	{
+		const bool bModeChanged = bSDF != m_bBakedSDF;
+		const bool bScaleChanged = flBakeScale != m_flBakedScale && ( bSDF || imgui_font_rebake.GetBool() );
+		if ( bModeChanged || bScaleChanged || m_bRebuildRequested )
+		{
+			StartRebuild( flBakeScale, bSDF );
+			m_bRebuildRequested = false;
+		}
+	}
+
+	if ( m_bBakedSDF )
+		ImGui_ImplSource_SetFontsTextureScale( ImGui::GetIO().Fonts->TexID, GetFontGlobalScale() );
+
+	return bSwapped;
+}
+
+void CDearImGuiFontAtlas::Shutdown()
+{
+	CancelRebuild();
+}
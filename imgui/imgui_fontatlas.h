@@ -0,0 +1,84 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#pragma once
+
+#include "imgui/imgui.h"
+
+class CJob;
+
+//--------------------------------------------------------------------------------//
+// Purpose: Keeps the font atlas baked at the UI scale. Scale changes rebuild the
+//  atlas on a worker thread and upload it over a few frames, the old atlas is
+//  stretched with FontGlobalScale until the new one is swapped in. In SDF mode the
+//  atlas is baked once as a distance field and only ever stretched.
+//
+//  io.Fonts is replaced by the swap, but the ImFont objects aren't: the rebuilt fonts
+//  are moved into them, so ImFont pointers kept for PushFont stay valid. Glyph
+//  pointers and the texture id don't.
+//--------------------------------------------------------------------------------//
+class CDearImGuiFontAtlas
+{
+public:
+	// Called between frames with the pixel scale fonts should have. Returns true if a new
+	// atlas was swapped in, anything holding on to vertices or texture ids from the old
+	// one must drop them.
+	bool Update( float flScale );
+
+	// Scale still applied on top of the baked atlas, 1 once a rebake has caught up
+	float GetFontGlobalScale() const { return m_flRequestedScale / m_flBakedScale; }
+
+	bool IsRebuilding() const { return m_pPending != nullptr; }
+	bool IsSDF() const { return m_bBakedSDF; }
+
+	// Rebuilds the atlas at the current scale with the next update, for changes to what's
+	// reserved in it
+	void RequestRebuild() { m_bRebuildRequested = true; }
+
+	void Shutdown();
+
+private:
+	void StartRebuild( float flScale, bool bSDF );
+	void CancelRebuild();
+	void Swap();
+
+	float m_flBakedScale = 1.0f;
+	bool m_bBakedSDF = false;
+	float m_flRequestedScale = 1.0f;
+	double m_flRequestTime = 0.0;
+	bool m_bRebuildRequested = false;
+
+	// Rebake in flight, built by m_pJob then uploaded through m_PendingTexture
+	ImFontAtlas *m_pPending = nullptr;
+	float m_flPendingScale = 1.0f;
+	bool m_bPendingSDF = false;
+	CJob *m_pJob = nullptr;
+	ImTextureID m_PendingTexture = nullptr;
+
+	// Settings of the regular atlas, SDF atlases override them
+	bool m_bHaveBaseSettings = false;
+	ImFontAtlasFlags m_nBaseFlags = 0;
+	int m_nBaseGlyphPadding = 1;
+};
+
+extern CDearImGuiFontAtlas g_ImGuiFontAtlas;
@@ -0,0 +1,487 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#include "imgui_format.h"
+#include "imgui_glyphcache.h"
+
+#include "convar.h"
+#include "strtools.h"
+#include "imgui/imgui_internal.h"
+
+#include <math.h>
+
+#include "tier0/memdbgon.h"
+
+static ConVar imgui_text_cache_size( "imgui_text_cache_size", "8192", FCVAR_NONE, "Formatted strings g_ImGuiTextCache keeps before dropping the ones that weren't drawn last frame" );
+
+CDearImGuiTextCache g_ImGuiTextCache;
+
+//---------------------------------------------------------------------------------------//
+// Formatting. imgui formats every Text(), slider and drag value through ImFormatStringV,
+// and almost all of them are plain %d, %u, %x, %s or %.Nf. Those are formatted here
+// without the CRT; any other format goes to vsnprintf.
+//---------------------------------------------------------------------------------------//
+enum
+{
+	FORMAT_LEFT		= ( 1 << 0 ),	// -
+	FORMAT_ZERO		= ( 1 << 1 ),	// 0
+	FORMAT_PLUS		= ( 1 << 2 ),	// +
+	FORMAT_SPACE	= ( 1 << 3 ),	// ' '
+};
+
+struct FormatSpec_t
+{
+	const char *pszStart;	// The '%'
+	int nLength;			// Up to and including the conversion
+	int nFlags;
+	int nWidth;
+	int nPrecision;			// -1 when not given
+	char nConversion;
+};
+
+// Parses the conversion starting at the '%' at p. Returns the character after it, or null
+// if it needs the CRT: length modifiers, '*', '#' and the conversions not listed here.
+static const char *ParseFormatSpec( const char *p, FormatSpec_t &spec )
+{
+	spec.pszStart = p++;
+	spec.nFlags = 0;
+	spec.nWidth = 0;
+	spec.nPrecision = -1;
+
+	for ( ;; p++ )
+	{
+		if ( *p == '-' )
+			spec.nFlags |= FORMAT_LEFT;
+		else if ( *p == '0' )
+			spec.nFlags |= FORMAT_ZERO;
+		else if ( *p == '+' )
+			spec.nFlags |= FORMAT_PLUS;
+		else if ( *p == ' ' )
+			spec.nFlags |= FORMAT_SPACE;
+		else
+			break;
+	}
+
+	for ( ; *p >= '0' && *p <= '9'; p++ )
+		spec.nWidth = spec.nWidth * 10 + ( *p - '0' );
+
+	if ( *p == '.' )
+	{
+		spec.nPrecision = 0;
+		for ( p++; *p >= '0' && *p <= '9'; p++ )
+			spec.nPrecision = spec.nPrecision * 10 + ( *p - '0' );
+	}
+
+	switch ( *p )
+	{
+	case 'd': case 'i': case 'u': case 'x': case 'X': case 'c':
+		// Integer precision pads with zeros, rare enough to leave to the CRT
+		if ( spec.nPrecision >= 0 )
+			return nullptr;
+		break;
+	case 'f': case 's': case '%':
+		break;
+	default:
+		return nullptr;
+	}
+
+	if ( spec.nWidth > 256 )
+		return nullptr;
+
+	spec.nConversion = *p;
+	spec.nLength = p + 1 - spec.pszStart;
+	return p + 1;
+}
+
+static bool IsFastFormat( const char *pszFormat )
+{
+	FormatSpec_t spec;
+	for ( const char *p = pszFormat; *p; )
+	{
+		if ( *p != '%' )
+		{
+			p++;
+			continue;
+		}
+
+		p = ParseFormatSpec( p, spec );
+		if ( !p )
+			return false;
+	}
+	return true;
+}
+
+// Counts everything written, stores what fits along with the terminator
+struct FormatWriter_t
+{
+	char *pBuf;
+	size_t nSize;
+	size_t nLength;
+
+	void Put( char c )
+	{
+		if ( nLength + 1 < nSize )
+			pBuf[nLength] = c;
+		nLength++;
+	}
+
+	void Put( char c, int nCount )
+	{
+		for ( int i = 0; i < nCount; i++ )
+			Put( c );
+	}
+
+	void Put( const char *pszText, int nLength )
+	{
+		for ( int i = 0; i < nLength; i++ )
+			Put( pszText[i] );
+	}
+
+	// Sign or prefix, then the digits, padded to the spec's width
+	void PutField( const FormatSpec_t &spec, const char *pszPrefix, int nPrefix, const char *pszBody, int nBody )
+	{
+		const int nPad = MAX( spec.nWidth - nPrefix - nBody, 0 );
+		if ( !( spec.nFlags & FORMAT_LEFT ) && !( spec.nFlags & FORMAT_ZERO ) )
+			Put( ' ', nPad );
+		Put( pszPrefix, nPrefix );
+		if ( !( spec.nFlags & FORMAT_LEFT ) && ( spec.nFlags & FORMAT_ZERO ) )
+			Put( '0', nPad );
+		Put( pszBody, nBody );
+		if ( spec.nFlags & FORMAT_LEFT )
+			Put( ' ', nPad );
+	}
+};
+
+// Writes the digits of n backwards from the end of pszEnd, returns the first one
+static char *FormatDigits( char *pszEnd, uint64 n, unsigned int nBase, bool bUpper )
+{
+	const char *pszDigits = bUpper ? "0123456789ABCDEF" : "0123456789abcdef";
+	do
+	{
+		*--pszEnd = pszDigits[n % nBase];
+		n /= nBase;
+	} while ( n );
+	return pszEnd;
+}
+
+static int FormatSignPrefix( const FormatSpec_t &spec, bool bNegative, char *pszPrefix )
+{
+	if ( bNegative )
+		pszPrefix[0] = '-';
+	else if ( spec.nFlags & FORMAT_PLUS )
+		pszPrefix[0] = '+';
+	else if ( spec.nFlags & FORMAT_SPACE )
+		pszPrefix[0] = ' ';
+	else
+		return 0;
+	return 1;
+}
+
+static void FormatFloat( FormatWriter_t &writer, const FormatSpec_t &spec, double flValue )
+{
+	static const uint64 s_Pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+	const int nPrecision = spec.nPrecision >= 0 ? spec.nPrecision : 6;
+	const double flAbs = fabs( flValue );
+	const uint64 nScale = s_Pow10[MIN( nPrecision, (int)V_ARRAYSIZE( s_Pow10 ) - 1 )];
+	const double flScaled = flAbs * nScale;
+
+	// Fixed point is exact enough for anything a UI shows, the rest goes to the CRT. Below
+	// 2^52 the rounding error of the scaling is under a quarter, which the rounding relies on.
+	if ( nPrecision >= (int)V_ARRAYSIZE( s_Pow10 ) || !( flScaled < 4503599627370496.0 ) )
+	{
+		char szSpec[32], szTemp[512];
+		V_strncpy( szSpec, spec.pszStart, MIN( spec.nLength + 1, (int)sizeof( szSpec ) ) );
+		V_snprintf( szTemp, sizeof( szTemp ), szSpec, flValue );
+		writer.Put( szTemp, V_strlen( szTemp ) );
+		return;
+	}
+
+	// Rounds the exact value the CRT sees, not the rounded product: 2.675 is really
+	// 2.67499999..., so it has to go down even though 2.675 * 100 comes out as 267.5.
+	// fma gives the product's rounding error exactly, and the halfway test is exact
+	// wherever it matters. Only true ties round to even.
+	const double flError = fma( flAbs, (double)nScale, -flScaled );
+	uint64 n = (uint64)flScaled;
+	const double flHalf = ( flScaled - (double)n ) - 0.5;
+	if ( flHalf > -flError || ( flHalf == -flError && ( n & 1 ) ) )
+		n++;
+
+	char szBody[48];
+	char *pszEnd = szBody + sizeof( szBody );
+	char *pszStart = pszEnd;
+	if ( nPrecision )
+	{
+		pszStart = FormatDigits( pszEnd, n % nScale, 10, false );
+		while ( pszEnd - pszStart < nPrecision )
+			*--pszStart = '0';
+		*--pszStart = '.';
+	}
+	pszStart = FormatDigits( pszStart, n / nScale, 10, false );
+
+	char szPrefix[1];
+	const int nPrefix = FormatSignPrefix( spec, signbit( flValue ) != 0, szPrefix );
+	writer.PutField( spec, szPrefix, nPrefix, pszStart, pszEnd - pszStart );
+}
+
+static void FormatFastV( FormatWriter_t &writer, const char *pszFormat, va_list args )
+{
+	FormatSpec_t spec;
+	for ( const char *p = pszFormat; *p; )
+	{
+		if ( *p != '%' )
+		{
+			writer.Put( *p++ );
+			continue;
+		}
+
+		p = ParseFormatSpec( p, spec );
+
+		char szDigits[24];
+		char *pszEnd = szDigits + sizeof( szDigits );
+		char szPrefix[1];
+		switch ( spec.nConversion )
+		{
+		case 'd':
+		case 'i':
+		{
+			const int nValue = va_arg( args, int );
+			const uint64 nAbs = nValue < 0 ? (uint64)( -(int64)nValue ) : (uint64)nValue;
+			const char *pszStart = FormatDigits( pszEnd, nAbs, 10, false );
+			writer.PutField( spec, szPrefix, FormatSignPrefix( spec, nValue < 0, szPrefix ), pszStart, pszEnd - pszStart );
+			break;
+		}
+		case 'u':
+		case 'x':
+		case 'X':
+		{
+			const unsigned int nValue = va_arg( args, unsigned int );
+			const char *pszStart = FormatDigits( pszEnd, nValue, spec.nConversion == 'u' ? 10 : 16, spec.nConversion == 'X' );
+			writer.PutField( spec, nullptr, 0, pszStart, pszEnd - pszStart );
+			break;
+		}
+		case 'c':
+		{
+			const char c = (char)va_arg( args, int );
+			writer.PutField( spec, nullptr, 0, &c, 1 );
+			break;
+		}
+		case 'f':
+			FormatFloat( writer, spec, va_arg( args, double ) );
+			break;
+		case 's':
+		{
+			const char *pszValue = va_arg( args, const char * );
+			if ( !pszValue )
+				pszValue = "(null)";
+			int nLength = 0;
+			while ( pszValue[nLength] && ( spec.nPrecision < 0 || nLength < spec.nPrecision ) )
+				nLength++;
+			FormatSpec_t text = spec;
+			text.nFlags &= ~FORMAT_ZERO;
+			writer.PutField( text, nullptr, 0, pszValue, nLength );
+			break;
+		}
+		case '%':
+			writer.Put( '%' );
+			break;
+		}
+	}
+}
+
+int ImFormatString( char *buf, size_t buf_size, const char *fmt, ... )
+{
+	va_list args;
+	va_start( args, fmt );
+	const int w = ImFormatStringV( buf, buf_size, fmt, args );
+	va_end( args );
+	return w;
+}
+
+// Same contract as imgui's own: with no buffer, returns the length the text needs;
+// otherwise returns the length written, truncated to fit
+int ImFormatStringV( char *buf, size_t buf_size, const char *fmt, va_list args )
+{
+	int w;
+	if ( IsFastFormat( fmt ) )
+	{
+		FormatWriter_t writer = { buf, buf ? buf_size : 0, 0 };
+		FormatFastV( writer, fmt, args );
+		w = (int)writer.nLength;
+	}
+	else
+	{
+		w = vsnprintf( buf, buf_size, fmt, args );
+	}
+
+	if ( buf == nullptr || buf_size == 0 )
+		return w;
+	if ( w == -1 || w >= (int)buf_size )
+		w = (int)buf_size - 1;
+	buf[w] = 0;
+
+	// Everything formatted may be drawn, so it gets the glyphs the baked ranges don't have
+	g_ImGuiGlyphCache.Request( buf, buf + w );
+	return w;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: FNV-1a over the format's address, each argument and the font
+//---------------------------------------------------------------------------------------//
+static inline uint64 HashBytes( uint64 nHash, const void *pData, size_t nSize )
+{
+	const unsigned char *p = static_cast<const unsigned char *>( pData );
+	for ( size_t i = 0; i < nSize; i++ )
+		nHash = ( nHash ^ p[i] ) * 1099511628211ull;
+	return nHash;
+}
+
+static uint64 HashFormatArgs( const char *pszFormat, va_list args )
+{
+	uint64 nHash = HashBytes( 14695981039346656037ull, &pszFormat, sizeof( pszFormat ) );
+
+	FormatSpec_t spec;
+	for ( const char *p = pszFormat; *p; )
+	{
+		if ( *p != '%' )
+		{
+			p++;
+			continue;
+		}
+
+		p = ParseFormatSpec( p, spec );
+		switch ( spec.nConversion )
+		{
+		case 'd': case 'i': case 'u': case 'x': case 'X': case 'c':
+		{
+			const int nValue = va_arg( args, int );
+			nHash = HashBytes( nHash, &nValue, sizeof( nValue ) );
+			break;
+		}
+		case 'f':
+		{
+			const double flValue = va_arg( args, double );
+			nHash = HashBytes( nHash, &flValue, sizeof( flValue ) );
+			break;
+		}
+		case 's':
+		{
+			// Strings are hashed by content, the same buffer is usually reused
+			const char *pszValue = va_arg( args, const char * );
+			nHash = pszValue ? HashBytes( nHash, pszValue, V_strlen( pszValue ) + 1 ) : HashBytes( nHash, &pszValue, sizeof( pszValue ) );
+			break;
+		}
+		}
+	}
+
+	ImGuiContext &g = *GImGui;
+	nHash = HashBytes( nHash, &g.Font, sizeof( g.Font ) );
+	nHash = HashBytes( nHash, &g.FontSize, sizeof( g.FontSize ) );
+	return nHash;
+}
+
+void CDearImGuiTextCache::Text( const char *pszFormat, ... )
+{
+	va_list args;
+	va_start( args, pszFormat );
+	TextV( pszFormat, args );
+	va_end( args );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: ImGui::TextV with the formatting and measuring of unwrapped text cached
+//---------------------------------------------------------------------------------------//
+void CDearImGuiTextCache::TextV( const char *pszFormat, va_list args )
+{
+	ImGuiContext &g = *GImGui;
+	ImGuiWindow *pWindow = ImGui::GetCurrentWindow();
+	if ( pWindow->SkipItems )
+		return;
+
+	if ( pWindow->DC.TextWrapPos >= 0.0f || g.LogEnabled || !IsFastFormat( pszFormat ) )
+	{
+		ImGui::TextV( pszFormat, args );
+		return;
+	}
+
+	// Text measured before the glyph cache filled in its characters has the wrong size
+	if ( m_nGlyphGeneration != g_ImGuiGlyphCache.GetGeneration() )
+	{
+		m_Entries.Purge();
+		m_nGlyphGeneration = g_ImGuiGlyphCache.GetGeneration();
+	}
+
+	va_list hashArgs;
+	va_copy( hashArgs, args );
+	const uint64 nHash = HashFormatArgs( pszFormat, hashArgs );
+	va_end( hashArgs );
+
+	int it = m_Entries.Find( nHash );
+	if ( it == m_Entries.InvalidIndex() )
+	{
+		Entry_t entry;
+		va_list formatArgs;
+		va_copy( formatArgs, args );
+		entry.nLength = ImFormatStringV( entry.szText, sizeof( entry.szText ), pszFormat, formatArgs );
+		va_end( formatArgs );
+
+		// Too long to keep, it was cut off
+		if ( entry.nLength >= (int)sizeof( entry.szText ) - 1 )
+		{
+			ImGui::TextV( pszFormat, args );
+			return;
+		}
+
+		entry.size = ImGui::CalcTextSize( entry.szText, entry.szText + entry.nLength );
+		it = m_Entries.Insert( nHash, entry );
+	}
+
+	Entry_t &entry = m_Entries[it];
+	entry.nLastUsedFrame = g.FrameCount;
+
+	// The rest of ImGui::TextEx
+	const ImVec2 pos( pWindow->DC.CursorPos.x, pWindow->DC.CursorPos.y + pWindow->DC.CurrLineTextBaseOffset );
+	const ImRect bb( pos, ImVec2( pos.x + entry.size.x, pos.y + entry.size.y ) );
+	ImGui::ItemSize( entry.size, 0.0f );
+	if ( !ImGui::ItemAdd( bb, 0 ) )
+		return;
+
+	pWindow->DrawList->AddText( g.Font, g.FontSize, pos, ImGui::GetColorU32( ImGuiCol_Text ), entry.szText, entry.szText + entry.nLength );
+}
+
+void CDearImGuiTextCache::Update()
+{
+	if ( m_Entries.Count() <= imgui_text_cache_size.GetInt() )
+		return;
+
+	const int nFrame = ImGui::GetFrameCount();
+	FOR_EACH_MAP_FAST( m_Entries, i )
+	{
+		if ( m_Entries[i].nLastUsedFrame < nFrame )
+			m_Entries.RemoveAt( i );
+	}
+
+	// Everything was drawn this frame, start over rather than grow without bound
+	if ( m_Entries.Count() > imgui_text_cache_size.GetInt() )
+		m_Entries.RemoveAll();
+}
@@ -0,0 +1,70 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#pragma once
+
+#include "utlmap.h"
+#include "imgui/imgui.h"
+
+//--------------------------------------------------------------------------------//
+// Purpose: Text() for tables of numbers. The formatted text and its size are
+//  cached, keyed by the format string's address, the argument bits and the font,
+//  so values that didn't change since the last frame skip both formatting and
+//  measuring. Formats with conversions the fast formatter doesn't handle, wrapped
+//  text and text longer than IMGUI_TEXTCACHE_MAX_TEXT go straight to ImGui::TextV.
+//
+//  The format string has to be a literal, or live as long as the cache does.
+//--------------------------------------------------------------------------------//
+#define IMGUI_TEXTCACHE_MAX_TEXT	48
+
+class CDearImGuiTextCache
+{
+public:
+	CDearImGuiTextCache() : m_Entries( DefLessFunc( uint64 ) ) {}
+
+	void Text( PRINTF_FORMAT_STRING const char *pszFormat, ... ) FMTFUNCTION( 2, 3 );
+	void TextV( const char *pszFormat, va_list args );
+
+	// Called between frames, drops entries that weren't used in the last frame once the
+	// cache is over imgui_text_cache_size
+	void Update();
+
+	// Sizes are stale once the fonts change, including the glyph cache adding glyphs
+	void Purge() { m_Entries.Purge(); }
+
+	int GetCount() const { return m_Entries.Count(); }
+
+private:
+	struct Entry_t
+	{
+		char szText[IMGUI_TEXTCACHE_MAX_TEXT];
+		int nLength;
+		ImVec2 size;
+		int nLastUsedFrame;
+	};
+
+	CUtlMap<uint64, Entry_t, int> m_Entries;
+	int m_nGlyphGeneration = 0;
+};
+
+extern CDearImGuiTextCache g_ImGuiTextCache;
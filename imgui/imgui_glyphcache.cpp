@@ -0,0 +1,511 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#include "imgui_glyphcache.h"
+
+#include "convar.h"
+#include "imgui_allocstats.h"
+#include "imgui_fontatlas.h"
+#include "imgui_impl_source.h"
+#include "tier0/threadtools.h"
+#include "tier0/vprof.h"
+#include "imgui/imgui_internal.h"
+
+// imgui_draw.cpp keeps its copy of stb_truetype static as well. Same warnings silenced
+// and the same allocator, so rasterizing is counted with imgui's other allocations.
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning( disable: 4505 )	// unreferenced local function has been removed
+#pragma warning( disable: 4456 )	// declaration of 'xx' hides previous local declaration
+#pragma warning( disable: 4244 )	// conversion, possible loss of data
+#pragma warning( disable: 6385 )	// reading invalid data from 'buffer'
+#endif
+#if defined( __clang__ )
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-function"
+#pragma clang diagnostic ignored "-Wmissing-prototypes"
+#pragma clang diagnostic ignored "-Wimplicit-fallthrough"
+#pragma clang diagnostic ignored "-Wcast-qual"
+#elif defined( __GNUC__ )
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"
+#pragma GCC diagnostic ignored "-Wtype-limits"
+#pragma GCC diagnostic ignored "-Wcast-qual"
+#endif
+
+#define STBTT_malloc( x, u )	( (void)( u ), IM_ALLOC( x ) )
+#define STBTT_free( x, u )		( (void)( u ), IM_FREE( x ) )
+#define STBTT_assert( x )		do { IM_ASSERT( x ); } while ( 0 )
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "imgui/imstb_truetype.h"
+
+#if defined( __clang__ )
+#pragma clang diagnostic pop
+#elif defined( __GNUC__ )
+#pragma GCC diagnostic pop
+#endif
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
+
+#include "tier0/memdbgon.h"
+
+static ConVar imgui_font_glyph_page( "imgui_font_glyph_page", "128", FCVAR_NONE, "Size the atlas page glyphs outside the baked ranges are rasterized into starts at, 0 to disable. Applied when the atlas is rebuilt." );
+static ConVar imgui_font_glyph_page_max( "imgui_font_glyph_page_max", "2048", FCVAR_NONE, "Size the glyph page can grow to when every glyph in it is in use" );
+static ConVar imgui_font_glyphs_per_frame( "imgui_font_glyphs_per_frame", "32", FCVAR_NONE, "Glyphs rasterized per frame, the rest wait for the next frames" );
+
+#define SLOT_MISSING	-1
+#define SLOT_QUEUED		-2
+
+// Same white as the rest of the atlas, with coverage in alpha
+#define GLYPH_PIXEL( a )	IM_COL32( 255, 255, 255, a )
+
+CDearImGuiGlyphCache g_ImGuiGlyphCache;
+
+void CDearImGuiGlyphCache::Reserve( ImFontAtlas *pAtlas )
+{
+	if ( !m_nWantedPageSize )
+		m_nWantedPageSize = imgui_font_glyph_page.GetInt();
+
+	if ( m_nWantedPageSize <= 0 )
+		return;
+
+	// Reservations for atlases that are gone may share an address with this one
+	FOR_EACH_VEC_BACK( m_Reservations, i )
+	{
+		if ( m_Reservations[i].pAtlas == pAtlas || m_Reservations[i].pAtlas != m_pAtlas )
+			m_Reservations.Remove( i );
+	}
+
+	Reservation_t &reservation = m_Reservations[m_Reservations.AddToTail()];
+	reservation.pAtlas = pAtlas;
+	reservation.nRect = pAtlas->AddCustomRectRegular( m_nWantedPageSize, m_nWantedPageSize );
+	reservation.nSize = m_nWantedPageSize;
+}
+
+void CDearImGuiGlyphCache::Reset()
+{
+	if ( m_Texture )
+		ImGui_ImplSource_SetFontsTextureOverlay( m_Texture, nullptr, 0, 0, 0, 0 );
+
+	FOR_EACH_VEC( m_FontInfos, i )
+		delete (stbtt_fontinfo *)m_FontInfos[i];
+	m_FontInfos.Purge();
+
+	m_Glyphs.Purge();
+	m_Slots.Purge();
+	m_Pixels.Purge();
+	m_Queued.Purge();
+	m_FontsChanged.Purge();
+
+	m_pAtlas = nullptr;
+	m_Texture = nullptr;
+	m_bEnabled = false;
+	m_nResident = 0;
+	m_bGrow = false;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Find the page in a newly built atlas and split it into cells sized for the
+//  largest font
+//---------------------------------------------------------------------------------------//
+void CDearImGuiGlyphCache::Setup( ImFontAtlas *pAtlas )
+{
+	Reset();
+	m_pAtlas = pAtlas;
+	m_Texture = pAtlas->TexID;
+
+	// Distance field atlases would need each glyph converted as well
+	if ( !pAtlas->IsBuilt() || g_ImGuiFontAtlas.IsSDF() )
+		return;
+
+	const Reservation_t *pReservation = nullptr;
+	FOR_EACH_VEC( m_Reservations, i )
+	{
+		if ( m_Reservations[i].pAtlas == pAtlas )
+			pReservation = &m_Reservations[i];
+	}
+	if ( !pReservation )
+		return;
+
+	const ImFontAtlasCustomRect *pRect = pAtlas->GetCustomRectByIndex( pReservation->nRect );
+	if ( !pRect || !pRect->IsPacked() )
+		return;
+
+	float flLargest = 0.0f;
+	for ( int i = 0; i < pAtlas->Fonts.Size; i++ )
+		flLargest = MAX( flLargest, pAtlas->Fonts[i]->FontSize );
+
+	m_nPageSize = pReservation->nSize;
+	m_nPageX = pRect->X;
+	m_nPageY = pRect->Y;
+	m_nCellSize = MIN( (int)ceilf( flLargest * 1.25f ) + 2, m_nPageSize );
+	m_nCellsPerRow = m_nPageSize / m_nCellSize;
+
+	m_Slots.SetCount( m_nCellsPerRow * m_nCellsPerRow );
+	FOR_EACH_VEC( m_Slots, i )
+	{
+		m_Slots[i].nGlyph = -1;
+		m_Slots[i].nLastUsedFrame = 0;
+	}
+
+	m_Pixels.SetCount( m_nPageSize * m_nPageSize );
+	FOR_EACH_VEC( m_Pixels, i )
+		m_Pixels[i] = GLYPH_PIXEL( 0 );
+
+	if ( !ImGui_ImplSource_SetFontsTextureOverlay( pAtlas->TexID, m_Pixels.Base(), m_nPageX, m_nPageY, m_nPageSize, m_nPageSize ) )
+		return;
+
+	m_FontsChanged.SetCount( pAtlas->Fonts.Size );
+	FOR_EACH_VEC( m_FontsChanged, i )
+		m_FontsChanged[i] = false;
+
+	m_FontInfos.SetCount( pAtlas->ConfigData.Size );
+	FOR_EACH_VEC( m_FontInfos, i )
+		m_FontInfos[i] = nullptr;
+
+	m_bEnabled = true;
+}
+
+void *CDearImGuiGlyphCache::GetFontInfo( int nConfig )
+{
+	if ( m_FontInfos[nConfig] )
+		return m_FontInfos[nConfig];
+
+	const ImFontConfig &config = m_pAtlas->ConfigData[nConfig];
+	const unsigned char *pData = (const unsigned char *)config.FontData;
+	stbtt_fontinfo *pInfo = new stbtt_fontinfo;
+	if ( !pData || !stbtt_InitFont( pInfo, pData, stbtt_GetFontOffsetForIndex( pData, config.FontNo ) ) )
+	{
+		// Leave it zeroed, FindGlyphIndex on it finds nothing
+		V_memset( pInfo, 0, sizeof( *pInfo ) );
+	}
+
+	m_FontInfos[nConfig] = pInfo;
+	return pInfo;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Requests, from anywhere during the frame
+//---------------------------------------------------------------------------------------//
+void CDearImGuiGlyphCache::Request( ImWchar c )
+{
+	if ( !m_bEnabled )
+		return;
+
+	for ( int i = 0; i < m_pAtlas->Fonts.Size; i++ )
+	{
+		const ImFont *pFont = m_pAtlas->Fonts[i];
+		const bool bInFont = c < pFont->IndexLookup.Size && pFont->IndexLookup[c] != (ImU16)-1;
+
+		const int nGlyph = m_Glyphs.Find( MakeKey( i, c ) );
+		if ( nGlyph != m_Glyphs.InvalidIndex() )
+		{
+			if ( m_Glyphs[nGlyph].nSlot >= 0 )
+				m_Slots[m_Glyphs[nGlyph].nSlot].nLastUsedFrame = m_nFrame;
+			continue;
+		}
+
+		// Baked
+		if ( bInFont )
+			continue;
+
+		Glyph_t glyph;
+		glyph.nSlot = SLOT_QUEUED;
+		glyph.nConfig = -1;
+		m_Queued.AddToTail( m_Glyphs.Insert( MakeKey( i, c ), glyph ) );
+	}
+}
+
+bool CDearImGuiGlyphCache::IsPageRect( const ImFontAtlas *pAtlas, int nRect ) const
+{
+	FOR_EACH_VEC( m_Reservations, i )
+	{
+		if ( m_Reservations[i].pAtlas == pAtlas && m_Reservations[i].nRect == nRect )
+			return true;
+	}
+	return false;
+}
+
+void CDearImGuiGlyphCache::Request( const char *pszText, const char *pszTextEnd )
+{
+	// Text is formatted on data provider jobs too, those get their glyphs when it's drawn
+	if ( !m_bEnabled || !ThreadInMainThread() )
+		return;
+
+	if ( !pszTextEnd )
+		pszTextEnd = pszText + V_strlen( pszText );
+
+	for ( const char *p = pszText; p < pszTextEnd; )
+	{
+		// ASCII is always baked
+		if ( (unsigned char)*p < 0x80 )
+		{
+			p++;
+			continue;
+		}
+
+		unsigned int c;
+		p += ImTextCharFromUtf8( &c, p, pszTextEnd );
+		if ( c <= IM_UNICODE_CODEPOINT_MAX )
+			Request( (ImWchar)c );
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Requests only come from text as it's formatted. Text cached or replayed keeps
+//  using its glyphs without asking, so the cells being sampled are marked as well.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiGlyphCache::MarkDrawn( const ImDrawData *pDrawData )
+{
+	if ( !m_bEnabled || !m_nResident || !pDrawData )
+		return;
+
+	VPROF_BUDGET( "CDearImGuiGlyphCache::MarkDrawn", VPROF_BUDGETGROUP_IMGUI );
+
+	const float flMinU = m_nPageX * m_pAtlas->TexUvScale.x, flMaxU = ( m_nPageX + m_nPageSize ) * m_pAtlas->TexUvScale.x;
+	const float flMinV = m_nPageY * m_pAtlas->TexUvScale.y, flMaxV = ( m_nPageY + m_nPageSize ) * m_pAtlas->TexUvScale.y;
+	for ( int i = 0; i < pDrawData->CmdListsCount; i++ )
+	{
+		const ImDrawList *pList = pDrawData->CmdLists[i];
+		for ( int n = 0; n < pList->VtxBuffer.Size; n++ )
+		{
+			// A glyph's far corners can touch the next cell, which only keeps that one longer
+			const ImVec2 &uv = pList->VtxBuffer.Data[n].uv;
+			if ( uv.x < flMinU || uv.x >= flMaxU || uv.y < flMinV || uv.y >= flMaxV )
+				continue;
+
+			const int nCellX = ( (int)( uv.x * m_pAtlas->TexWidth ) - m_nPageX ) / m_nCellSize;
+			const int nCellY = ( (int)( uv.y * m_pAtlas->TexHeight ) - m_nPageY ) / m_nCellSize;
+			if ( nCellX < m_nCellsPerRow && nCellY < m_nCellsPerRow )
+				m_Slots[nCellY * m_nCellsPerRow + nCellX].nLastUsedFrame = m_nFrame;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Slots. Free ones first, then the one used longest ago, as long as that
+//  wasn't in the last frame.
+//---------------------------------------------------------------------------------------//
+int CDearImGuiGlyphCache::AllocateSlot()
+{
+	int nOldest = -1;
+	FOR_EACH_VEC( m_Slots, i )
+	{
+		if ( m_Slots[i].nGlyph < 0 )
+			return i;
+
+		if ( m_Slots[i].nLastUsedFrame < m_nFrame && ( nOldest < 0 || m_Slots[i].nLastUsedFrame < m_Slots[nOldest].nLastUsedFrame ) )
+			nOldest = i;
+	}
+
+	if ( nOldest >= 0 )
+		Evict( nOldest );
+	return nOldest;
+}
+
+void CDearImGuiGlyphCache::Evict( int nSlot )
+{
+	const int nGlyph = m_Slots[nSlot].nGlyph;
+	const int nFont = (int)( m_Glyphs.Key( nGlyph ) >> 32 );
+	const ImWchar c = m_Glyphs[nGlyph].glyph.Codepoint;
+
+	ImFont *pFont = m_pAtlas->Fonts[nFont];
+	for ( int i = 0; i < pFont->Glyphs.Size; i++ )
+	{
+		if ( pFont->Glyphs[i].Codepoint == c )
+		{
+			pFont->Glyphs.erase( pFont->Glyphs.Data + i );
+			break;
+		}
+	}
+	m_FontsChanged[nFont] = true;
+
+	m_Glyphs.RemoveAt( nGlyph );
+	m_Slots[nSlot].nGlyph = -1;
+	m_nResident--;
+}
+
+// BuildLookupTable appends a tab glyph unless the last one already is one
+void CDearImGuiGlyphCache::AddToFont( ImFont *pFont, const ImFontGlyph &glyph )
+{
+	pFont->Glyphs.push_back( glyph );
+	const int nCount = pFont->Glyphs.Size;
+	if ( nCount >= 2 && pFont->Glyphs[nCount - 2].Codepoint == '\t' )
+		ImSwap( pFont->Glyphs[nCount - 1], pFont->Glyphs[nCount - 2] );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Rasterize a glyph into its cell of the page and add it to its font, laid
+//  out the way the atlas builder lays out baked glyphs. Returns false if none of the
+//  font's sources have it.
+//---------------------------------------------------------------------------------------//
+bool CDearImGuiGlyphCache::Rasterize( int nGlyph, int nSlot )
+{
+	Glyph_t &glyph = m_Glyphs[nGlyph];
+	const int nFont = (int)( m_Glyphs.Key( nGlyph ) >> 32 );
+	const ImWchar c = (ImWchar)( m_Glyphs.Key( nGlyph ) & 0xFFFFFFFF );
+	ImFont *pFont = m_pAtlas->Fonts[nFont];
+
+	// Merged fonts have several sources, the first with the glyph wins
+	const stbtt_fontinfo *pInfo = nullptr;
+	int nIndex = 0;
+	for ( int i = 0; i < pFont->ConfigDataCount && !nIndex; i++ )
+	{
+		glyph.nConfig = ( pFont->ConfigData + i ) - m_pAtlas->ConfigData.Data;
+		pInfo = (const stbtt_fontinfo *)GetFontInfo( glyph.nConfig );
+		nIndex = pInfo->data ? stbtt_FindGlyphIndex( pInfo, c ) : 0;
+	}
+
+	if ( !nIndex )
+		return false;
+
+	const ImFontConfig &config = m_pAtlas->ConfigData[glyph.nConfig];
+	const float flDensity = config.RasterizerDensity;
+	const float flScale = config.SizePixels > 0.0f ? stbtt_ScaleForPixelHeight( pInfo, config.SizePixels * flDensity ) : stbtt_ScaleForMappingEmToPixels( pInfo, -config.SizePixels * flDensity );
+
+	int x0, y0, x1, y1;
+	stbtt_GetGlyphBitmapBox( pInfo, nIndex, flScale, flScale, &x0, &y0, &x1, &y1 );
+
+	// A texel of the cell is left empty so filtering doesn't pick up the neighbours
+	const int nWidth = MIN( x1 - x0, m_nCellSize - 1 );
+	const int nHeight = MIN( y1 - y0, m_nCellSize - 1 );
+	const int nCellX = ( nSlot % m_nCellsPerRow ) * m_nCellSize;
+	const int nCellY = ( nSlot / m_nCellsPerRow ) * m_nCellSize;
+
+	for ( int y = 0; y < m_nCellSize; y++ )
+	{
+		uint32 *pRow = m_Pixels.Base() + ( nCellY + y ) * m_nPageSize + nCellX;
+		for ( int x = 0; x < m_nCellSize; x++ )
+			pRow[x] = GLYPH_PIXEL( 0 );
+	}
+
+	if ( nWidth > 0 && nHeight > 0 )
+	{
+		CUtlVector<unsigned char> coverage;
+		coverage.SetCount( nWidth * nHeight );
+		stbtt_MakeGlyphBitmap( pInfo, coverage.Base(), nWidth, nHeight, nWidth, flScale, flScale, nIndex );
+
+		for ( int y = 0; y < nHeight; y++ )
+		{
+			uint32 *pRow = m_Pixels.Base() + ( nCellY + y ) * m_nPageSize + nCellX;
+			const unsigned char *pCoverage = coverage.Base() + y * nWidth;
+			for ( int x = 0; x < nWidth; x++ )
+				pRow[x] = GLYPH_PIXEL( pCoverage[x] );
+		}
+	}
+
+	int nAdvance, nBearing;
+	stbtt_GetGlyphHMetrics( pInfo, nIndex, &nAdvance, &nBearing );
+
+	const float flInvDensity = 1.0f / flDensity;
+	const float flOffsetX = config.GlyphOffset.x;
+	const float flOffsetY = config.GlyphOffset.y + IM_ROUND( pFont->Ascent );
+	const float u = (float)( m_nPageX + nCellX ), v = (float)( m_nPageY + nCellY );
+	const ImVec2 &uvScale = m_pAtlas->TexUvScale;
+
+	pFont->AddGlyph( &config, c,
+		x0 * flInvDensity + flOffsetX, y0 * flInvDensity + flOffsetY,
+		( x0 + nWidth ) * flInvDensity + flOffsetX, ( y0 + nHeight ) * flInvDensity + flOffsetY,
+		u * uvScale.x, v * uvScale.y, ( u + nWidth ) * uvScale.x, ( v + nHeight ) * uvScale.y,
+		nAdvance * flScale * flInvDensity );
+
+	// AddGlyph appended it, move it in front of the tab glyph
+	glyph.glyph = pFont->Glyphs.back();
+	pFont->Glyphs.pop_back();
+	AddToFont( pFont, glyph.glyph );
+
+	glyph.nSlot = nSlot;
+	m_Slots[nSlot].nGlyph = nGlyph;
+	m_Slots[nSlot].nLastUsedFrame = m_nFrame;
+	m_FontsChanged[nFont] = true;
+	m_nResident++;
+	return true;
+}
+
+void CDearImGuiGlyphCache::Update()
+{
+	VPROF_BUDGET( "CDearImGuiGlyphCache::Update", VPROF_BUDGETGROUP_IMGUI );
+	IMGUI_ALLOC_SCOPE( "ImGui fonts" );
+
+	ImFontAtlas *pAtlas = ImGui::GetIO().Fonts;
+	if ( pAtlas != m_pAtlas || pAtlas->TexID != m_Texture )
+		Setup( pAtlas );
+
+	if ( !m_bEnabled )
+		return;
+
+	int nDirtyMinX = m_nPageSize, nDirtyMinY = m_nPageSize, nDirtyMaxX = 0, nDirtyMaxY = 0;
+
+	int nProcessed = 0;
+	const int nBudget = MAX( imgui_font_glyphs_per_frame.GetInt(), 1 );
+	for ( ; nProcessed < m_Queued.Count() && nProcessed < nBudget; nProcessed++ )
+	{
+		const int nSlot = AllocateSlot();
+		if ( nSlot < 0 )
+		{
+			// Everything in the page was used last frame
+			m_bGrow = true;
+			break;
+		}
+
+		const int nGlyph = m_Queued[nProcessed];
+		if ( !Rasterize( nGlyph, nSlot ) )
+		{
+			m_Glyphs[nGlyph].nSlot = SLOT_MISSING;
+			continue;
+		}
+
+		const int nCellX = ( nSlot % m_nCellsPerRow ) * m_nCellSize;
+		const int nCellY = ( nSlot / m_nCellsPerRow ) * m_nCellSize;
+		nDirtyMinX = MIN( nDirtyMinX, nCellX );
+		nDirtyMinY = MIN( nDirtyMinY, nCellY );
+		nDirtyMaxX = MAX( nDirtyMaxX, nCellX + m_nCellSize );
+		nDirtyMaxY = MAX( nDirtyMaxY, nCellY + m_nCellSize );
+	}
+	m_Queued.RemoveMultipleFromHead( nProcessed );
+
+	FOR_EACH_VEC( m_FontsChanged, i )
+	{
+		if ( !m_FontsChanged[i] )
+			continue;
+
+		m_pAtlas->Fonts[i]->BuildLookupTable();
+		m_FontsChanged[i] = false;
+		m_nGeneration++;
+	}
+
+	if ( nDirtyMaxX > nDirtyMinX )
+		ImGui_ImplSource_UpdateFontsTextureRect( m_Texture, m_nPageX + nDirtyMinX, m_nPageY + nDirtyMinY, nDirtyMaxX - nDirtyMinX, nDirtyMaxY - nDirtyMinY );
+
+	// The page gets bigger with the rebuilt atlas, glyphs are requested again from there
+	if ( m_bGrow && m_nPageSize * 2 <= imgui_font_glyph_page_max.GetInt() && m_nWantedPageSize <= m_nPageSize )
+	{
+		m_nWantedPageSize = m_nPageSize * 2;
+		g_ImGuiFontAtlas.RequestRebuild();
+	}
+	m_bGrow = false;
+
+	m_nFrame++;
+}
@@ -0,0 +1,143 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#pragma once
+
+#include "utlmap.h"
+#include "utlvector.h"
+#include "imgui/imgui.h"
+
+//--------------------------------------------------------------------------------//
+// Purpose: Glyphs rasterized on first use. Fonts only need to be baked with the
+//  ranges every player sees, anything outside them is rasterized from the font's
+//  TTF data into a page reserved in the atlas, then uploaded as just the changed
+//  rect. When the page is full, the glyphs drawn or requested longest ago are
+//  evicted. If every glyph in the page is still in use, the page doubles in size
+//  with the next atlas rebuild.
+//
+//  imgui 1.91 looks glyphs up with no way to hear about misses, so text that
+//  may need them has to go through Request. Everything formatted through
+//  ImFormatStringV (Text, slider and drag values, tooltips) and typed characters
+//  are requested automatically. Text imgui draws as is, like labels, TextUnformatted
+//  and Text( "%s" ), can be wrapped in ImGui_RequestGlyphs.
+//--------------------------------------------------------------------------------//
+class CDearImGuiGlyphCache
+{
+public:
+	CDearImGuiGlyphCache() : m_Glyphs( DefLessFunc( uint64 ) ) {}
+
+	// Reserves the page in an atlas that hasn't been built yet
+	void Reserve( ImFontAtlas *pAtlas );
+
+	// Marks the glyphs of UTF-8 text as used, queueing the ones every font is missing.
+	// Queued glyphs show up the next frame.
+	void Request( const char *pszText, const char *pszTextEnd = nullptr );
+	void Request( ImWchar c );
+
+	// Marks the glyphs a frame's vertices sample as used, so text replayed or drawn
+	// without a request isn't evicted while it's on screen
+	void MarkDrawn( const ImDrawData *pDrawData );
+
+	// Called between frames. Rasterizes and uploads queued glyphs. Vertices built before
+	// GetGeneration changes must be dropped.
+	void Update();
+
+	// Forgets every glyph, the atlas was replaced
+	void Reset();
+
+	// Changes whenever glyphs are added to or evicted from the fonts, anything measured
+	// or built with them before is stale
+	int GetGeneration() const { return m_nGeneration; }
+
+	// True for the custom rect of an atlas that holds the page
+	bool IsPageRect( const ImFontAtlas *pAtlas, int nRect ) const;
+
+	int GetGlyphCount() const { return m_nResident; }
+	int GetSlotCount() const { return m_Slots.Count(); }
+	int GetPageSize() const { return m_nPageSize; }
+
+private:
+	struct Slot_t
+	{
+		int nGlyph;				// Index into m_Glyphs, or -1 when free
+		int nLastUsedFrame;
+	};
+
+	struct Reservation_t
+	{
+		ImFontAtlas *pAtlas;
+		int nRect;
+		int nSize;
+	};
+
+	struct Glyph_t
+	{
+		int nSlot;				// SLOT_MISSING when no font has it, SLOT_QUEUED until rasterized
+		int nConfig;			// Index into the atlas ConfigData it was rasterized from
+		ImFontGlyph glyph;		// As added to the font, its codepoint finds it again on eviction
+	};
+
+	static uint64 MakeKey( int nFont, ImWchar c ) { return ( (uint64)nFont << 32 ) | c; }
+
+	void Setup( ImFontAtlas *pAtlas );
+	void *GetFontInfo( int nConfig );
+	bool Rasterize( int nGlyph, int nSlot );
+	int AllocateSlot();
+	void Evict( int nSlot );
+	void AddToFont( ImFont *pFont, const ImFontGlyph &glyph );
+
+	// Page size asked of atlases reserved from now on, doubles when the page is too small
+	int m_nWantedPageSize = 0;
+	CUtlVector<Reservation_t> m_Reservations;
+
+	// Page of the current atlas
+	ImFontAtlas *m_pAtlas = nullptr;
+	ImTextureID m_Texture = nullptr;
+	bool m_bEnabled = false;
+	int m_nPageSize = 0;
+	int m_nPageX = 0;
+	int m_nPageY = 0;
+	int m_nCellSize = 0;
+	int m_nCellsPerRow = 0;
+
+	CUtlVector<uint32> m_Pixels;		// RGBA copy of the page, kept for device resets
+	CUtlVector<Slot_t> m_Slots;
+	CUtlMap<uint64, Glyph_t, int> m_Glyphs;
+	CUtlVector<int> m_Queued;
+	CUtlVector<bool> m_FontsChanged;
+	CUtlVector<void *> m_FontInfos;		// stbtt_fontinfo per atlas config, created on first use
+	int m_nResident = 0;
+	int m_nFrame = 0;
+	int m_nGeneration = 0;
+	bool m_bGrow = false;
+};
+
+extern CDearImGuiGlyphCache g_ImGuiGlyphCache;
+
+// Requests the glyphs of text imgui won't format, and returns it:
+//  ImGui::Button( ImGui_RequestGlyphs( pszLocalizedLabel ) );
+inline const char *ImGui_RequestGlyphs( const char *pszText )
+{
+	g_ImGuiGlyphCache.Request( pszText );
+	return pszText;
+}
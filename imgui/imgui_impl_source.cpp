@@ -24,47 +24,351 @@
 #include "imgui_impl_source.h"
 
 #include "KeyValues.h"
+#include "convar.h"
+#include "materialsystem/imaterialvar.h"
 #include "materialsystem/imesh.h"
 #include "materialsystem/itexture.h"
 #include "imgui/imgui.h"
 #include "imgui/imgui_internal.h"
 #include "pixelwriter.h"
 #include "filesystem.h"
+#include "imgui_system.h"
+#include "imgui_trace.h"
+#include "tier0/vprof.h"
+#include "utlvector.h"
+#include "vstdlib/jobthread.h"
 
 #include "vgui/ISystem.h"
 #include "vgui_controls/Controls.h"
 
 #include "tier0/memdbgon.h"
 
-static IMaterial *g_pFontMat = nullptr;
+static ConVar imgui_render_parallel( "imgui_render_parallel", "1", FCVAR_NONE, "Convert imgui vertices on the thread pool" );
+static ConVar imgui_render_parallel_min( "imgui_render_parallel_min", "4096", FCVAR_NONE, "Vertices a batch needs before it's converted on the thread pool" );
+static ConVar imgui_render_clip_cpu( "imgui_render_clip_cpu", "1", FCVAR_NONE, "Draw commands that fit their clip rect, or can be clipped on the CPU, without a scissor so they can share draw calls" );
+
+// Texture and material of each font atlas. There's usually one, a second exists while a
+// rebaked atlas is being uploaded.
+struct FontTexture_t
+{
+	ImFontAtlas *pAtlas;
+	ITexture *pTexture;
+	IMaterial *pMaterial;
+	int nUploadedRows;
+	bool bSDF;
+	float flSoftnessScale;	// Screen pixels per texel the SDF edge softness was set up for
+
+	// Region filled from pOverlay instead of the atlas, see ImGui_ImplSource_SetFontsTextureOverlay
+	const unsigned int *pOverlay;
+	Rect_t overlayRect;
+};
+
+static CUtlVector<FontTexture_t> g_FontTextures;
+static int g_nFontTextureSerial = 0;
+
+static FontTexture_t *FindFontTexture( ImTextureID tex );
+
+// Copy the part of the overlay inside rect into the texture
+static void CopyFontsTextureOverlay( const FontTexture_t *entry, unsigned char *dest, int width, const Rect_t &rect )
+{
+	const Rect_t &overlay = entry->overlayRect;
+	const int x0 = MAX( rect.x, overlay.x ), x1 = MIN( rect.x + rect.width, overlay.x + overlay.width );
+	const int y0 = MAX( rect.y, overlay.y ), y1 = MIN( rect.y + rect.height, overlay.y + overlay.height );
+	for ( int y = y0; y < y1; y++ )
+	{
+		const unsigned int *src = entry->pOverlay + (size_t)( y - overlay.y ) * overlay.width + ( x0 - overlay.x );
+		memcpy( dest + 4ULL * ( (size_t)y * width + x0 ), src, 4ULL * MAX( x1 - x0, 0 ) );
+	}
+}
 
 class CDearImGuiFontTextureRegenerator : public ITextureRegenerator
 {
 public:
-	CDearImGuiFontTextureRegenerator() = default;
+	CDearImGuiFontTextureRegenerator( ImFontAtlas *pAtlas ) : m_pAtlas( pAtlas ) {}
 
 	// Inherited from ITextureRegenerator
 	void RegenerateTextureBits( ITexture *pTexture, IVTFTexture *pVTFTexture, Rect_t *pRect ) override
 	{
-		ImGuiIO &io = ImGui::GetIO();
+		// Rects inside the overlay don't need the atlas, whose pixels may have been released
+		const FontTexture_t *entry = FindFontTexture( m_pAtlas->TexID );
+		const bool overlay = entry && entry->pOverlay;
+		if ( overlay && pRect && pRect->x >= entry->overlayRect.x && pRect->y >= entry->overlayRect.y &&
+			pRect->x + pRect->width <= entry->overlayRect.x + entry->overlayRect.width &&
+			pRect->y + pRect->height <= entry->overlayRect.y + entry->overlayRect.height )
+		{
+			CopyFontsTextureOverlay( entry, pVTFTexture->ImageData(), pVTFTexture->Width(), *pRect );
+			return;
+		}
+
+		ImFontAtlas scratch;
 		unsigned char *pixels;
 		int width, height;
-		io.Fonts->GetTexDataAsRGBA32( &pixels, &width, &height );
+		ImGui_ImplSource_GetFontsTexData( m_pAtlas, scratch, &pixels, &width, &height );
 
 		Assert( pVTFTexture->Width() == width );
 		Assert( pVTFTexture->Height() == height );
 		// if we ever use freetype for font loading, this should do format conversion instead
-		memcpy( pVTFTexture->ImageData(), pixels, 4ULL * width * height );
+		Rect_t full;
+		if ( !pRect )
+		{
+			memcpy( pVTFTexture->ImageData(), pixels, 4ULL * width * height );
+			full.x = full.y = 0;
+			full.width = width;
+			full.height = height;
+			pRect = &full;
+		}
+		else
+		{
+			// Partial download, only the rows being uploaded need to be valid
+			for ( int y = pRect->y; y < pRect->y + pRect->height; y++ )
+			{
+				const size_t offset = 4ULL * ( (size_t)y * width + pRect->x );
+				memcpy( pVTFTexture->ImageData() + offset, pixels + offset, 4ULL * pRect->width );
+			}
+		}
+
+		if ( overlay )
+			CopyFontsTextureOverlay( entry, pVTFTexture->ImageData(), width, *pRect );
 	}
 
 	void Release() override
 	{
 		delete this;
 	}
+
+private:
+	ImFontAtlas *m_pAtlas;
 };
 
+static FontTexture_t *FindFontTexture( ImTextureID tex )
+{
+	FOR_EACH_VEC( g_FontTextures, i )
+	{
+		if ( g_FontTextures[i].pMaterial == tex )
+			return &g_FontTextures[i];
+	}
+	return nullptr;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Pixels of an atlas that may have had them released after upload. Those are
+//  baked again into scratch, which gets copies of the atlas' fonts and rects, so the atlas
+//  imgui is using is never touched. The pixels live as long as scratch. Any thread.
+//---------------------------------------------------------------------------------------//
+void ImGui_ImplSource_GetFontsTexData( ImFontAtlas *atlas, ImFontAtlas &scratch, unsigned char **pixels, int *width, int *height )
+{
+	if ( atlas->TexPixelsRGBA32 )
+	{
+		*pixels = reinterpret_cast<unsigned char *>( atlas->TexPixelsRGBA32 );
+		*width = atlas->TexWidth;
+		*height = atlas->TexHeight;
+		return;
+	}
+
+	tmZone( TELEMETRY_LEVEL1, TMZF_NONE, "%s", __FUNCTION__ );
+
+	scratch.Flags = atlas->Flags;
+	scratch.TexDesiredWidth = atlas->TexDesiredWidth;
+	scratch.TexGlyphPadding = atlas->TexGlyphPadding;
+	scratch.FontBuilderIO = atlas->FontBuilderIO;
+	scratch.FontBuilderFlags = atlas->FontBuilderFlags;
+
+	// AddFont makes its own copy of data it doesn't own
+	for ( int i = 0; i < atlas->ConfigData.Size; i++ )
+	{
+		ImFontConfig config = atlas->ConfigData[i];
+		config.FontDataOwnedByAtlas = false;
+		config.DstFont = nullptr;
+		scratch.AddFont( &config );
+	}
+
+	// The same fonts and rects in the same order pack into the same layout. That includes
+	// the rects Build added for the mouse cursors and lines, so it mustn't add them again.
+	for ( int i = 0; i < atlas->CustomRects.Size; i++ )
+	{
+		const ImFontAtlasCustomRect &rect = atlas->CustomRects[i];
+		if ( rect.Font )
+			scratch.AddCustomRectFontGlyph( scratch.Fonts[atlas->Fonts.find_index( rect.Font )], rect.GlyphID, rect.Width, rect.Height, rect.GlyphAdvanceX, rect.GlyphOffset );
+		else
+			scratch.AddCustomRectRegular( rect.Width, rect.Height );
+	}
+	scratch.PackIdMouseCursors = atlas->PackIdMouseCursors;
+	scratch.PackIdLines = atlas->PackIdLines;
+
+	scratch.GetTexDataAsRGBA32( pixels, width, height );
+	Assert( *width == atlas->TexWidth && *height == atlas->TexHeight );
+
+	const FontTexture_t *entry = FindFontTexture( atlas->TexID );
+	if ( entry && entry->bSDF )
+		ImGui_ImplSource_BuildFontsSDF( &scratch );
+}
+
+// Felzenszwalb & Huttenlocher's 1D squared distance transform of f into d
+static void DistanceTransform1D( const float *f, float *d, int *v, float *z, int n )
+{
+	int k = 0;
+	v[0] = 0;
+	z[0] = -FLT_MAX;
+	z[1] = FLT_MAX;
+	for ( int q = 1; q < n; q++ )
+	{
+		float s = ( ( f[q] + q * q ) - ( f[v[k]] + v[k] * v[k] ) ) / ( 2 * q - 2 * v[k] );
+		while ( s <= z[k] )
+		{
+			k--;
+			s = ( ( f[q] + q * q ) - ( f[v[k]] + v[k] * v[k] ) ) / ( 2 * q - 2 * v[k] );
+		}
+		k++;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = FLT_MAX;
+	}
+
+	k = 0;
+	for ( int q = 0; q < n; q++ )
+	{
+		while ( z[k + 1] < q )
+			k++;
+		d[q] = ( q - v[k] ) * ( q - v[k] ) + f[v[k]];
+	}
+}
+
+// Squared distance from every texel to the nearest texel set to 0 in grid, in place
+static void DistanceTransform2D( float *grid, int width, int height )
+{
+	const int n = MAX( width, height );
+	CUtlVector<float> f, d, z;
+	CUtlVector<int> v;
+	f.SetCount( n );
+	d.SetCount( n );
+	z.SetCount( n + 1 );
+	v.SetCount( n );
+
+	for ( int x = 0; x < width; x++ )
+	{
+		for ( int y = 0; y < height; y++ )
+			f[y] = grid[y * width + x];
+		DistanceTransform1D( f.Base(), d.Base(), v.Base(), z.Base(), height );
+		for ( int y = 0; y < height; y++ )
+			grid[y * width + x] = d[y];
+	}
+
+	for ( int y = 0; y < height; y++ )
+	{
+		memcpy( f.Base(), grid + y * width, width * sizeof( float ) );
+		DistanceTransform1D( f.Base(), grid + y * width, v.Base(), z.Base(), width );
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Turn the coverage of a built atlas' glyphs into a signed distance field, 0.5
+//  alpha on the edge and IMGUI_FONT_SDF_SPREAD texels to either side. Custom rects are
+//  left as they are. Safe to call from any thread.
+//---------------------------------------------------------------------------------------//
+void ImGui_ImplSource_BuildFontsSDF( ImFontAtlas *atlas )
+{
+	tmZone( TELEMETRY_LEVEL1, TMZF_NONE, "%s", __FUNCTION__ );
+
+	const int width = atlas->TexWidth;
+	const int height = atlas->TexHeight;
+	unsigned char *pixels = atlas->TexPixelsRGBA32 ? reinterpret_cast<unsigned char *>( atlas->TexPixelsRGBA32 ) : nullptr;
+	if ( !pixels )
+		return;
+
+	// Only glyphs and the padding around them become a distance field. Custom rects keep
+	// their colors, including glyphs that point into them (icons).
+	CUtlVector<unsigned char> glyph;
+	glyph.SetCount( width * height );
+	V_memset( glyph.Base(), 0, width * height );
+	const int padding = atlas->TexGlyphPadding;
+	for ( int f = 0; f < atlas->Fonts.Size; f++ )
+	{
+		const ImFont *font = atlas->Fonts[f];
+		for ( int g = 0; g < font->Glyphs.Size; g++ )
+		{
+			const ImFontGlyph &fontGlyph = font->Glyphs[g];
+			const int x0 = MAX( static_cast<int>( fontGlyph.U0 * width ) - padding, 0 );
+			const int y0 = MAX( static_cast<int>( fontGlyph.V0 * height ) - padding, 0 );
+			const int x1 = MIN( static_cast<int>( ceilf( fontGlyph.U1 * width ) ) + padding, width );
+			const int y1 = MIN( static_cast<int>( ceilf( fontGlyph.V1 * height ) ) + padding, height );
+			for ( int y = y0; y < y1; y++ )
+				V_memset( glyph.Base() + y * width + x0, 1, MAX( x1 - x0, 0 ) );
+		}
+	}
+	for ( int r = 0; r < atlas->CustomRects.Size; r++ )
+	{
+		const ImFontAtlasCustomRect &rect = atlas->CustomRects[r];
+		if ( !rect.IsPacked() )
+			continue;
+		for ( int y = rect.Y; y < MIN( rect.Y + rect.Height, height ); y++ )
+			V_memset( glyph.Base() + y * width + rect.X, 0, MIN( rect.Width, width - rect.X ) );
+	}
+
+	const float unreached = 1e20f;
+	CUtlVector<float> outside, inside;
+	outside.SetCount( width * height );
+	inside.SetCount( width * height );
+	for ( int i = 0; i < width * height; i++ )
+	{
+		const bool in = glyph[i] && pixels[i * 4 + 3] >= 128;
+		outside[i] = in ? 0.0f : unreached;
+		inside[i] = in ? unreached : 0.0f;
+	}
+
+	DistanceTransform2D( outside.Base(), width, height );
+	DistanceTransform2D( inside.Base(), width, height );
+
+	// Texel centres are half a texel away from the edge between them
+	for ( int i = 0; i < width * height; i++ )
+	{
+		if ( !glyph[i] )
+			continue;
+
+		const float dist = inside[i] > 0.0f ? -( sqrtf( inside[i] ) - 0.5f ) : sqrtf( outside[i] ) - 0.5f;
+		const float alpha = clamp( 0.5f - dist / ( 2.0f * IMGUI_FONT_SDF_SPREAD ), 0.0f, 1.0f );
+		pixels[i * 4 + 0] = pixels[i * 4 + 1] = pixels[i * 4 + 2] = 255;
+		pixels[i * 4 + 3] = static_cast<unsigned char>( alpha * 255.0f + 0.5f );
+	}
+
+	// Solid shapes sample the white texel, it has to be well inside the field
+	const int white_x = static_cast<int>( atlas->TexUvWhitePixel.x * width );
+	const int white_y = static_cast<int>( atlas->TexUvWhitePixel.y * height );
+	for ( int y = MAX( white_y - 1, 0 ); y <= MIN( white_y + 1, height - 1 ); y++ )
+	{
+		for ( int x = MAX( white_x - 1, 0 ); x <= MIN( white_x + 1, width - 1 ); x++ )
+			pixels[( y * width + x ) * 4 + 3] = 255;
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Set an SDF font texture's edge softness to about one screen pixel at the
+//  given scale from atlas texels to screen pixels
+//---------------------------------------------------------------------------------------//
+void ImGui_ImplSource_SetFontsTextureScale( ImTextureID tex, float scale )
+{
+	FontTexture_t *entry = FindFontTexture( tex );
+	if ( !entry || !entry->bSDF || scale <= 0.0f || entry->flSoftnessScale == scale )
+		return;
+
+	entry->flSoftnessScale = scale;
+
+	// One screen pixel in distance field alpha units
+	const float softness = 1.0f / ( 2.0f * IMGUI_FONT_SDF_SPREAD * scale );
+
+	bool found;
+	IMaterialVar *start = entry->pMaterial->FindVar( "$edgesoftnessstart", &found, false );
+	if ( found )
+		start->SetFloatValue( 0.5f + softness * 0.5f );
+
+	IMaterialVar *end = entry->pMaterial->FindVar( "$edgesoftnessend", &found, false );
+	if ( found )
+		end->SetFloatValue( 0.5f - softness * 0.5f );
+}
+
 void ImGui_ImplSource_SetupRenderState( IMatRenderContext *ctx, ImDrawData *draw_data )
 {
+	IMGUI_TRACE_SCOPE( "SetupRenderState" );
+
 	// Apply imgui's display dimensions
 	ctx->Viewport( draw_data->DisplayPos.x, draw_data->DisplayPos.y, draw_data->DisplaySize.x, draw_data->DisplaySize.y );
 
@@ -84,11 +388,286 @@ void ImGui_ImplSource_SetupRenderState( IMatRenderContext *ctx, ImDrawData *draw
 	ctx->LoadIdentity();
 }
 
-void ImGui_ImplSource_RenderDrawData( ImDrawData *draw_data )
+// How a draw command is kept inside its clip rect
+enum ImGui_ImplSource_Clip
+{
+	ImGui_ImplSource_Clip_None,		// Its geometry is inside the clip rect already
+	ImGui_ImplSource_Clip_CPU,		// Clipped while it's converted
+	ImGui_ImplSource_Clip_Scissor,
+};
+
+// One draw command, converted into its slice of a batch's locked mesh
+struct ImGui_ImplSource_DrawItem
+{
+	const ImDrawList *cmd_list;
+	const ImDrawCmd *cmd;
+	int vtx_min;			// Lowest vertex the command references
+	int vtx_count;
+	int batch_vtx;			// Where the command's vertices and indices start in the batch
+	int batch_idx;
+	int clip;
+	ImDrawVert *clip_vtx;	// Scratch space for ImGui_ImplSource_Clip_CPU
+	ImDrawIdx *clip_idx;
+	IMesh *mesh;
+	const MeshDesc_t *desc;
+};
+
+// Axis aligned quad in the layout imgui's rects and glyphs use: top left, top right, bottom
+// right and bottom left, indexed 0 1 2 0 2 3. The texture coordinates have to be axis
+// aligned too, so the corners can be moved and their UVs interpolated.
+static bool ImGui_ImplSource_IsQuad( const ImDrawIdx *idx, const ImDrawVert *vtx )
+{
+	const unsigned int a = idx[0];
+	if ( idx[1] != a + 1 || idx[2] != a + 2 || idx[3] != a || idx[4] != a + 2 || idx[5] != a + 3 )
+		return false;
+
+	const ImDrawVert *v = vtx + a;
+	return v[0].pos.y == v[1].pos.y && v[1].pos.x == v[2].pos.x && v[2].pos.y == v[3].pos.y && v[3].pos.x == v[0].pos.x &&
+		   v[0].uv.y == v[1].uv.y && v[1].uv.x == v[2].uv.x && v[2].uv.y == v[3].uv.y && v[3].uv.x == v[0].uv.x &&
+		   v[0].col == v[1].col && v[0].col == v[2].col && v[0].col == v[3].col;
+}
+
+static void ImGui_ImplSource_ClipQuad( ImDrawVert *v, const ImVec4 &clip )
+{
+	const ImVec2 p0 = v[0].pos, p2 = v[2].pos, uv0 = v[0].uv, uv2 = v[2].uv;
+	for ( int i = 0; i < 4; i++ )
+	{
+		const float x = ImClamp( v[i].pos.x, clip.x, clip.z );
+		const float y = ImClamp( v[i].pos.y, clip.y, clip.w );
+		if ( p2.x != p0.x )
+			v[i].uv.x = uv0.x + ( x - p0.x ) * ( uv2.x - uv0.x ) / ( p2.x - p0.x );
+		if ( p2.y != p0.y )
+			v[i].uv.y = uv0.y + ( y - p0.y ) * ( uv2.y - uv0.y ) / ( p2.y - p0.y );
+		v[i].pos = ImVec2( x, y );
+	}
+}
+
+// 0 inside the clip rect, 1 outside, 2 crossing its edge
+static int ImGui_ImplSource_ClipTest( const ImVec2 &mins, const ImVec2 &maxs, const ImVec4 &clip )
+{
+	if ( maxs.x <= clip.x || mins.x >= clip.z || maxs.y <= clip.y || mins.y >= clip.w )
+		return 1;
+	if ( mins.x >= clip.x && maxs.x <= clip.z && mins.y >= clip.y && maxs.y <= clip.w )
+		return 0;
+	return 2;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Clip a command's quads to its clip rect and collapse the triangles outside it.
+//  Returns false if a triangle that isn't part of a quad crosses the edge, which needs a
+//  scissor. Without clip_vtx it only checks, clip_vtx and clip_idx hold copies of the
+//  command's vertices from vtx_min and its indices otherwise.
+//---------------------------------------------------------------------------------------//
+static bool ImGui_ImplSource_ClipCommand( const ImDrawList *cmd_list, const ImDrawCmd *cmd, int vtx_min, ImDrawVert *clip_vtx, ImDrawIdx *clip_idx )
+{
+	const ImDrawIdx *idx = cmd_list->IdxBuffer.Data + cmd->IdxOffset;
+	const ImDrawVert *vtx = cmd_list->VtxBuffer.Data + cmd->VtxOffset;
+	const ImVec4 &clip = cmd->ClipRect;
+	const unsigned int count = cmd->ElemCount;
+
+	for ( unsigned int i = 0; i + 3 <= count; )
+	{
+		if ( i + 6 <= count && ImGui_ImplSource_IsQuad( idx + i, vtx ) )
+		{
+			const ImDrawVert *v = vtx + idx[i];
+			const int test = ImGui_ImplSource_ClipTest( ImMin( v[0].pos, v[2].pos ), ImMax( v[0].pos, v[2].pos ), clip );
+			if ( clip_vtx && test == 1 )
+			{
+				for ( int n = 1; n < 6; n++ )
+					clip_idx[i + n] = clip_idx[i];
+			}
+			else if ( clip_vtx && test == 2 )
+			{
+				// Vertices shared with other triangles can only move if they're outside
+				// the clip rect, which makes those triangles collapse or fail the check
+				ImGui_ImplSource_ClipQuad( clip_vtx + idx[i] - vtx_min, clip );
+			}
+			i += 6;
+			continue;
+		}
+
+		const ImVec2 &a = vtx[idx[i]].pos, &b = vtx[idx[i + 1]].pos, &c = vtx[idx[i + 2]].pos;
+		const int test = ImGui_ImplSource_ClipTest( ImMin( a, ImMin( b, c ) ), ImMax( a, ImMax( b, c ) ), clip );
+		if ( test == 2 )
+			return false;
+		if ( clip_vtx && test == 1 )
+			clip_idx[i + 1] = clip_idx[i + 2] = clip_idx[i];
+		i += 3;
+	}
+
+	return true;
+}
+
+// Works out how a command should be clipped, on the main thread while batches are planned
+static int ImGui_ImplSource_ClassifyClip( const ImDrawList *cmd_list, const ImDrawCmd *cmd, int vtx_min, int vtx_count )
+{
+	if ( !imgui_render_clip_cpu.GetBool() )
+		return ImGui_ImplSource_Clip_Scissor;
+
+	const ImDrawVert *vtx = cmd_list->VtxBuffer.Data + cmd->VtxOffset + vtx_min;
+	ImVec2 mins = vtx[0].pos, maxs = vtx[0].pos;
+	for ( int i = 1; i < vtx_count; i++ )
+	{
+		mins = ImMin( mins, vtx[i].pos );
+		maxs = ImMax( maxs, vtx[i].pos );
+	}
+
+	const ImVec4 &clip = cmd->ClipRect;
+	if ( mins.x >= clip.x && mins.y >= clip.y && maxs.x <= clip.z && maxs.y <= clip.w )
+		return ImGui_ImplSource_Clip_None;
+
+	return ImGui_ImplSource_ClipCommand( cmd_list, cmd, vtx_min, nullptr, nullptr ) ? ImGui_ImplSource_Clip_CPU : ImGui_ImplSource_Clip_Scissor;
+}
+
+// Runs on thread pool workers. Each item writes its own range of the locked buffers.
+static void ImGui_ImplSource_ConvertDrawItem( ImGui_ImplSource_DrawItem &item )
+{
+	IMGUI_TRACE_SCOPE( "ConvertDrawItem" );
+
+	MeshDesc_t desc = *item.desc;
+	desc.m_pPosition = reinterpret_cast<float *>( reinterpret_cast<unsigned char *>( desc.m_pPosition ) + item.batch_vtx * desc.m_VertexSize_Position );
+	desc.m_pColor += item.batch_vtx * desc.m_VertexSize_Color;
+	desc.m_pTexCoord[0] = reinterpret_cast<float *>( reinterpret_cast<unsigned char *>( desc.m_pTexCoord[0] ) + item.batch_vtx * desc.m_VertexSize_TexCoord[0] );
+	desc.m_pIndices += item.batch_idx;
+
+	const ImDrawVert *vtx_src = item.cmd_list->VtxBuffer.Data + item.cmd->VtxOffset + item.vtx_min;
+	const ImDrawIdx *idx_src = item.cmd_list->IdxBuffer.Data + item.cmd->IdxOffset;
+	if ( item.clip == ImGui_ImplSource_Clip_CPU )
+	{
+		V_memcpy( item.clip_vtx, vtx_src, item.vtx_count * sizeof( ImDrawVert ) );
+		V_memcpy( item.clip_idx, idx_src, item.cmd->ElemCount * sizeof( ImDrawIdx ) );
+		ImGui_ImplSource_ClipCommand( item.cmd_list, item.cmd, item.vtx_min, item.clip_vtx, item.clip_idx );
+		vtx_src = item.clip_vtx;
+		idx_src = item.clip_idx;
+	}
+
+	CVertexBuilder vb;
+	vb.AttachBegin( item.mesh, item.vtx_count, desc );
+	for ( int i = 0; i < item.vtx_count; i++ )
+	{
+		vb.Position3f( Vector2DExpand( vtx_src->pos ), 0 );
+		vb.Color4ubv( reinterpret_cast<const unsigned char*>( &vtx_src->col ) );
+		vb.TexCoord2fv( 0, &vtx_src->uv.x );
+		vb.AdvanceVertexF<VTX_HAVEPOS | VTX_HAVECOLOR, 1>();
+		vtx_src++;
+	}
+	vb.AttachEnd();
+
+	CIndexBuilder ib;
+	ib.AttachBegin( item.mesh, item.cmd->ElemCount, desc );
+	ib.FastIndexList( idx_src, item.batch_vtx - item.vtx_min, item.cmd->ElemCount );
+	ib.AttachEnd();
+}
+
+// Copies of the commands clipped on the CPU, reused between frames
+static CUtlVector<ImDrawVert> g_ClipVertices;
+static CUtlVector<ImDrawIdx> g_ClipIndices;
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Lock one dynamic mesh for a run of commands sharing a texture, fill it (in
+//  parallel when it's big enough) and draw it. Commands that need a scissor are drawn as
+//  their own range of it, runs of the others are drawn together. Returns the draw calls.
+//---------------------------------------------------------------------------------------//
+static int ImGui_ImplSource_DrawBatch( IMatRenderContext *ctx, ImGui_ImplSource_DrawItem *items, int count, int vtx_total, int idx_total, const ImVec2 &clip_off )
+{
+	if ( !count )
+		return 0;
+
+	IMaterial *material = static_cast<IMaterial*>( items[0].cmd->GetTexID() );
+	IMesh *mesh = ctx->GetDynamicMeshEx( VERTEX_POSITION | VERTEX_COLOR | VERTEX_TEXCOORD_SIZE( 0, 2 ), false, nullptr, nullptr, material );
+
+	MeshDesc_t desc;
+	{
+		IMGUI_TRACE_SCOPE( "LockMesh" );
+		mesh->LockMesh( vtx_total, idx_total, desc );
+	}
+
+	int clip_vtx = 0, clip_idx = 0;
+	for ( int i = 0; i < count; i++ )
+	{
+		items[i].mesh = mesh;
+		items[i].desc = &desc;
+		if ( items[i].clip == ImGui_ImplSource_Clip_CPU )
+		{
+			clip_vtx += items[i].vtx_count;
+			clip_idx += items[i].cmd->ElemCount;
+		}
+	}
+
+	// Each CPU clipped command gets its own slice of the scratch buffers
+	if ( clip_vtx )
+	{
+		g_ClipVertices.EnsureCount( clip_vtx );
+		g_ClipIndices.EnsureCount( clip_idx );
+		clip_vtx = clip_idx = 0;
+		for ( int i = 0; i < count; i++ )
+		{
+			if ( items[i].clip != ImGui_ImplSource_Clip_CPU )
+				continue;
+
+			items[i].clip_vtx = g_ClipVertices.Base() + clip_vtx;
+			items[i].clip_idx = g_ClipIndices.Base() + clip_idx;
+			clip_vtx += items[i].vtx_count;
+			clip_idx += items[i].cmd->ElemCount;
+		}
+	}
+
+	if ( imgui_render_parallel.GetBool() && count > 1 && vtx_total >= imgui_render_parallel_min.GetInt() )
+	{
+		tmZone( TELEMETRY_LEVEL1, TMZF_NONE, "ImGui parallel convert" );
+		IMGUI_TRACE_SCOPE( "Convert" );
+		ParallelProcess( items, count, &ImGui_ImplSource_ConvertDrawItem );
+	}
+	else
+	{
+		IMGUI_TRACE_SCOPE( "Convert" );
+		for ( int i = 0; i < count; i++ )
+			ImGui_ImplSource_ConvertDrawItem( items[i] );
+	}
+
+	{
+		IMGUI_TRACE_SCOPE( "UnlockMesh" );
+		mesh->UnlockMesh( vtx_total, idx_total, desc );
+	}
+
+	IMGUI_TRACE_SCOPE( "Draw" );
+	int draw_calls = 0;
+	for ( int i = 0; i < count; draw_calls++ )
+	{
+		const ImDrawCmd *pcmd = items[i].cmd;
+		if ( items[i].clip != ImGui_ImplSource_Clip_Scissor )
+		{
+			// Commands are laid out in the mesh in order, so a run is one range of it
+			const int first_idx = items[i].batch_idx;
+			int idx_count = 0;
+			for ( ; i < count && items[i].clip != ImGui_ImplSource_Clip_Scissor; i++ )
+				idx_count += items[i].cmd->ElemCount;
+
+			mesh->Draw( first_idx, idx_count );
+			continue;
+		}
+
+		const float clipmin_x = pcmd->ClipRect.x - clip_off.x, clipmin_y = pcmd->ClipRect.y - clip_off.y;
+		const float clipmax_x = pcmd->ClipRect.z - clip_off.x, clipmax_y = pcmd->ClipRect.w - clip_off.y;
+
+		ctx->SetScissorRect( clipmin_x, clipmin_y, clipmax_x, clipmax_y, true );
+		mesh->Draw( items[i].batch_idx, pcmd->ElemCount );
+		ctx->SetScissorRect( clipmin_x, clipmin_y, clipmax_x, clipmax_y, false );
+		i++;
+	}
+
+	return draw_calls;
+}
+
+int ImGui_ImplSource_RenderDrawData( ImDrawData *draw_data )
 {
+	VPROF_BUDGET( "ImGui_ImplSource_RenderDrawData", VPROF_BUDGETGROUP_IMGUI );
+	tmZone( TELEMETRY_LEVEL1, TMZF_NONE, "%s", __FUNCTION__ );
+	IMGUI_TRACE_SCOPE( "RenderDrawData" );
+
 	// Avoid rendering when minimized
 	if ( draw_data->DisplaySize.x <= 0.0f || draw_data->DisplaySize.y <= 0.0f )
-		return;
+		return 0;
 
 	CMatRenderContextPtr ctx( materials );
 
@@ -99,64 +678,107 @@ void ImGui_ImplSource_RenderDrawData( ImDrawData *draw_data )
 
 	ImGui_ImplSource_SetupRenderState( ctx, draw_data );
 
-	// Render command lists
+	// Commands are batched until the texture changes, a callback runs or the dynamic mesh
+	// is full. Offsets into the batch are worked out here so conversion can be split up.
+	static CUtlVector<ImGui_ImplSource_DrawItem> items;
+	items.RemoveAll();
+
+	int nDrawCalls = 0, nVertices = 0, nIndices = 0;
+	int batch_start = 0, batch_vtx = 0, batch_idx = 0;
+	int max_vtx = 0, max_idx = 0;
+	ImTextureID batch_tex = nullptr;
 	ImVec2 clip_off = draw_data->DisplayPos;
+
+	auto flush = [&]()
+	{
+		nDrawCalls += ImGui_ImplSource_DrawBatch( ctx, items.Base() + batch_start, items.Count() - batch_start, batch_vtx, batch_idx, clip_off );
+		nVertices += batch_vtx;
+		nIndices += batch_idx;
+		batch_start = items.Count();
+		batch_vtx = batch_idx = 0;
+	};
+
 	for ( int n = 0; n < draw_data->CmdListsCount; n++ )
 	{
 		const ImDrawList *cmd_list = draw_data->CmdLists[n];
 		const ImDrawIdx *idx_buffer = cmd_list->IdxBuffer.Data;
 
-		// Draw the mesh
 		for ( int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++ )
 		{
 			const ImDrawCmd *pcmd = &cmd_list->CmdBuffer[cmd_i];
 			if ( pcmd->UserCallback != nullptr )
 			{
+				// Callbacks see everything before them drawn
+				flush();
+
 				// User callback, registered via ImDrawList::AddCallback()
 				// (ImDrawCallback_ResetRenderState is a special callback value used by the user to request the renderer to reset render state.)
 				if ( pcmd->UserCallback == ImDrawCallback_ResetRenderState )
 					ImGui_ImplSource_SetupRenderState( ctx, draw_data );
 				else
 					pcmd->UserCallback( cmd_list, pcmd );
+				continue;
+			}
+
+			if ( !pcmd->GetTexID() || !pcmd->ElemCount )
+				continue;
+
+			// Avoid rendering completely clipped draws
+			if ( pcmd->ClipRect.z <= pcmd->ClipRect.x || pcmd->ClipRect.w <= pcmd->ClipRect.y )
+				continue;
+
+			// Only upload the vertices this command references, a list holds the
+			// vertices of all its commands
+			const ImDrawIdx *cmd_idx = idx_buffer + pcmd->IdxOffset;
+			int vtx_min = INT_MAX, vtx_max = -1;
+			for ( unsigned int i = 0; i < pcmd->ElemCount; i++ )
+			{
+				vtx_min = MIN( vtx_min, (int)cmd_idx[i] );
+				vtx_max = MAX( vtx_max, (int)cmd_idx[i] );
+			}
+			const int vtx_count = vtx_max - vtx_min + 1;
+
+			if ( pcmd->GetTexID() != batch_tex )
+			{
+				flush();
+				batch_tex = pcmd->GetTexID();
+				max_vtx = ctx->GetMaxVerticesToRender( static_cast<IMaterial*>( batch_tex ) );
+				max_idx = ctx->GetMaxIndicesToRender();
 			}
-			else
+			else if ( batch_vtx + vtx_count > max_vtx || batch_idx + (int)pcmd->ElemCount > max_idx )
 			{
-				if ( pcmd->GetTexID() )
-				{
-					Vector2D clipmin = { pcmd->ClipRect.x - clip_off.x, pcmd->ClipRect.y - clip_off.y };
-					Vector2D clipmax = { pcmd->ClipRect.z - clip_off.x, pcmd->ClipRect.w - clip_off.y };
-
-					// Avoid rendering completely clipped draws
-					if ( clipmax.x <= clipmin.x || clipmax.y <= clipmin.y )
-						continue;
-
-					ctx->SetScissorRect( clipmin.x, clipmin.y, clipmax.x, clipmax.y, true );
-					IMesh *mesh = ctx->GetDynamicMesh( false, nullptr, nullptr, static_cast<IMaterial*>( pcmd->GetTexID() ) );
-					CMeshBuilder mb;
-					mb.Begin( mesh, MATERIAL_TRIANGLES, cmd_list->VtxBuffer.Size, pcmd->ElemCount );
-
-					const ImDrawVert *vtx_src = cmd_list->VtxBuffer.Data;
-					for ( int i = 0; i < cmd_list->VtxBuffer.Size; i++ )
-					{
-						mb.Position3f( Vector2DExpand( vtx_src->pos ), 0 );
-						mb.Color4ubv( reinterpret_cast<const unsigned char*>( &vtx_src->col ) );
-						mb.TexCoord2fv( 0, &vtx_src->uv.x );
-						mb.AdvanceVertexF<VTX_HAVEPOS | VTX_HAVECOLOR, 1>();
-						vtx_src++;
-					}
-
-					static_cast<CIndexBuilder &>( mb ).FastIndexList( idx_buffer + pcmd->IdxOffset, 0, pcmd->ElemCount );
-					mb.End( false, true );
-					ctx->SetScissorRect( clipmin.x, clipmin.y, clipmax.x, clipmax.y, false );
-				}
+				flush();
 			}
+
+			ImGui_ImplSource_DrawItem &item = items[items.AddToTail()];
+			item.cmd_list = cmd_list;
+			item.cmd = pcmd;
+			item.vtx_min = vtx_min;
+			item.vtx_count = vtx_count;
+			item.batch_vtx = batch_vtx;
+			item.batch_idx = batch_idx;
+			item.clip = ImGui_ImplSource_ClassifyClip( cmd_list, pcmd, vtx_min, vtx_count );
+			item.clip_vtx = nullptr;
+			item.clip_idx = nullptr;
+			batch_vtx += vtx_count;
+			batch_idx += pcmd->ElemCount;
 		}
 	}
 
+	flush();
+
 	ctx->MatrixMode( MATERIAL_PROJECTION );
 	ctx->PopMatrix();
 	ctx->MatrixMode( MATERIAL_VIEW );
 	ctx->PopMatrix();
+
+	// Vertices counts what was actually uploaded, which can exceed the draw data's total
+	VPROF_INCREMENT_COUNTER( "ImGui draw calls", nDrawCalls );
+	VPROF_INCREMENT_COUNTER( "ImGui vertices", nVertices );
+	VPROF_INCREMENT_COUNTER( "ImGui vertex bytes", nVertices * ( 3 * sizeof( float ) + 4 + 2 * sizeof( float ) ) );
+	VPROF_INCREMENT_COUNTER( "ImGui indices", nIndices );
+
+	return nDrawCalls;
 }
 
 bool ImGui_ImplSource_Init()
@@ -199,53 +821,155 @@ bool ImGui_ImplSource_Init()
 void ImGui_ImplSource_Shutdown()
 {
 	ImGui_ImplSource_InvalidateDeviceObjects();
+	g_ClipVertices.Purge();
+	g_ClipIndices.Purge();
 }
 
-static bool ImGui_ImplSource_CreateFontsTexture()
+//---------------------------------------------------------------------------------------//
+// Purpose: Create the texture and material for a font atlas, building the atlas if it
+//  hasn't been yet. Textures that aren't uploaded right away are filled in over several
+//  frames with ImGui_ImplSource_UploadFontsTexture.
+//---------------------------------------------------------------------------------------//
+ImTextureID ImGui_ImplSource_CreateFontsTexture( ImFontAtlas *atlas, bool upload, bool sdf )
 {
-	if ( g_pFontMat )
-		return true;
-
-	// Build texture atlas
-	ImGuiIO &io = ImGui::GetIO();
 	int width, height;
 	unsigned char* pixels;
-	io.Fonts->GetTexDataAsRGBA32( &pixels, &width, &height );
+	atlas->GetTexDataAsRGBA32( &pixels, &width, &height );
+
+	// Names have to be unique, the previous atlas is still alive while a new one uploads
+	const int serial = g_nFontTextureSerial++;
+	char texname[32], matname[32];
+	V_snprintf( texname, sizeof( texname ), "imgui_font_%d", serial );
+	V_snprintf( matname, sizeof( matname ), "imgui_font_mat_%d", serial );
 
 	// Create a material for the texture
-	ITexture *fonttex = g_pMaterialSystem->CreateProceduralTexture( "imgui_font", TEXTURE_GROUP_OTHER, width, height, IMAGE_FORMAT_RGBA8888, TEXTUREFLAGS_NOMIP | TEXTUREFLAGS_POINTSAMPLE | TEXTUREFLAGS_PROCEDURAL | TEXTUREFLAGS_SINGLECOPY | TEXTUREFLAGS_NOLOD );
-	fonttex->SetTextureRegenerator( new CDearImGuiFontTextureRegenerator );
-	fonttex->Download();
+	// Distance fields need bilinear filtering to reconstruct the edge
+	const int filter = sdf ? 0 : TEXTUREFLAGS_POINTSAMPLE;
+	ITexture *fonttex = g_pMaterialSystem->CreateProceduralTexture( texname, TEXTURE_GROUP_OTHER, width, height, IMAGE_FORMAT_RGBA8888, TEXTUREFLAGS_NOMIP | filter | TEXTUREFLAGS_PROCEDURAL | TEXTUREFLAGS_SINGLECOPY | TEXTUREFLAGS_NOLOD );
+	fonttex->SetTextureRegenerator( new CDearImGuiFontTextureRegenerator( atlas ) );
+	if ( upload )
+		fonttex->Download();
 
 	KeyValues *vmt = new KeyValues( "UnlitGeneric" );
-	vmt->SetString( "$basetexture", "imgui_font" );
+	vmt->SetString( "$basetexture", texname );
 	vmt->SetInt( "$nocull", 1 );
 	vmt->SetInt( "$vertexcolor", 1 );
 	vmt->SetInt( "$vertexalpha", 1 );
 	vmt->SetInt( "$translucent", 1 );
-	g_pFontMat = materials->CreateMaterial( "imgui_font_mat", vmt );
-	g_pFontMat->AddRef();
+	if ( sdf )
+	{
+		vmt->SetInt( "$distancealpha", 1 );
+		vmt->SetInt( "$softedges", 1 );
+		vmt->SetFloat( "$edgesoftnessstart", 0.55f );
+		vmt->SetFloat( "$edgesoftnessend", 0.45f );
+	}
+	IMaterial *fontmat = materials->CreateMaterial( matname, vmt );
+	fontmat->AddRef();
+
+	FontTexture_t &entry = g_FontTextures[g_FontTextures.AddToTail()];
+	entry.pAtlas = atlas;
+	entry.pTexture = fonttex;
+	entry.pMaterial = fontmat;
+	entry.nUploadedRows = upload ? height : 0;
+	entry.bSDF = sdf;
+	entry.flSoftnessScale = 0.0f;
+	entry.pOverlay = nullptr;
+	V_memset( &entry.overlayRect, 0, sizeof( entry.overlayRect ) );
 
 	// Store our identifier
-	io.Fonts->SetTexID( g_pFontMat );
+	atlas->SetTexID( fontmat );
 
+	return fontmat;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Upload the next rows of a font texture. Returns true once all of it is on the GPU.
+//---------------------------------------------------------------------------------------//
+bool ImGui_ImplSource_UploadFontsTexture( ImTextureID tex, int rows )
+{
+	FontTexture_t *entry = FindFontTexture( tex );
+	if ( !entry )
+		return false;
+
+	const int height = entry->pAtlas->TexHeight;
+	if ( entry->nUploadedRows >= height )
+		return true;
+
+	Rect_t rect;
+	rect.x = 0;
+	rect.y = entry->nUploadedRows;
+	rect.width = entry->pAtlas->TexWidth;
+	rect.height = MIN( MAX( rows, 1 ), height - entry->nUploadedRows );
+	entry->pTexture->Download( &rect );
+
+	entry->nUploadedRows += rect.height;
+	return entry->nUploadedRows >= height;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Overlay regions, see imgui_impl_source.h
+//---------------------------------------------------------------------------------------//
+bool ImGui_ImplSource_SetFontsTextureOverlay( ImTextureID tex, const unsigned int *pixels, int x, int y, int width, int height )
+{
+	FontTexture_t *entry = FindFontTexture( tex );
+	if ( !entry )
+		return false;
+
+	entry->pOverlay = pixels;
+	entry->overlayRect.x = x;
+	entry->overlayRect.y = y;
+	entry->overlayRect.width = pixels ? width : 0;
+	entry->overlayRect.height = pixels ? height : 0;
 	return true;
 }
 
-bool ImGui_ImplSource_CreateDeviceObjects()
+void ImGui_ImplSource_UpdateFontsTextureRect( ImTextureID tex, int x, int y, int width, int height )
 {
-	return ImGui_ImplSource_CreateFontsTexture();
+	FontTexture_t *entry = FindFontTexture( tex );
+	if ( !entry )
+		return;
+
+	Rect_t rect;
+	rect.x = x;
+	rect.y = y;
+	rect.width = width;
+	rect.height = height;
+	entry->pTexture->Download( &rect );
 }
 
-void ImGui_ImplSource_InvalidateDeviceObjects()
+void ImGui_ImplSource_DestroyFontsTexture( ImTextureID tex )
 {
-	if ( g_pFontMat )
+	FOR_EACH_VEC( g_FontTextures, i )
 	{
-		g_pFontMat->DecrementReferenceCount();
-		g_pFontMat = nullptr;
+		FontTexture_t &entry = g_FontTextures[i];
+		if ( entry.pMaterial != tex )
+			continue;
+
+		entry.pMaterial->DecrementReferenceCount();
+		entry.pTexture->SetTextureRegenerator( nullptr );
+		entry.pTexture->DecrementReferenceCount();
+		entry.pTexture->DeleteIfUnreferenced();
+
+		g_FontTextures.Remove( i );
+		return;
 	}
 }
 
+bool ImGui_ImplSource_CreateDeviceObjects()
+{
+	ImFontAtlas *atlas = ImGui::GetIO().Fonts;
+	if ( FindFontTexture( atlas->TexID ) )
+		return true;
+
+	return ImGui_ImplSource_CreateFontsTexture( atlas, true, false ) != nullptr;
+}
+
+void ImGui_ImplSource_InvalidateDeviceObjects()
+{
+	while ( g_FontTextures.Count() )
+		ImGui_ImplSource_DestroyFontsTexture( g_FontTextures.Tail().pMaterial );
+}
+
 // The following functions are declared in imconfig_source.h and must not be renamed
 
 ImFileHandle ImFileOpen( const char *filename, const char *mode )
@@ -28,7 +28,27 @@
 struct ImDrawData;
 bool     ImGui_ImplSource_Init();
 void     ImGui_ImplSource_Shutdown();
-void     ImGui_ImplSource_RenderDrawData(ImDrawData* draw_data);
+int      ImGui_ImplSource_RenderDrawData(ImDrawData* draw_data);     // Returns the number of draw calls issued
+
+// Texels either side of the edge covered by signed distance field fonts. Atlases baked as
+// SDFs need at least this much glyph padding.
+#define IMGUI_FONT_SDF_SPREAD 4
+
+// Font atlas textures. An atlas can be given a new texture while the old one is in use,
+// created without uploading and then uploaded a few rows per frame. SDF textures are drawn
+// with a distance alpha material and stay sharp at any scale.
+ImTextureID ImGui_ImplSource_CreateFontsTexture(ImFontAtlas* atlas, bool upload, bool sdf);
+bool     ImGui_ImplSource_UploadFontsTexture(ImTextureID tex, int rows);    // Returns true once fully uploaded
+void     ImGui_ImplSource_DestroyFontsTexture(ImTextureID tex);
+void     ImGui_ImplSource_GetFontsTexData(ImFontAtlas* atlas, ImFontAtlas& scratch, unsigned char** pixels, int* width, int* height);   // Bakes released pixels into scratch, never the atlas
+void     ImGui_ImplSource_BuildFontsSDF(ImFontAtlas* atlas);                    // Converts a built atlas to a distance field, any thread
+void     ImGui_ImplSource_SetFontsTextureScale(ImTextureID tex, float scale);  // Screen pixels per atlas texel, sets SDF edge softness
+
+// A region of a font texture whose pixels come from the caller rather than the atlas, for glyphs
+// rasterized after the atlas was built. The pixels are RGBA32 like the atlas, and must stay valid
+// until the overlay is cleared with null pixels. Changes to it are uploaded as just the given rect.
+bool     ImGui_ImplSource_SetFontsTextureOverlay(ImTextureID tex, const unsigned int* pixels, int x, int y, int width, int height);
+void     ImGui_ImplSource_UpdateFontsTextureRect(ImTextureID tex, int x, int y, int width, int height);
 
 // Use if you want to reset your rendering device without losing Dear ImGui state.
 bool     ImGui_ImplSource_CreateDeviceObjects();
@@ -145,3 +165,30 @@ constexpr ImGuiKey IMGUI_KEY_TABLE[] = {
 	/*KEY_NUMLOCKTOGGLE*/	ImGuiKey_None,			// ?
 	/*KEY_SCROLLLOCKTOGGLE*/ImGuiKey_None,			// ?
 };
+
+// imgui matches shortcuts against the ImGuiMod_ keys, which vgui doesn't have.
+// Call after adding the key event itself.
+inline void ImGui_ImplSource_AddModifierEvent(ImGuiIO& io, ImGuiKey key, bool down)
+{
+	switch (key)
+	{
+	case ImGuiKey_LeftCtrl:
+	case ImGuiKey_RightCtrl:
+		io.AddKeyEvent(ImGuiMod_Ctrl, down);
+		break;
+	case ImGuiKey_LeftShift:
+	case ImGuiKey_RightShift:
+		io.AddKeyEvent(ImGuiMod_Shift, down);
+		break;
+	case ImGuiKey_LeftAlt:
+	case ImGuiKey_RightAlt:
+		io.AddKeyEvent(ImGuiMod_Alt, down);
+		break;
+	case ImGuiKey_LeftSuper:
+	case ImGuiKey_RightSuper:
+		io.AddKeyEvent(ImGuiMod_Super, down);
+		break;
+	default:
+		break;
+	}
+}
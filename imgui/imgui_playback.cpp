@@ -0,0 +1,416 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#include "imgui_playback.h"
+#include "imgui_window.h"
+
+#include "filesystem.h"
+#include "fmtstr.h"
+#include "imgui_impl_source.h"
+#include "inputsystem/iinputsystem.h"
+#include "KeyValues.h"
+#include "tier2/tier2.h"
+#include "imgui/imgui.h"
+
+#include "tier0/memdbgon.h"
+
+static ConVar imgui_playback_tolerance( "imgui_playback_tolerance", "0.15", FCVAR_NONE, "Fraction a playback frame may exceed its baseline CPU time by before it is reported" );
+static ConVar imgui_playback_noise_floor( "imgui_playback_noise_floor", "0.05", FCVAR_NONE, "CPU time differences below this many milliseconds are never reported" );
+
+CDearImGuiPlayback g_ImGuiPlayback;
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Load a script and take over the registered windows
+//---------------------------------------------------------------------------------------//
+bool CDearImGuiPlayback::Start( const char *pszScript, bool bRecordBaseline )
+{
+	if ( m_bActive )
+	{
+		Warning( "imgui_playback: %s is still running\n", m_Script.Get() );
+		return false;
+	}
+
+	KeyValues *pScript = new KeyValues( "ImGuiPlayback" );
+	KeyValues::AutoDelete autoDelete( pScript );
+
+	CFmtStr path( "%s/%s.txt", IMGUI_PLAYBACK_DIR, pszScript );
+	if ( !pScript->LoadFromFile( g_pFullFileSystem, path, "MOD" ) )
+	{
+		Warning( "imgui_playback: Failed to load %s\n", path.Get() );
+		return false;
+	}
+
+	m_nFrameCount = pScript->GetInt( "frames", 0 );
+	m_flDeltaTime = pScript->GetFloat( "deltatime", 1.0f / 60.0f );
+	if ( m_nFrameCount <= 0 || m_flDeltaTime <= 0.0f )
+	{
+		Warning( "imgui_playback: %s needs a positive frame count and delta time\n", path.Get() );
+		return false;
+	}
+
+	m_Windows.RemoveAll();
+	KeyValues *pWindows = pScript->FindKey( "windows" );
+	for ( KeyValues *pKey = pWindows ? pWindows->GetFirstSubKey() : nullptr; pKey; pKey = pKey->GetNextKey() )
+	{
+		IImguiWindow *pWindow = g_pImguiSystem->FindWindow( pKey->GetName() );
+		if ( !pWindow )
+		{
+			Warning( "imgui_playback: Unknown window %s\n", pKey->GetName() );
+			return false;
+		}
+
+		PlaybackWindow_t &window = m_Windows[m_Windows.AddToTail()];
+		window.pWindow = pWindow;
+		window.bPlaced = pKey->FindKey( "w" ) != nullptr;
+		window.x = pKey->GetFloat( "x" );
+		window.y = pKey->GetFloat( "y" );
+		window.w = pKey->GetFloat( "w" );
+		window.h = pKey->GetFloat( "h" );
+	}
+
+	if ( m_Windows.IsEmpty() )
+	{
+		Warning( "imgui_playback: %s does not list any windows\n", path.Get() );
+		return false;
+	}
+
+	if ( !ParseEvents( pScript->FindKey( "events" ) ) )
+		return false;
+
+	// Only the scripted windows take part, everything else is restored in Stop
+	g_pImguiSystem->GetAllWindows( m_SavedWindows );
+	m_SavedDrawState.SetCount( m_SavedWindows.Count() );
+	FOR_EACH_VEC( m_SavedWindows, i )
+	{
+		m_SavedDrawState[i] = m_SavedWindows[i]->ShouldDraw();
+		m_SavedWindows[i]->SetDraw( false );
+	}
+
+	FOR_EACH_VEC( m_Windows, i )
+		g_pImguiSystem->SetWindowVisible( m_Windows[i].pWindow, true );
+
+	m_Script = pszScript;
+	m_bRecordBaseline = bRecordBaseline;
+	m_nFrame = 0;
+	m_nNextEvent = 0;
+	m_Results.RemoveAll();
+	m_Results.EnsureCapacity( m_nFrameCount );
+	m_bActive = true;
+
+	Msg( "imgui_playback: Running %s for %d frames\n", pszScript, m_nFrameCount );
+	return true;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Parse the event list, ordered by frame and then by script order
+//---------------------------------------------------------------------------------------//
+bool CDearImGuiPlayback::ParseEvents( KeyValues *pEvents )
+{
+	m_Events.RemoveAll();
+
+	for ( KeyValues *pKey = pEvents ? pEvents->GetFirstSubKey() : nullptr; pKey; pKey = pKey->GetNextKey() )
+	{
+		PlaybackEvent_t event;
+		event.nFrame = pKey->GetInt( "frame" );
+		event.nOrder = m_Events.Count();
+		event.x = pKey->GetFloat( "x" );
+		event.y = pKey->GetFloat( "y" );
+		event.nCode = pKey->GetInt( "button" );
+		event.bDown = pKey->GetBool( "down", true );
+
+		const char *pszType = pKey->GetString( "type" );
+		if ( !V_stricmp( pszType, "mousepos" ) )
+			event.eType = PLAYBACK_MOUSE_POS;
+		else if ( !V_stricmp( pszType, "mousebutton" ) )
+			event.eType = PLAYBACK_MOUSE_BUTTON;
+		else if ( !V_stricmp( pszType, "wheel" ) )
+			event.eType = PLAYBACK_MOUSE_WHEEL;
+		else if ( !V_stricmp( pszType, "text" ) )
+		{
+			event.eType = PLAYBACK_TEXT;
+			event.text = pKey->GetString( "text" );
+		}
+		else if ( !V_stricmp( pszType, "key" ) )
+		{
+			event.eType = PLAYBACK_KEY;
+			event.nCode = g_pInputSystem->StringToButtonCode( pKey->GetString( "key" ) );
+			if ( event.nCode <= KEY_NONE || event.nCode >= ARRAYSIZE( IMGUI_KEY_TABLE ) )
+			{
+				Warning( "imgui_playback: Unknown key %s on frame %d\n", pKey->GetString( "key" ), event.nFrame );
+				return false;
+			}
+		}
+		else
+		{
+			Warning( "imgui_playback: Unknown event type %s on frame %d\n", pszType, event.nFrame );
+			return false;
+		}
+
+		m_Events.AddToTail( event );
+	}
+
+	m_Events.Sort( []( const PlaybackEvent_t *a, const PlaybackEvent_t *b )
+		{
+			if ( a->nFrame != b->nFrame )
+				return a->nFrame - b->nFrame;
+			return a->nOrder - b->nOrder;
+		} );
+
+	return true;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Restore the windows that were open before playback
+//---------------------------------------------------------------------------------------//
+void CDearImGuiPlayback::Stop()
+{
+	if ( !m_bActive )
+		return;
+
+	m_bActive = false;
+
+	FOR_EACH_VEC( m_Windows, i )
+		m_Windows[i].pWindow->SetDraw( false );
+
+	FOR_EACH_VEC( m_SavedWindows, i )
+		m_SavedWindows[i]->SetDraw( m_SavedDrawState[i] );
+
+	m_SavedWindows.RemoveAll();
+	m_SavedDrawState.RemoveAll();
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Replace real input with this frame's scripted events. Keys and buttons held
+//  when playback started are released once; after that only real events queued since
+//  the last frame are dropped, so keys the script holds down stay down.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiPlayback::BeginFrame( ImGuiIO &io )
+{
+	io.ClearEventsQueue();
+	if ( m_nFrame == 0 )
+	{
+		io.ClearInputKeys();
+		io.ClearInputMouse();
+	}
+	io.DeltaTime = m_flDeltaTime;
+
+	for ( ; m_nNextEvent < m_Events.Count() && m_Events[m_nNextEvent].nFrame <= m_nFrame; m_nNextEvent++ )
+	{
+		const PlaybackEvent_t &event = m_Events[m_nNextEvent];
+		switch ( event.eType )
+		{
+		case PLAYBACK_MOUSE_POS:
+			io.AddMousePosEvent( event.x, event.y );
+			break;
+		case PLAYBACK_MOUSE_BUTTON:
+			io.AddMouseButtonEvent( event.nCode, event.bDown );
+			break;
+		case PLAYBACK_MOUSE_WHEEL:
+			io.AddMouseWheelEvent( event.x, event.y );
+			break;
+		case PLAYBACK_KEY:
+			io.AddKeyEvent( IMGUI_KEY_TABLE[event.nCode], event.bDown );
+			ImGui_ImplSource_AddModifierEvent( io, IMGUI_KEY_TABLE[event.nCode], event.bDown );
+			break;
+		case PLAYBACK_TEXT:
+			io.AddInputCharactersUTF8( event.text.Get() );
+			break;
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Pin windows to their scripted geometry on the first frame
+//---------------------------------------------------------------------------------------//
+void CDearImGuiPlayback::SetupWindow( IImguiWindow *pWindow )
+{
+	if ( m_nFrame != 0 )
+		return;
+
+	FOR_EACH_VEC( m_Windows, i )
+	{
+		const PlaybackWindow_t &window = m_Windows[i];
+		if ( window.pWindow != pWindow )
+			continue;
+
+		ImGui::SetNextWindowCollapsed( false, ImGuiCond_Always );
+		if ( window.bPlaced )
+		{
+			ImGui::SetNextWindowPos( ImVec2( window.x, window.y ), ImGuiCond_Always );
+			ImGui::SetNextWindowSize( ImVec2( window.w, window.h ), ImGuiCond_Always );
+		}
+		ImGui::SetNextWindowFocus();
+		return;
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Record the frame, and finish up once the script has run its course
+//---------------------------------------------------------------------------------------//
+void CDearImGuiPlayback::EndFrame( const ImGuiFrameStats_t &stats )
+{
+	m_Results.AddToTail( stats );
+
+	if ( ++m_nFrame < m_nFrameCount )
+		return;
+
+	if ( m_bRecordBaseline )
+		WriteBaseline();
+	else
+		Report();
+
+	Stop();
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Store the recorded frames as the new baseline for this script
+//---------------------------------------------------------------------------------------//
+void CDearImGuiPlayback::WriteBaseline()
+{
+	KeyValues *pBaseline = new KeyValues( "ImGuiPlaybackBaseline" );
+	KeyValues::AutoDelete autoDelete( pBaseline );
+
+	pBaseline->SetInt( "frames", m_Results.Count() );
+	FOR_EACH_VEC( m_Results, i )
+	{
+		const ImGuiFrameStats_t &stats = m_Results[i];
+		KeyValues *pFrame = pBaseline->FindKey( CFmtStr( "%d", i ), true );
+		pFrame->SetFloat( "cpu", stats.flCpuTime );
+		pFrame->SetInt( "allocs", stats.nAllocations );
+		pFrame->SetInt( "bytes", stats.nAllocatedBytes );
+		pFrame->SetInt( "verts", stats.nVertices );
+		pFrame->SetInt( "indices", stats.nIndices );
+	}
+
+	CFmtStr path( "%s/%s_baseline.txt", IMGUI_PLAYBACK_DIR, m_Script.Get() );
+	g_pFullFileSystem->CreateDirHierarchy( IMGUI_PLAYBACK_DIR, "MOD" );
+	if ( pBaseline->SaveToFile( g_pFullFileSystem, path, "MOD" ) )
+		Msg( "imgui_playback: Wrote baseline %s\n", path.Get() );
+	else
+		Warning( "imgui_playback: Failed to write baseline %s\n", path.Get() );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Compare the recorded frames with the stored baseline
+//---------------------------------------------------------------------------------------//
+void CDearImGuiPlayback::Report()
+{
+	float flTotalCpu = 0.0f, flMaxCpu = 0.0f;
+	int nTotalAllocs = 0, nTotalVerts = 0;
+	FOR_EACH_VEC( m_Results, i )
+	{
+		flTotalCpu += m_Results[i].flCpuTime;
+		flMaxCpu = MAX( flMaxCpu, m_Results[i].flCpuTime );
+		nTotalAllocs += m_Results[i].nAllocations;
+		nTotalVerts += m_Results[i].nVertices;
+	}
+
+	const int nFrames = m_Results.Count();
+	Msg( "imgui_playback: %s, %d frames\n", m_Script.Get(), nFrames );
+	Msg( "  cpu     avg %.3f ms, max %.3f ms\n", flTotalCpu / nFrames, flMaxCpu );
+	Msg( "  allocs  avg %.1f\n", (float)nTotalAllocs / nFrames );
+	Msg( "  verts   avg %.1f\n", (float)nTotalVerts / nFrames );
+
+	KeyValues *pBaseline = new KeyValues( "ImGuiPlaybackBaseline" );
+	KeyValues::AutoDelete autoDelete( pBaseline );
+
+	CFmtStr path( "%s/%s_baseline.txt", IMGUI_PLAYBACK_DIR, m_Script.Get() );
+	if ( !pBaseline->LoadFromFile( g_pFullFileSystem, path, "MOD" ) )
+	{
+		Msg( "  No baseline found, record one with imgui_playback %s baseline\n", m_Script.Get() );
+		return;
+	}
+
+	if ( pBaseline->GetInt( "frames" ) != nFrames )
+	{
+		Warning( "  Baseline %s has %d frames, expected %d. Record a new one.\n", path.Get(), pBaseline->GetInt( "frames" ), nFrames );
+		return;
+	}
+
+	const float flTolerance = imgui_playback_tolerance.GetFloat();
+	const float flNoiseFloor = imgui_playback_noise_floor.GetFloat();
+	const int nMaxReported = 10;
+
+	float flBaseTotalCpu = 0.0f;
+	int nBaseTotalAllocs = 0, nBaseTotalVerts = 0;
+	int nRegressedFrames = 0;
+	FOR_EACH_VEC( m_Results, i )
+	{
+		const ImGuiFrameStats_t &stats = m_Results[i];
+		KeyValues *pFrame = pBaseline->FindKey( CFmtStr( "%d", i ) );
+		if ( !pFrame )
+			continue;
+
+		const float flBaseCpu = pFrame->GetFloat( "cpu" );
+		const int nBaseAllocs = pFrame->GetInt( "allocs" );
+		const int nBaseVerts = pFrame->GetInt( "verts" );
+		flBaseTotalCpu += flBaseCpu;
+		nBaseTotalAllocs += nBaseAllocs;
+		nBaseTotalVerts += nBaseVerts;
+
+		const bool bSlower = stats.flCpuTime > flBaseCpu * ( 1.0f + flTolerance ) && stats.flCpuTime - flBaseCpu > flNoiseFloor;
+		if ( !bSlower && stats.nAllocations <= nBaseAllocs && stats.nVertices <= nBaseVerts )
+			continue;
+
+		if ( nRegressedFrames++ < nMaxReported )
+		{
+			Warning( "  frame %4d: cpu %.3f ms (baseline %.3f), allocs %d (%d), verts %d (%d)\n",
+				i, stats.flCpuTime, flBaseCpu, stats.nAllocations, nBaseAllocs, stats.nVertices, nBaseVerts );
+		}
+	}
+
+	if ( nRegressedFrames > nMaxReported )
+		Warning( "  ...and %d more frames\n", nRegressedFrames - nMaxReported );
+
+	const float flAvgCpu = flTotalCpu / nFrames;
+	const float flBaseAvgCpu = flBaseTotalCpu / nFrames;
+	Msg( "  baseline cpu avg %.3f ms (%+.1f%%), allocs avg %.1f, verts avg %.1f\n",
+		flBaseAvgCpu, flBaseAvgCpu > 0.0f ? 100.0f * ( flAvgCpu - flBaseAvgCpu ) / flBaseAvgCpu : 0.0f,
+		(float)nBaseTotalAllocs / nFrames, (float)nBaseTotalVerts / nFrames );
+
+	const bool bRegressed = ( flAvgCpu > flBaseAvgCpu * ( 1.0f + flTolerance ) && flAvgCpu - flBaseAvgCpu > flNoiseFloor ) ||
+		nTotalAllocs > nBaseTotalAllocs;
+	if ( bRegressed )
+		Warning( "imgui_playback: %s REGRESSED\n", m_Script.Get() );
+	else
+		Msg( "imgui_playback: %s passed\n", m_Script.Get() );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: imgui_playback <script> [baseline]
+//---------------------------------------------------------------------------------------//
+CON_COMMAND_F( imgui_playback, "Replays " IMGUI_PLAYBACK_DIR "/<script>.txt against its windows and compares frame costs with the stored baseline. Pass 'baseline' to record a new one.", FCVAR_CLIENTDLL )
+{
+	if ( args.ArgC() < 2 )
+	{
+		Msg( "Format: imgui_playback <script> [baseline]\n" );
+		return;
+	}
+
+	g_ImGuiPlayback.Start( args.Arg( 1 ), args.ArgC() > 2 && !V_stricmp( args.Arg( 2 ), "baseline" ) );
+}
+
+CON_COMMAND_F( imgui_playback_stop, "Aborts a running imgui_playback", FCVAR_CLIENTDLL )
+{
+	g_ImGuiPlayback.Stop();
+}
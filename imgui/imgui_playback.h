@@ -0,0 +1,109 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#pragma once
+
+#include "imgui_system.h"
+#include "utlstring.h"
+#include "utlvector.h"
+
+struct ImGuiIO;
+class KeyValues;
+
+// Scripts and baselines live here, relative to the MOD search path
+#define IMGUI_PLAYBACK_DIR "imgui_playback"
+
+//--------------------------------------------------------------------------------//
+// Purpose: Replays a scripted input sequence against a set of windows with a
+//  fixed delta time, and compares the cost of each frame against a baseline
+//--------------------------------------------------------------------------------//
+class CDearImGuiPlayback
+{
+public:
+	bool Start( const char *pszScript, bool bRecordBaseline );
+	void Stop();
+
+	bool IsActive() const { return m_bActive; }
+
+	// Called by the system before NewFrame, feeds this frame's scripted input into io
+	void BeginFrame( ImGuiIO &io );
+
+	// Called by the system right before ImGui::Begin for each drawn window
+	void SetupWindow( IImguiWindow *pWindow );
+
+	// Called by the system once the frame has been submitted
+	void EndFrame( const ImGuiFrameStats_t &stats );
+
+private:
+	enum PlaybackEventType_t
+	{
+		PLAYBACK_MOUSE_POS,
+		PLAYBACK_MOUSE_BUTTON,
+		PLAYBACK_MOUSE_WHEEL,
+		PLAYBACK_KEY,
+		PLAYBACK_TEXT,
+	};
+
+	struct PlaybackEvent_t
+	{
+		int nFrame;
+		int nOrder;
+		PlaybackEventType_t eType;
+		float x, y;
+		int nCode;
+		bool bDown;
+		CUtlString text;
+	};
+
+	struct PlaybackWindow_t
+	{
+		IImguiWindow *pWindow;
+		bool bPlaced;
+		float x, y, w, h;
+	};
+
+	bool ParseEvents( KeyValues *pEvents );
+	void Report();
+	void WriteBaseline();
+
+	bool m_bActive = false;
+	bool m_bRecordBaseline = false;
+	CUtlString m_Script;
+
+	int m_nFrame = 0;
+	int m_nFrameCount = 0;
+	float m_flDeltaTime = 0.0f;
+
+	CUtlVector<PlaybackEvent_t> m_Events;
+	int m_nNextEvent = 0;
+
+	CUtlVector<PlaybackWindow_t> m_Windows;
+
+	// Draw state of every registered window before playback started
+	CUtlVector<IImguiWindow *> m_SavedWindows;
+	CUtlVector<bool> m_SavedDrawState;
+
+	CUtlVector<ImGuiFrameStats_t> m_Results;
+};
+
+extern CDearImGuiPlayback g_ImGuiPlayback;
@@ -0,0 +1,724 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#include "imgui_profiler.h"
+#include "imgui_window.h"
+
+#include "convar.h"
+#include "imgui_format.h"
+#include "igamesystem.h"
+#include "tier0/vprof.h"
+#include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
+
+#include "tier0/memdbgon.h"
+
+static ConVar imgui_profiler_frames( "imgui_profiler_frames", "1000", FCVAR_NONE, "Frames of history the profiler window keeps, applied when recording starts" );
+static ConVar imgui_profiler_spans( "imgui_profiler_spans", "1048576", FCVAR_NONE, "Scopes the profiler window keeps across all frames, 16 bytes each, applied when recording starts" );
+
+CDearImGuiProfiler g_ImGuiProfiler;
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Recording
+//---------------------------------------------------------------------------------------//
+void CDearImGuiProfiler::Start()
+{
+	if ( m_bRecording )
+		return;
+
+	const int nFrames = MAX( imgui_profiler_frames.GetInt(), 16 );
+	const int nSpans = MAX( imgui_profiler_spans.GetInt(), 4096 );
+	if ( m_Frames.Count() != nFrames || m_Spans.Count() != nSpans )
+	{
+		Clear();
+		m_Frames.SetCount( nFrames );
+		m_Spans.SetCount( nSpans );
+	}
+
+	if ( !m_Names.Count() )
+		m_Names.AddToTail( CUtlString( "?" ) );
+
+	g_VProfCurrentProfile.Start();
+
+	// The frame VProf is in the middle of only started being profiled now
+	m_nLastVProfFrame = g_VProfCurrentProfile.NumFramesSampled() + 1;
+	m_nSpikeFrame = -1;
+	m_bRecording = true;
+}
+
+void CDearImGuiProfiler::Stop()
+{
+	if ( !m_bRecording )
+		return;
+
+	g_VProfCurrentProfile.Stop();
+	m_bRecording = false;
+}
+
+void CDearImGuiProfiler::Clear()
+{
+	Stop();
+
+	m_Frames.Purge();
+	m_Spans.Purge();
+	m_nFramesWritten = 0;
+	m_nSpansWritten = 0;
+	m_nSpikeFrame = -1;
+}
+
+uint16 CDearImGuiProfiler::GetNameIndex( const char *pszName )
+{
+	auto it = m_NameLookup.Find( pszName );
+	if ( it != m_NameLookup.InvalidIndex() )
+		return m_NameLookup[it];
+
+	// Index 0 stands in once the table is full
+	if ( m_Names.Count() >= 0xFFFF )
+		return 0;
+
+	const uint16 nName = (uint16)m_Names.AddToTail( CUtlString( pszName ) );
+	m_NameLookup.Insert( pszName, nName );
+	return nName;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Adds a node and everything under it that ran last frame. Returns the number
+//  of spans added.
+//---------------------------------------------------------------------------------------//
+int CDearImGuiProfiler::AddNode( CVProfNode *pNode, int nDepth, float flStart, Frame_t &frame )
+{
+	// A frame may not wrap around onto its own first span, and descendants have to fit
+	// in 16 bits
+	const int nLimit = MIN( m_Spans.Count(), 0xFFFF );
+	if ( frame.nSpans >= nLimit || nDepth > 0xFF )
+		return 0;
+
+	Span_t &span = m_Spans[( frame.nFirstSpan + frame.nSpans ) % m_Spans.Count()];
+	frame.nSpans++;
+
+	span.flStart = flStart;
+	span.flDuration = (float)pNode->GetPrevTime();
+	span.nName = GetNameIndex( pNode->GetName() );
+	span.nCalls = (uint16)MIN( pNode->GetPrevCalls(), 0xFFFF );
+	span.nDepth = (uint8)nDepth;
+
+	int nDescendants = 0;
+	float flChildStart = flStart;
+	for ( CVProfNode *pChild = pNode->GetChild(); pChild; pChild = pChild->GetSibling() )
+	{
+		// Scopes that weren't entered last frame, their children can't have been either
+		if ( pChild->GetPrevCalls() <= 0 )
+			continue;
+
+		nDescendants += AddNode( pChild, nDepth + 1, flChildStart, frame );
+		flChildStart += (float)pChild->GetPrevTime();
+	}
+
+	span.nDescendants = (uint16)nDescendants;
+	return nDescendants + 1;
+}
+
+void CDearImGuiProfiler::RecordFrame()
+{
+	if ( !m_bRecording )
+		return;
+
+	// Only once per frame VProf finishes, the client can run more often than that
+	const int nVProfFrame = g_VProfCurrentProfile.NumFramesSampled();
+	if ( nVProfFrame <= m_nLastVProfFrame )
+		return;
+	m_nLastVProfFrame = nVProfFrame;
+
+	CVProfNode *pRoot = g_VProfCurrentProfile.GetRoot();
+
+	Frame_t &frame = m_Frames[m_nFramesWritten % m_Frames.Count()];
+	frame.nFirstSpan = m_nSpansWritten;
+	frame.nSpans = 0;
+	frame.nNumber = m_nFramesWritten;
+	frame.flDuration = (float)pRoot->GetPrevTime();
+	AddNode( pRoot, 0, 0.0f, frame );
+
+	m_nSpansWritten += frame.nSpans;
+	m_nFramesWritten++;
+
+	if ( m_flSpikeThreshold > 0.0f && frame.flDuration > m_flSpikeThreshold )
+	{
+		m_nSpikeFrame = frame.nNumber;
+		Stop();
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: History. The oldest frames in the ring can have had their spans overwritten
+//  by newer frames with more spans.
+//---------------------------------------------------------------------------------------//
+int CDearImGuiProfiler::GetOldestFrame() const
+{
+	if ( !m_Frames.Count() )
+		return 0;
+
+	int nOldest = MAX( 0, m_nFramesWritten - m_Frames.Count() );
+	while ( nOldest < m_nFramesWritten && m_nSpansWritten - m_Frames[nOldest % m_Frames.Count()].nFirstSpan > m_Spans.Count() )
+		nOldest++;
+	return nOldest;
+}
+
+int CDearImGuiProfiler::GetFrameCount() const
+{
+	return m_nFramesWritten - GetOldestFrame();
+}
+
+const CDearImGuiProfiler::Frame_t &CDearImGuiProfiler::GetFrame( int i ) const
+{
+	return m_Frames[( GetOldestFrame() + i ) % m_Frames.Count()];
+}
+
+int CDearImGuiProfiler::FindFrame( int nNumber ) const
+{
+	const int nOldest = GetOldestFrame();
+	if ( nNumber < nOldest || nNumber >= m_nFramesWritten )
+		return -1;
+	return nNumber - nOldest;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Feeds the profiler from the client's per-frame update, so spikes are caught
+//  while imgui isn't drawing
+//---------------------------------------------------------------------------------------//
+class CDearImGuiProfilerSystem : public CAutoGameSystemPerFrame
+{
+public:
+	CDearImGuiProfilerSystem() : CAutoGameSystemPerFrame( "CDearImGuiProfilerSystem" ) {}
+
+	void Update( float frametime ) override
+	{
+		g_ImGuiProfiler.RecordFrame();
+	}
+
+	void Shutdown() override
+	{
+		g_ImGuiProfiler.Clear();
+	}
+};
+
+static CDearImGuiProfilerSystem s_ImGuiProfilerSystem;
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Profiler window. A strip of frame times to pick a frame from, the picked
+//  frame as a zoomable flame graph, and the scopes of that frame by self time.
+//---------------------------------------------------------------------------------------//
+class CDearImGuiProfilerWindow : public IImguiWindow
+{
+public:
+	CDearImGuiProfilerWindow() : IImguiWindow( "profiler", "Profiler" ) {}
+
+	bool Draw() override;
+
+private:
+	struct Aggregate_t
+	{
+		int nName;
+		float flSelf;
+		float flTotal;
+		int nCalls;
+	};
+
+	void DrawFrameStrip();
+	void DrawFlameGraph( const CDearImGuiProfiler::Frame_t &frame );
+	void DrawAggregates( const CDearImGuiProfiler::Frame_t &frame );
+	void UpdateAggregates( const CDearImGuiProfiler::Frame_t &frame );
+	void UpdateHistory();
+
+	int m_nSelectedFrame = -1;		// Frame number, -1 follows the newest frame
+	int m_nSelectedName = -1;
+
+	// Flame graph view in ms, fit to the frame until it's zoomed
+	float m_flViewStart = 0.0f;
+	float m_flViewEnd = 0.0f;
+	bool m_bViewFit = true;
+
+	// Scopes of the selected frame
+	CUtlVector<Aggregate_t> m_Aggregates;
+	int m_nAggregateFrame = -1;
+
+	// The selected scope across the history
+	int m_nHistoryName = -1;
+	int m_nHistoryFrames = -1;
+	int m_nHistoryCount = 0;
+	float m_flHistoryAverage = 0.0f;
+	float m_flHistoryMin = 0.0f;
+	float m_flHistoryMax = 0.0f;
+};
+
+DEFINE_IMGUI_WINDOW( CDearImGuiProfilerWindow );
+
+static ImU32 GetNameColor( int nName, float flValue )
+{
+	// Golden ratio hues keep neighbouring names apart
+	float r, g, b;
+	ImGui::ColorConvertHSVtoRGB( fmodf( nName * 0.618034f, 1.0f ), 0.45f, flValue, r, g, b );
+	return ImGui::GetColorU32( ImVec4( r, g, b, 1.0f ) );
+}
+
+bool CDearImGuiProfilerWindow::Draw()
+{
+	CDearImGuiProfiler &profiler = g_ImGuiProfiler;
+
+	if ( profiler.IsRecording() )
+	{
+		if ( ImGui::Button( "Stop" ) )
+			profiler.Stop();
+	}
+	else if ( ImGui::Button( "Record" ) )
+	{
+		profiler.Start();
+		m_nSelectedFrame = -1;
+	}
+
+	ImGui::SameLine();
+	if ( ImGui::Button( "Clear" ) )
+	{
+		profiler.Clear();
+		m_nSelectedFrame = -1;
+		m_nAggregateFrame = -1;
+		m_nHistoryName = -1;
+	}
+
+	ImGui::SameLine();
+	float flThreshold = profiler.GetSpikeThreshold();
+	ImGui::SetNextItemWidth( ImGui::GetFontSize() * 8.0f );
+	if ( ImGui::DragFloat( "Stop on spikes over", &flThreshold, 0.1f, 0.0f, 1000.0f, flThreshold > 0.0f ? "%.1f ms" : "off" ) )
+		profiler.SetSpikeThreshold( MAX( flThreshold, 0.0f ) );
+
+	ImGui::SameLine();
+	ImGui::TextDisabled( "%d frames, %d KB", profiler.GetFrameCount(), profiler.GetMemoryUsage() / 1024 );
+
+	// Jump to the spike that stopped recording
+	if ( profiler.GetSpikeFrame() >= 0 && !profiler.IsRecording() && m_nSelectedFrame < 0 )
+		m_nSelectedFrame = profiler.GetSpikeFrame();
+
+	if ( !profiler.GetFrameCount() )
+	{
+		ImGui::TextUnformatted( "Nothing recorded yet. VProf only runs while recording." );
+		return true;
+	}
+
+	DrawFrameStrip();
+
+	int nFrame = m_nSelectedFrame >= 0 ? profiler.FindFrame( m_nSelectedFrame ) : -1;
+	if ( nFrame < 0 )
+	{
+		m_nSelectedFrame = -1;
+		nFrame = profiler.GetFrameCount() - 1;
+	}
+
+	const CDearImGuiProfiler::Frame_t &frame = profiler.GetFrame( nFrame );
+	ImGui::Text( "Frame %d: %.2f ms, %d scopes", frame.nNumber, frame.flDuration, frame.nSpans );
+	if ( m_nSelectedFrame >= 0 )
+	{
+		ImGui::SameLine();
+		if ( ImGui::SmallButton( "Follow newest" ) )
+			m_nSelectedFrame = -1;
+	}
+
+	DrawFlameGraph( frame );
+	DrawAggregates( frame );
+	return true;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: One bar per frame, or the longest frame of each pixel column once there are
+//  more frames than pixels. Clicking picks a frame.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiProfilerWindow::DrawFrameStrip()
+{
+	CDearImGuiProfiler &profiler = g_ImGuiProfiler;
+	const int nFrames = profiler.GetFrameCount();
+
+	const ImVec2 vecPos = ImGui::GetCursorScreenPos();
+	const ImVec2 vecSize( MAX( ImGui::GetContentRegionAvail().x, 64.0f ), ImGui::GetFontSize() * 4.0f );
+	ImGui::InvisibleButton( "##frames", vecSize );
+
+	ImDrawList *pDrawList = ImGui::GetWindowDrawList();
+	pDrawList->AddRectFilled( vecPos, ImVec2( vecPos.x + vecSize.x, vecPos.y + vecSize.y ), ImGui::GetColorU32( ImGuiCol_FrameBg ) );
+
+	float flMax = profiler.GetSpikeThreshold();
+	for ( int i = 0; i < nFrames; i++ )
+		flMax = MAX( flMax, profiler.GetFrame( i ).flDuration );
+	flMax = MAX( flMax, 1.0f );
+
+	const int nSelected = m_nSelectedFrame >= 0 ? profiler.FindFrame( m_nSelectedFrame ) : nFrames - 1;
+	const float flThreshold = profiler.GetSpikeThreshold();
+	const int nColumns = MIN( nFrames, (int)vecSize.x );
+	const float flColumnWidth = vecSize.x / nColumns;
+
+	for ( int c = 0; c < nColumns; c++ )
+	{
+		const int nFirst = (int)( (int64)c * nFrames / nColumns );
+		const int nLast = MAX( nFirst + 1, (int)( (int64)( c + 1 ) * nFrames / nColumns ) );
+
+		float flLongest = 0.0f;
+		bool bSelected = false;
+		for ( int i = nFirst; i < nLast; i++ )
+		{
+			flLongest = MAX( flLongest, profiler.GetFrame( i ).flDuration );
+			bSelected |= ( i == nSelected );
+		}
+
+		ImU32 col = ImGui::GetColorU32( ImGuiCol_PlotHistogram );
+		if ( bSelected )
+			col = IM_COL32( 255, 255, 255, 255 );
+		else if ( flThreshold > 0.0f && flLongest > flThreshold )
+			col = IM_COL32( 230, 70, 60, 255 );
+
+		const float x = vecPos.x + c * flColumnWidth;
+		const float flHeight = vecSize.y * MIN( flLongest / flMax, 1.0f );
+		pDrawList->AddRectFilled( ImVec2( x, vecPos.y + vecSize.y - flHeight ), ImVec2( x + MAX( flColumnWidth - 1.0f, 1.0f ), vecPos.y + vecSize.y ), col );
+	}
+
+	if ( flThreshold > 0.0f && flThreshold < flMax )
+	{
+		const float y = vecPos.y + vecSize.y * ( 1.0f - flThreshold / flMax );
+		pDrawList->AddLine( ImVec2( vecPos.x, y ), ImVec2( vecPos.x + vecSize.x, y ), IM_COL32( 230, 70, 60, 160 ) );
+	}
+
+	if ( ImGui::IsItemHovered() || ImGui::IsItemActive() )
+	{
+		const int nColumn = clamp( (int)( ( ImGui::GetIO().MousePos.x - vecPos.x ) / flColumnWidth ), 0, nColumns - 1 );
+		const int nFirst = (int)( (int64)nColumn * nFrames / nColumns );
+		const int nLast = MAX( nFirst + 1, (int)( (int64)( nColumn + 1 ) * nFrames / nColumns ) );
+
+		// The longest frame in the column is the one worth looking at
+		int nHovered = nFirst;
+		for ( int i = nFirst + 1; i < nLast; i++ )
+		{
+			if ( profiler.GetFrame( i ).flDuration > profiler.GetFrame( nHovered ).flDuration )
+				nHovered = i;
+		}
+
+		const CDearImGuiProfiler::Frame_t &hovered = profiler.GetFrame( nHovered );
+		ImGui::SetTooltip( "Frame %d: %.2f ms", hovered.nNumber, hovered.flDuration );
+
+		if ( ImGui::IsItemActive() )
+			m_nSelectedFrame = hovered.nNumber;
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Flame graph of a frame. Spans outside the view are skipped with everything
+//  nested in them, and runs of spans narrower than a couple of pixels are merged into
+//  one grey block per row, so only what can be told apart gets drawn.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiProfilerWindow::DrawFlameGraph( const CDearImGuiProfiler::Frame_t &frame )
+{
+	CDearImGuiProfiler &profiler = g_ImGuiProfiler;
+	const float flRowHeight = ImGui::GetFrameHeight();
+	const float flMinWidth = 2.0f;
+
+	int nMaxDepth = 0;
+	for ( int i = 0; i < frame.nSpans; i++ )
+		nMaxDepth = MAX( nMaxDepth, (int)profiler.GetSpan( frame, i ).nDepth );
+
+	if ( m_bViewFit || m_flViewEnd <= m_flViewStart )
+	{
+		m_flViewStart = 0.0f;
+		m_flViewEnd = MAX( frame.flDuration, 0.001f );
+	}
+
+	const float flHeight = MIN( flRowHeight * ( nMaxDepth + 1 ) + ImGui::GetStyle().ScrollbarSize, ImGui::GetFontSize() * 20.0f );
+	if ( !ImGui::BeginChild( "##flame", ImVec2( 0.0f, flHeight ), ImGuiChildFlags_Borders, ImGuiWindowFlags_NoScrollWithMouse ) )
+	{
+		ImGui::EndChild();
+		return;
+	}
+
+	const ImVec2 vecPos = ImGui::GetCursorScreenPos();
+	const float flWidth = MAX( ImGui::GetContentRegionAvail().x, 64.0f );
+	ImGui::InvisibleButton( "##flamegraph", ImVec2( flWidth, flRowHeight * ( nMaxDepth + 1 ) ) );
+
+	const bool bHovered = ImGui::IsItemHovered();
+	const ImGuiIO &io = ImGui::GetIO();
+	float flScale = flWidth / ( m_flViewEnd - m_flViewStart );
+
+	// Wheel zooms around the cursor, dragging pans, double click fits the frame again
+	if ( bHovered && io.MouseWheel != 0.0f )
+	{
+		const float flCursor = m_flViewStart + ( io.MousePos.x - vecPos.x ) / flScale;
+		const float flZoom = powf( 0.8f, io.MouseWheel );
+		m_flViewStart = flCursor - ( flCursor - m_flViewStart ) * flZoom;
+		m_flViewEnd = flCursor + ( m_flViewEnd - flCursor ) * flZoom;
+		m_bViewFit = false;
+	}
+
+	if ( ImGui::IsItemActive() && ImGui::IsMouseDragging( ImGuiMouseButton_Left ) )
+	{
+		const float flDelta = io.MouseDelta.x / flScale;
+		m_flViewStart -= flDelta;
+		m_flViewEnd -= flDelta;
+		m_bViewFit = false;
+	}
+
+	if ( bHovered && ImGui::IsMouseDoubleClicked( ImGuiMouseButton_Left ) )
+		m_bViewFit = true;
+
+	flScale = flWidth / ( m_flViewEnd - m_flViewStart );
+
+	ImDrawList *pDrawList = ImGui::GetWindowDrawList();
+	const ImVec4 clipRect = pDrawList->GetClipRectVec4();
+	const ImU32 textCol = IM_COL32( 0, 0, 0, 255 );
+	const ImU32 mergedCol = IM_COL32( 110, 110, 110, 255 );
+
+	// Pending merged run per row
+	float flRunStart[256], flRunEnd[256];
+	for ( int d = 0; d <= nMaxDepth; d++ )
+		flRunStart[d] = flRunEnd[d] = -FLT_MAX;
+
+	auto FlushRun = [&]( int nDepth )
+	{
+		if ( flRunEnd[nDepth] <= flRunStart[nDepth] )
+			return;
+
+		const float y = vecPos.y + nDepth * flRowHeight;
+		pDrawList->AddRectFilled( ImVec2( flRunStart[nDepth], y ), ImVec2( flRunEnd[nDepth], y + flRowHeight - 1.0f ), mergedCol );
+		flRunStart[nDepth] = flRunEnd[nDepth] = -FLT_MAX;
+	};
+
+	int nHovered = -1;
+	for ( int i = 0; i < frame.nSpans; i++ )
+	{
+		const CDearImGuiProfiler::Span_t &span = profiler.GetSpan( frame, i );
+		const float x0 = vecPos.x + ( span.flStart - m_flViewStart ) * flScale;
+		const float x1 = vecPos.x + ( span.flStart + span.flDuration - m_flViewStart ) * flScale;
+		const float y = vecPos.y + span.nDepth * flRowHeight;
+
+		// Nested spans are inside this one horizontally and below it vertically
+		if ( x1 < clipRect.x || x0 > clipRect.z || y > clipRect.w )
+		{
+			i += span.nDescendants;
+			continue;
+		}
+
+		if ( x1 - x0 < flMinWidth )
+		{
+			if ( x0 <= flRunEnd[span.nDepth] + 1.0f )
+			{
+				flRunEnd[span.nDepth] = MAX( flRunEnd[span.nDepth], x1 );
+			}
+			else
+			{
+				FlushRun( span.nDepth );
+				flRunStart[span.nDepth] = x0;
+				flRunEnd[span.nDepth] = MAX( x1, x0 + 1.0f );
+			}
+
+			i += span.nDescendants;
+			continue;
+		}
+
+		FlushRun( span.nDepth );
+		if ( y + flRowHeight < clipRect.y )
+			continue;
+
+		const bool bSelected = span.nName == m_nSelectedName;
+		const ImVec2 vecMin( MAX( x0, clipRect.x ), y );
+		const ImVec2 vecMax( MIN( x1, clipRect.z ), y + flRowHeight - 1.0f );
+		pDrawList->AddRectFilled( vecMin, vecMax, GetNameColor( span.nName, bSelected ? 1.0f : 0.8f ) );
+		if ( bSelected )
+			pDrawList->AddRect( vecMin, vecMax, IM_COL32( 255, 255, 255, 255 ) );
+
+		if ( vecMax.x - vecMin.x > ImGui::GetFontSize() * 2.0f )
+		{
+			const ImVec4 textClip( vecMin.x, vecMin.y, vecMax.x - 2.0f, vecMax.y );
+			pDrawList->AddText( ImGui::GetFont(), ImGui::GetFontSize(), ImVec2( vecMin.x + 2.0f, y + ImGui::GetStyle().FramePadding.y ), textCol, profiler.GetName( span.nName ), nullptr, 0.0f, &textClip );
+		}
+
+		if ( bHovered && io.MousePos.x >= x0 && io.MousePos.x < x1 && io.MousePos.y >= y && io.MousePos.y < y + flRowHeight )
+			nHovered = i;
+	}
+
+	for ( int d = 0; d <= nMaxDepth; d++ )
+		FlushRun( d );
+
+	if ( nHovered >= 0 )
+	{
+		const CDearImGuiProfiler::Span_t &span = profiler.GetSpan( frame, nHovered );
+		ImGui::SetTooltip( "%s\n%.3f ms, %.1f%% of the frame\n%d calls", profiler.GetName( span.nName ), span.flDuration,
+						   frame.flDuration > 0.0f ? 100.0f * span.flDuration / frame.flDuration : 0.0f, span.nCalls );
+
+		if ( ImGui::IsMouseReleased( ImGuiMouseButton_Left ) && !ImGui::IsMouseDragPastThreshold( ImGuiMouseButton_Left ) )
+			m_nSelectedName = span.nName;
+	}
+
+	ImGui::EndChild();
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Self and total time per scope name in a frame, worst first
+//---------------------------------------------------------------------------------------//
+void CDearImGuiProfilerWindow::UpdateAggregates( const CDearImGuiProfiler::Frame_t &frame )
+{
+	CDearImGuiProfiler &profiler = g_ImGuiProfiler;
+
+	CUtlVector<int> slots;
+	slots.SetCount( profiler.GetNameCount() );
+	for ( int i = 0; i < slots.Count(); i++ )
+		slots[i] = -1;
+
+	m_Aggregates.RemoveAll();
+	for ( int i = 0; i < frame.nSpans; i++ )
+	{
+		const CDearImGuiProfiler::Span_t &span = profiler.GetSpan( frame, i );
+
+		// Direct children are found by skipping over their own descendants
+		float flChildren = 0.0f;
+		for ( int c = i + 1; c <= i + span.nDescendants; c += profiler.GetSpan( frame, c ).nDescendants + 1 )
+			flChildren += profiler.GetSpan( frame, c ).flDuration;
+
+		int &nSlot = slots[span.nName];
+		if ( nSlot < 0 )
+		{
+			nSlot = m_Aggregates.AddToTail();
+			m_Aggregates[nSlot].nName = span.nName;
+			m_Aggregates[nSlot].flSelf = 0.0f;
+			m_Aggregates[nSlot].flTotal = 0.0f;
+			m_Aggregates[nSlot].nCalls = 0;
+		}
+
+		Aggregate_t &aggregate = m_Aggregates[nSlot];
+		aggregate.flSelf += MAX( span.flDuration - flChildren, 0.0f );
+		aggregate.flTotal += span.flDuration;
+		aggregate.nCalls += span.nCalls;
+	}
+
+	m_Aggregates.Sort( []( const Aggregate_t *a, const Aggregate_t *b )
+		{
+			if ( a->flSelf == b->flSelf )
+				return 0;
+			return a->flSelf > b->flSelf ? -1 : 1;
+		} );
+
+	m_nAggregateFrame = frame.nNumber;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Total time of the selected scope in each frame of the history. Only redone
+//  once a second's worth of new frames came in.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiProfilerWindow::UpdateHistory()
+{
+	CDearImGuiProfiler &profiler = g_ImGuiProfiler;
+	const int nFrames = profiler.GetFrameCount();
+	const int nNewest = nFrames ? profiler.GetFrame( nFrames - 1 ).nNumber : 0;
+
+	if ( m_nHistoryName == m_nSelectedName && nNewest - m_nHistoryFrames < 60 )
+		return;
+
+	m_nHistoryName = m_nSelectedName;
+	m_nHistoryFrames = nNewest;
+	m_nHistoryCount = 0;
+	m_flHistoryMin = FLT_MAX;
+	m_flHistoryMax = 0.0f;
+
+	double flSum = 0.0;
+	for ( int f = 0; f < nFrames; f++ )
+	{
+		const CDearImGuiProfiler::Frame_t &frame = profiler.GetFrame( f );
+
+		float flTotal = 0.0f;
+		bool bFound = false;
+		for ( int i = 0; i < frame.nSpans; i++ )
+		{
+			const CDearImGuiProfiler::Span_t &span = profiler.GetSpan( frame, i );
+			if ( span.nName != m_nSelectedName )
+				continue;
+
+			// Count recursive scopes once
+			flTotal += span.flDuration;
+			i += span.nDescendants;
+			bFound = true;
+		}
+
+		if ( !bFound )
+			continue;
+
+		flSum += flTotal;
+		m_flHistoryMin = MIN( m_flHistoryMin, flTotal );
+		m_flHistoryMax = MAX( m_flHistoryMax, flTotal );
+		m_nHistoryCount++;
+	}
+
+	m_flHistoryAverage = m_nHistoryCount ? (float)( flSum / m_nHistoryCount ) : 0.0f;
+	if ( !m_nHistoryCount )
+		m_flHistoryMin = 0.0f;
+}
+
+void CDearImGuiProfilerWindow::DrawAggregates( const CDearImGuiProfiler::Frame_t &frame )
+{
+	CDearImGuiProfiler &profiler = g_ImGuiProfiler;
+
+	if ( m_nAggregateFrame != frame.nNumber )
+		UpdateAggregates( frame );
+
+	if ( m_nSelectedName >= 0 && m_nSelectedName < profiler.GetNameCount() )
+	{
+		UpdateHistory();
+		ImGui::Text( "%s: %.3f ms average, %.3f min, %.3f max, in %d of %d frames", profiler.GetName( m_nSelectedName ),
+					 m_flHistoryAverage, m_flHistoryMin, m_flHistoryMax, m_nHistoryCount, profiler.GetFrameCount() );
+	}
+
+	const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp;
+	if ( !ImGui::BeginTable( "##scopes", 4, flags ) )
+		return;
+
+	ImGui::TableSetupScrollFreeze( 0, 1 );
+	ImGui::TableSetupColumn( "Scope" );
+	ImGui::TableSetupColumn( "Self (ms)" );
+	ImGui::TableSetupColumn( "Total (ms)" );
+	ImGui::TableSetupColumn( "Calls" );
+	ImGui::TableHeadersRow();
+
+	ImGuiListClipper clipper;
+	clipper.Begin( m_Aggregates.Count() );
+	while ( clipper.Step() )
+	{
+		for ( int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++ )
+		{
+			const Aggregate_t &aggregate = m_Aggregates[i];
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::PushID( i );
+			if ( ImGui::Selectable( profiler.GetName( aggregate.nName ), aggregate.nName == m_nSelectedName, ImGuiSelectableFlags_SpanAllColumns ) )
+				m_nSelectedName = aggregate.nName;
+			ImGui::PopID();
+			ImGui::TableNextColumn();
+			g_ImGuiTextCache.Text( "%.3f", aggregate.flSelf );
+			ImGui::TableNextColumn();
+			g_ImGuiTextCache.Text( "%.3f", aggregate.flTotal );
+			ImGui::TableNextColumn();
+			g_ImGuiTextCache.Text( "%d", aggregate.nCalls );
+		}
+	}
+
+	ImGui::EndTable();
+}
@@ -0,0 +1,113 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#pragma once
+
+#include "utlmap.h"
+#include "utlstring.h"
+#include "utlvector.h"
+
+class CVProfNode;
+
+//--------------------------------------------------------------------------------//
+// Purpose: Records each frame's VProf tree into a fixed ring of frames for the
+//  profiler window. Frames are flattened depth first into spans, with children
+//  laid out one after another inside their parent, so they can be drawn as a
+//  flame graph without walking the tree again. Spans go into one shared ring as
+//  well; frames whose spans were overwritten are dropped from the history.
+//--------------------------------------------------------------------------------//
+class CDearImGuiProfiler
+{
+public:
+	CDearImGuiProfiler() : m_NameLookup( DefLessFunc( const char * ) ) {}
+
+	struct Span_t
+	{
+		float flStart;			// ms from the start of the frame
+		float flDuration;		// ms
+		uint16 nName;			// Index into the name table
+		uint16 nDescendants;	// Spans following this one that are nested inside it
+		uint16 nCalls;
+		uint8 nDepth;
+	};
+
+	struct Frame_t
+	{
+		int64 nFirstSpan;		// Position in the span ring, counted from the first span ever recorded
+		int nSpans;
+		int nNumber;			// Counts up for every frame recorded since the last Clear
+		float flDuration;		// ms
+	};
+
+	// Start and stop VProf along with recording
+	void Start();
+	void Stop();
+	bool IsRecording() const { return m_bRecording; }
+
+	// Stops recording and releases the history
+	void Clear();
+
+	// Records the last frame VProf finished, once per client frame
+	void RecordFrame();
+
+	// Recording stops on the first frame longer than this, 0 to never stop
+	void SetSpikeThreshold( float flMs ) { m_flSpikeThreshold = flMs; }
+	float GetSpikeThreshold() const { return m_flSpikeThreshold; }
+
+	// Number of the frame that stopped recording, or -1
+	int GetSpikeFrame() const { return m_nSpikeFrame; }
+
+	// Frames still in the history, oldest first
+	int GetFrameCount() const;
+	const Frame_t &GetFrame( int i ) const;
+
+	// Position of a frame by its number, or -1 if it's no longer in the history
+	int FindFrame( int nNumber ) const;
+
+	const Span_t &GetSpan( const Frame_t &frame, int i ) const { return m_Spans[( frame.nFirstSpan + i ) % m_Spans.Count()]; }
+	const char *GetName( int nName ) const { return m_Names[nName].Get(); }
+	int GetNameCount() const { return m_Names.Count(); }
+
+	int GetMemoryUsage() const { return m_Frames.Count() * sizeof( Frame_t ) + m_Spans.Count() * sizeof( Span_t ); }
+
+private:
+	int AddNode( CVProfNode *pNode, int nDepth, float flStart, Frame_t &frame );
+	uint16 GetNameIndex( const char *pszName );
+	int GetOldestFrame() const;
+
+	CUtlVector<Frame_t> m_Frames;
+	CUtlVector<Span_t> m_Spans;
+	int m_nFramesWritten = 0;
+	int64 m_nSpansWritten = 0;
+
+	// VProf node names are static strings, so they're looked up by pointer and copied
+	CUtlMap<const char *, uint16> m_NameLookup;
+	CUtlVector<CUtlString> m_Names;
+
+	float m_flSpikeThreshold = 0.0f;
+	int m_nSpikeFrame = -1;
+	int m_nLastVProfFrame = 0;
+	bool m_bRecording = false;
+};
+
+extern CDearImGuiProfiler g_ImGuiProfiler;
@@ -0,0 +1,747 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef int socklen_t;
+#define IMGUI_SOCKET_WOULDBLOCK()	( WSAGetLastError() == WSAEWOULDBLOCK )
+#define IMGUI_SEND_FLAGS			0
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define closesocket					close
+#define IMGUI_SOCKET_WOULDBLOCK()	( errno == EWOULDBLOCK || errno == EAGAIN )
+#ifdef MSG_NOSIGNAL
+#define IMGUI_SEND_FLAGS			MSG_NOSIGNAL
+#else
+#define IMGUI_SEND_FLAGS			0
+#endif
+#endif
+
+#include "imgui_remote.h"
+
+#include "checksum_crc.h"
+#include "convar.h"
+#include "imgui_impl_source.h"
+#include "lzss.h"
+#include "tier0/fasttimer.h"
+#include "tier0/threadtools.h"
+#include "tier0/vprof.h"
+
+#include "tier0/memdbgon.h"
+
+static ConVar imgui_remote( "imgui_remote", "0", FCVAR_NONE, "Stream imgui frames to a viewer connecting on localhost:imgui_remote_port" );
+static ConVar imgui_remote_port( "imgui_remote_port", "27099", FCVAR_ARCHIVE, "Port imgui_remote listens on" );
+static ConVar imgui_remote_local_render( "imgui_remote_local_render", "1", FCVAR_NONE, "Keep drawing imgui locally while a remote viewer is connected" );
+static ConVar imgui_remote_keyframe_interval( "imgui_remote_keyframe_interval", "120", FCVAR_NONE, "Frames between full frames sent to a remote viewer, deltas are sent in between" );
+static ConVar imgui_remote_max_queue( "imgui_remote_max_queue", "4096", FCVAR_NONE, "KB of unsent data after which frames are dropped instead of queued" );
+
+CDearImGuiRemote g_ImGuiRemote;
+
+static const intp INVALID_REMOTE_SOCKET = -1;
+
+// Input messages are a frame's worth of events, anything bigger isn't from a viewer
+static const uint32 MAX_REMOTE_INPUT_SIZE = 1024 * sizeof( RemoteInputEvent_t );
+
+static void StopRemoteLoopback();
+
+static void CloseRemoteSocket( intp &nSocket )
+{
+	if ( nSocket != INVALID_REMOTE_SOCKET )
+	{
+		closesocket( nSocket );
+		nSocket = INVALID_REMOTE_SOCKET;
+	}
+}
+
+static void SetNonBlocking( intp nSocket )
+{
+#ifdef _WIN32
+	u_long nNonBlocking = 1;
+	ioctlsocket( nSocket, FIONBIO, &nNonBlocking );
+#else
+	fcntl( nSocket, F_SETFL, fcntl( nSocket, F_GETFL, 0 ) | O_NONBLOCK );
+#endif
+}
+
+static bool InitSockets()
+{
+#ifdef _WIN32
+	// Reference counted, the engine has usually done this already
+	static bool s_bStarted = false;
+	if ( !s_bStarted )
+	{
+		WSADATA wsaData;
+		s_bStarted = WSAStartup( MAKEWORD( 2, 2 ), &wsaData ) == 0;
+	}
+	return s_bStarted;
+#else
+	return true;
+#endif
+}
+
+// XOR src against base into dest. Bytes past the end of base are copied as they are.
+static void XorBuffers( unsigned char *pDest, const unsigned char *pSrc, int nSize, const unsigned char *pBase, int nBaseSize )
+{
+	const int nShared = MIN( nSize, nBaseSize );
+	int i = 0;
+	for ( ; i + 4 <= nShared; i += 4 )
+	{
+		uint32 a, b;
+		memcpy( &a, pSrc + i, 4 );
+		memcpy( &b, pBase + i, 4 );
+		a ^= b;
+		memcpy( pDest + i, &a, 4 );
+	}
+	for ( ; i < nShared; i++ )
+		pDest[i] = pSrc[i] ^ pBase[i];
+	if ( nSize > nShared )
+		memcpy( pDest + nShared, pSrc + nShared, nSize - nShared );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Open the listen socket, or re-open it if the port changed
+//---------------------------------------------------------------------------------------//
+bool CDearImGuiRemote::Listen()
+{
+	if ( m_nListenSocket != INVALID_REMOTE_SOCKET && m_nListenPort == imgui_remote_port.GetInt() )
+		return true;
+
+	Shutdown();
+	if ( !InitSockets() )
+		return false;
+
+	m_nListenPort = imgui_remote_port.GetInt();
+	m_nListenSocket = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+	if ( m_nListenSocket == INVALID_REMOTE_SOCKET )
+		return false;
+
+	int nReuse = 1;
+	setsockopt( m_nListenSocket, SOL_SOCKET, SO_REUSEADDR, (const char *)&nReuse, sizeof( nReuse ) );
+
+	// Local viewers only
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons( (uint16)m_nListenPort );
+	addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+	if ( bind( m_nListenSocket, (sockaddr *)&addr, sizeof( addr ) ) != 0 || listen( m_nListenSocket, 1 ) != 0 )
+	{
+		Warning( "imgui_remote: Failed to listen on port %d\n", m_nListenPort );
+		CloseRemoteSocket( m_nListenSocket );
+		imgui_remote.SetValue( 0 );
+		return false;
+	}
+
+	SetNonBlocking( m_nListenSocket );
+	Msg( "imgui_remote: Listening on 127.0.0.1:%d\n", m_nListenPort );
+	return true;
+}
+
+void CDearImGuiRemote::Disconnect()
+{
+	if ( m_nViewerSocket == INVALID_REMOTE_SOCKET )
+		return;
+
+	CloseRemoteSocket( m_nViewerSocket );
+	m_SendQueue.Purge();
+	m_RecvBuffer.Purge();
+	m_PrevFrame.Purge();
+	Msg( "imgui_remote: Viewer disconnected\n" );
+}
+
+void CDearImGuiRemote::Shutdown()
+{
+	Disconnect();
+	CloseRemoteSocket( m_nListenSocket );
+	StopRemoteLoopback();
+}
+
+void CDearImGuiRemote::OnFontAtlasChanged()
+{
+	if ( !IsConnected() )
+		return;
+
+	SendFontAtlas();
+	m_bNeedKeyFrame = true;
+}
+
+bool CDearImGuiRemote::IsConnected() const
+{
+	return m_nViewerSocket != INVALID_REMOTE_SOCKET;
+}
+
+bool CDearImGuiRemote::ShouldRenderLocally() const
+{
+	return !IsConnected() || imgui_remote_local_render.GetBool();
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Accept a viewer if we don't have one, and process what it sent us
+//---------------------------------------------------------------------------------------//
+void CDearImGuiRemote::Update()
+{
+	if ( !imgui_remote.GetBool() )
+	{
+		if ( m_nListenSocket != INVALID_REMOTE_SOCKET )
+			Shutdown();
+		return;
+	}
+
+	if ( !Listen() )
+		return;
+
+	if ( m_nViewerSocket == INVALID_REMOTE_SOCKET )
+	{
+		m_nViewerSocket = accept( m_nListenSocket, nullptr, nullptr );
+		if ( m_nViewerSocket == INVALID_REMOTE_SOCKET )
+			return;
+
+		SetNonBlocking( m_nViewerSocket );
+		int nNoDelay = 1;
+		setsockopt( m_nViewerSocket, IPPROTO_TCP, TCP_NODELAY, (const char *)&nNoDelay, sizeof( nNoDelay ) );
+
+		Msg( "imgui_remote: Viewer connected\n" );
+
+		RemoteHello_t hello;
+		hello.nVersion = IMGUI_REMOTE_VERSION;
+		hello.nVertexSize = sizeof( ImDrawVert );
+		hello.nIndexSize = sizeof( ImDrawIdx );
+		QueueMessage( REMOTE_MSG_HELLO, (const unsigned char *)&hello, sizeof( hello ), 0, CRC32_ProcessSingleBuffer( &hello, sizeof( hello ) ) );
+		SendFontAtlas();
+		m_bNeedKeyFrame = true;
+	}
+
+	ReceiveInput();
+	Flush();
+
+	// Roll the counters over once a second
+	const double flNow = Plat_FloatTime();
+	const double flElapsed = flNow - m_flStatsStart;
+	if ( flElapsed >= 1.0 )
+	{
+		m_flBandwidth = m_nBytesSent / flElapsed;
+		m_flFrameRate = m_nFramesSent / flElapsed;
+		m_flAvgEncodeTime = m_nFramesSent ? m_flEncodeTime / m_nFramesSent : 0.0f;
+		m_flCompressionRatio = m_nBytesSent ? (float)m_nRawBytes / m_nBytesSent : 0.0f;
+		m_nDroppedPerSecond = m_nFramesDropped;
+
+		m_flStatsStart = flNow;
+		m_nBytesSent = m_nFramesSent = m_nFramesDropped = m_nRawBytes = 0;
+		m_flEncodeTime = 0.0f;
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Read input messages from the viewer and feed them to imgui
+//---------------------------------------------------------------------------------------//
+void CDearImGuiRemote::ReceiveInput()
+{
+	unsigned char buf[4096];
+	for ( ;; )
+	{
+		const int nRead = recv( m_nViewerSocket, (char *)buf, sizeof( buf ), 0 );
+		if ( nRead > 0 )
+		{
+			m_RecvBuffer.AddMultipleToTail( nRead, buf );
+			continue;
+		}
+
+		if ( nRead < 0 && IMGUI_SOCKET_WOULDBLOCK() )
+			break;
+
+		Disconnect();
+		return;
+	}
+
+	ImGuiIO &io = ImGui::GetIO();
+	int nOffset = 0;
+	while ( m_RecvBuffer.Count() - nOffset >= (int)sizeof( RemoteMsgHeader_t ) )
+	{
+		RemoteMsgHeader_t header;
+		memcpy( &header, m_RecvBuffer.Base() + nOffset, sizeof( header ) );
+		if ( header.nMagic != IMGUI_REMOTE_MAGIC || header.nType != REMOTE_MSG_INPUT || header.nFlags != 0 ||
+			 header.nSize > MAX_REMOTE_INPUT_SIZE || header.nSize % sizeof( RemoteInputEvent_t ) != 0 )
+		{
+			Warning( "imgui_remote: Viewer sent an invalid message\n" );
+			Disconnect();
+			return;
+		}
+
+		if ( m_RecvBuffer.Count() - nOffset < (int)( sizeof( header ) + header.nSize ) )
+			break;
+
+		const unsigned char *pPayload = m_RecvBuffer.Base() + nOffset + sizeof( header );
+		const int nEvents = header.nSize / sizeof( RemoteInputEvent_t );
+		for ( int i = 0; i < nEvents; i++ )
+		{
+			RemoteInputEvent_t event;
+			memcpy( &event, pPayload + i * sizeof( RemoteInputEvent_t ), sizeof( event ) );
+			switch ( event.nType )
+			{
+			case REMOTE_INPUT_MOUSE_POS:
+				io.AddMousePosEvent( event.x, event.y );
+				break;
+			case REMOTE_INPUT_MOUSE_BUTTON:
+				if ( event.nCode < ImGuiMouseButton_COUNT )
+					io.AddMouseButtonEvent( event.nCode, event.bDown != 0 );
+				break;
+			case REMOTE_INPUT_MOUSE_WHEEL:
+				io.AddMouseWheelEvent( event.x, event.y );
+				break;
+			case REMOTE_INPUT_KEY:
+				if ( ImGui::IsNamedKey( (ImGuiKey)event.nCode ) )
+					io.AddKeyEvent( (ImGuiKey)event.nCode, event.bDown != 0 );
+				break;
+			case REMOTE_INPUT_CHAR:
+				io.AddInputCharacter( event.nCode );
+				break;
+			}
+		}
+
+		nOffset += sizeof( header ) + header.nSize;
+	}
+
+	m_RecvBuffer.RemoveMultipleFromHead( nOffset );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Send as much of the queue as the socket will take without blocking
+//---------------------------------------------------------------------------------------//
+void CDearImGuiRemote::Flush()
+{
+	int nSent = 0;
+	while ( nSent < m_SendQueue.Count() )
+	{
+		const int n = send( m_nViewerSocket, (const char *)m_SendQueue.Base() + nSent, m_SendQueue.Count() - nSent, IMGUI_SEND_FLAGS );
+		if ( n < 0 )
+		{
+			if ( IMGUI_SOCKET_WOULDBLOCK() )
+				break;
+
+			Disconnect();
+			return;
+		}
+		nSent += n;
+	}
+
+	m_nBytesSent += nSent;
+	m_SendQueue.RemoveMultipleFromHead( nSent );
+	VPROF_INCREMENT_COUNTER( "ImGui remote bytes sent", nSent );
+}
+
+void CDearImGuiRemote::QueueMessage( RemoteMsgType_t eType, const unsigned char *pData, int nSize, uint16 nFlags, uint32 nCRC )
+{
+	RemoteMsgHeader_t header;
+	header.nMagic = IMGUI_REMOTE_MAGIC;
+	header.nType = (uint16)eType;
+	header.nFlags = nFlags;
+	header.nSize = nSize;
+	header.nRawSize = nSize;
+	header.nCRC = nCRC;
+
+	m_SendQueue.AddMultipleToTail( sizeof( header ), (const unsigned char *)&header );
+	m_SendQueue.AddMultipleToTail( nSize, pData );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Queue a message, compressed if that makes it any smaller
+//---------------------------------------------------------------------------------------//
+void CDearImGuiRemote::QueueCompressed( RemoteMsgType_t eType, const unsigned char *pData, int nSize, uint16 nFlags, uint32 nCRC )
+{
+	m_Compressed.SetCount( nSize );
+
+	CLZSS lzss;
+	unsigned int nCompressedSize = 0;
+	if ( nSize > 64 && lzss.CompressNoAlloc( const_cast<unsigned char *>( pData ), nSize, m_Compressed.Base(), &nCompressedSize ) )
+	{
+		QueueMessage( eType, m_Compressed.Base(), nCompressedSize, nFlags | REMOTE_FLAG_COMPRESSED, nCRC );
+
+		RemoteMsgHeader_t *pHeader = (RemoteMsgHeader_t *)( m_SendQueue.Base() + m_SendQueue.Count() - nCompressedSize - sizeof( RemoteMsgHeader_t ) );
+		pHeader->nRawSize = nSize;
+	}
+	else
+	{
+		QueueMessage( eType, pData, nSize, nFlags, nCRC );
+	}
+
+	m_nRawBytes += nSize;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: The atlas only changes on rebuilds, so it's sent once per connection
+//---------------------------------------------------------------------------------------//
+void CDearImGuiRemote::SendFontAtlas()
+{
+	ImFontAtlas scratch;
+	unsigned char *pPixels;
+	int nWidth, nHeight;
+	ImGui_ImplSource_GetFontsTexData( ImGui::GetIO().Fonts, scratch, &pPixels, &nWidth, &nHeight );
+
+	CUtlVector<unsigned char> payload;
+	RemoteAtlasHeader_t header;
+	header.nWidth = nWidth;
+	header.nHeight = nHeight;
+	payload.AddMultipleToTail( sizeof( header ), (const unsigned char *)&header );
+	payload.AddMultipleToTail( 4 * nWidth * nHeight, pPixels );
+
+	QueueCompressed( REMOTE_MSG_FONT_ATLAS, payload.Base(), payload.Count(), 0, CRC32_ProcessSingleBuffer( payload.Base(), payload.Count() ) );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Flatten draw data into m_Frame. Vertices and indices are stored as imgui
+//  has them, texture ids are replaced with an index.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiRemote::SerializeFrame( const ImDrawData *pDrawData )
+{
+	const ImTextureID fontTexture = ImGui::GetIO().Fonts->TexID;
+
+	m_Frame.RemoveAll();
+
+	RemoteFrameHeader_t frameHeader;
+	frameHeader.flDisplayPos[0] = pDrawData->DisplayPos.x;
+	frameHeader.flDisplayPos[1] = pDrawData->DisplayPos.y;
+	frameHeader.flDisplaySize[0] = pDrawData->DisplaySize.x;
+	frameHeader.flDisplaySize[1] = pDrawData->DisplaySize.y;
+	frameHeader.nLists = pDrawData->CmdListsCount;
+	m_Frame.AddMultipleToTail( sizeof( frameHeader ), (const unsigned char *)&frameHeader );
+
+	for ( int n = 0; n < pDrawData->CmdListsCount; n++ )
+	{
+		const ImDrawList *pList = pDrawData->CmdLists[n];
+
+		RemoteListHeader_t listHeader;
+		listHeader.nCmds = 0;
+		listHeader.nVertices = pList->VtxBuffer.Size;
+		listHeader.nIndices = pList->IdxBuffer.Size;
+		const int nListHeader = m_Frame.AddMultipleToTail( sizeof( listHeader ) );
+
+		for ( int i = 0; i < pList->CmdBuffer.Size; i++ )
+		{
+			const ImDrawCmd &cmd = pList->CmdBuffer[i];
+			if ( cmd.UserCallback || !cmd.ElemCount )
+				continue;
+
+			RemoteCmd_t remoteCmd;
+			remoteCmd.flClipRect[0] = cmd.ClipRect.x;
+			remoteCmd.flClipRect[1] = cmd.ClipRect.y;
+			remoteCmd.flClipRect[2] = cmd.ClipRect.z;
+			remoteCmd.flClipRect[3] = cmd.ClipRect.w;
+			remoteCmd.nTexture = cmd.GetTexID() == fontTexture ? 0 : 1;
+			remoteCmd.nVtxOffset = cmd.VtxOffset;
+			remoteCmd.nIdxOffset = cmd.IdxOffset;
+			remoteCmd.nElemCount = cmd.ElemCount;
+			m_Frame.AddMultipleToTail( sizeof( remoteCmd ), (const unsigned char *)&remoteCmd );
+			listHeader.nCmds++;
+		}
+
+		memcpy( m_Frame.Base() + nListHeader, &listHeader, sizeof( listHeader ) );
+		m_Frame.AddMultipleToTail( pList->VtxBuffer.size_in_bytes(), (const unsigned char *)pList->VtxBuffer.Data );
+		m_Frame.AddMultipleToTail( pList->IdxBuffer.size_in_bytes(), (const unsigned char *)pList->IdxBuffer.Data );
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Encode a frame against the previous one and queue it for the viewer
+//---------------------------------------------------------------------------------------//
+void CDearImGuiRemote::SendFrame( const ImDrawData *pDrawData )
+{
+	if ( !IsConnected() || !pDrawData )
+		return;
+
+	VPROF_BUDGET( "CDearImGuiRemote::SendFrame", VPROF_BUDGETGROUP_IMGUI );
+
+	// Let a slow viewer catch up rather than queueing without bound. Deltas are always
+	// against the last frame queued, so skipping a frame is safe.
+	if ( m_SendQueue.Count() > imgui_remote_max_queue.GetInt() * 1024 )
+	{
+		m_nFramesDropped++;
+		Flush();
+		return;
+	}
+
+	CFastTimer encodeTimer;
+	encodeTimer.Start();
+
+	SerializeFrame( pDrawData );
+
+	// Nothing changed, the viewer still has this frame on screen
+	if ( !m_bNeedKeyFrame && m_Frame.Count() == m_PrevFrame.Count() && !memcmp( m_Frame.Base(), m_PrevFrame.Base(), m_Frame.Count() ) )
+	{
+		encodeTimer.End();
+		m_flEncodeTime += encodeTimer.GetDuration().GetMillisecondsF();
+		return;
+	}
+
+	const uint32 nCRC = CRC32_ProcessSingleBuffer( m_Frame.Base(), m_Frame.Count() );
+	if ( m_bNeedKeyFrame || ++m_nFramesSinceKeyFrame >= imgui_remote_keyframe_interval.GetInt() )
+	{
+		QueueCompressed( REMOTE_MSG_FRAME, m_Frame.Base(), m_Frame.Count(), 0, nCRC );
+		m_bNeedKeyFrame = false;
+		m_nFramesSinceKeyFrame = 0;
+	}
+	else
+	{
+		m_Delta.SetCount( m_Frame.Count() );
+		XorBuffers( m_Delta.Base(), m_Frame.Base(), m_Frame.Count(), m_PrevFrame.Base(), m_PrevFrame.Count() );
+		QueueCompressed( REMOTE_MSG_FRAME, m_Delta.Base(), m_Delta.Count(), REMOTE_FLAG_DELTA, nCRC );
+	}
+
+	m_PrevFrame.Swap( m_Frame );
+	m_nFramesSent++;
+
+	encodeTimer.End();
+	m_flEncodeTime += encodeTimer.GetDuration().GetMillisecondsF();
+	VPROF_INCREMENT_COUNTER( "ImGui remote encode us", (int)encodeTimer.GetDuration().GetMicroseconds() );
+
+	Flush();
+}
+
+void CDearImGuiRemote::PrintStatus() const
+{
+	if ( m_nListenSocket == INVALID_REMOTE_SOCKET )
+	{
+		Msg( "imgui_remote: Not listening, set imgui_remote 1\n" );
+		return;
+	}
+
+	Msg( "imgui_remote: Listening on 127.0.0.1:%d, %s\n", m_nListenPort, IsConnected() ? "viewer connected" : "no viewer" );
+	Msg( "  %.1f frames/s, %.1f KB/s, %.3f ms encode per frame, %.1f:1 compression, %d frames dropped/s, %d bytes queued\n",
+		m_flFrameRate, m_flBandwidth / 1024.0f, m_flAvgEncodeTime, m_flCompressionRatio, m_nDroppedPerSecond, m_SendQueue.Count() );
+}
+
+CON_COMMAND_F( imgui_remote_status, "Prints imgui_remote bandwidth and encode time", FCVAR_CLIENTDLL )
+{
+	g_ImGuiRemote.PrintStatus();
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Stand-in viewer running on a thread in this process. It decodes every frame
+//  and checks it against the CRC the server sent, and exercises the input path.
+//---------------------------------------------------------------------------------------//
+class CDearImGuiRemoteLoopback
+{
+public:
+	void Start();
+	void Stop();
+	bool IsRunning() const { return m_hThread != nullptr; }
+	void PrintStatus() const;
+
+private:
+	static unsigned ThreadProc( void *pParam );
+	void Run();
+	bool RecvAll( intp nSocket, void *pDest, int nSize );
+
+	ThreadHandle_t m_hThread = nullptr;
+	CInterlockedInt m_bStop;
+	int m_nPort = 0;
+
+	CInterlockedInt m_nFrames;
+	CInterlockedInt m_nDeltaFrames;
+	CInterlockedInt m_nBytes;
+	CInterlockedInt m_nMismatches;
+};
+
+static CDearImGuiRemoteLoopback g_ImGuiRemoteLoopback;
+
+// The thread mustn't outlive the DLL
+static void StopRemoteLoopback()
+{
+	g_ImGuiRemoteLoopback.Stop();
+}
+
+void CDearImGuiRemoteLoopback::Start()
+{
+	if ( IsRunning() || !InitSockets() )
+		return;
+
+	m_bStop = 0;
+	m_nFrames = m_nDeltaFrames = m_nBytes = m_nMismatches = 0;
+	m_nPort = imgui_remote_port.GetInt();
+	m_hThread = CreateSimpleThread( ThreadProc, this );
+}
+
+void CDearImGuiRemoteLoopback::Stop()
+{
+	if ( !IsRunning() )
+		return;
+
+	m_bStop = 1;
+	ThreadJoin( m_hThread );
+	ReleaseThreadHandle( m_hThread );
+	m_hThread = nullptr;
+}
+
+unsigned CDearImGuiRemoteLoopback::ThreadProc( void *pParam )
+{
+	static_cast<CDearImGuiRemoteLoopback *>( pParam )->Run();
+	return 0;
+}
+
+bool CDearImGuiRemoteLoopback::RecvAll( intp nSocket, void *pDest, int nSize )
+{
+	char *pCur = static_cast<char *>( pDest );
+	while ( nSize > 0 )
+	{
+		if ( m_bStop )
+			return false;
+
+		fd_set readSet;
+		FD_ZERO( &readSet );
+		FD_SET( nSocket, &readSet );
+		timeval timeout = { 0, 100 * 1000 };
+		const int nReady = select( (int)nSocket + 1, &readSet, nullptr, nullptr, &timeout );
+		if ( nReady < 0 )
+			return false;
+		if ( nReady == 0 )
+			continue;
+
+		const int nRead = recv( nSocket, pCur, nSize, 0 );
+		if ( nRead <= 0 )
+			return false;
+
+		pCur += nRead;
+		nSize -= nRead;
+		m_nBytes += nRead;
+	}
+	return true;
+}
+
+void CDearImGuiRemoteLoopback::Run()
+{
+	intp nSocket = socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+	if ( nSocket == INVALID_REMOTE_SOCKET )
+		return;
+
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons( (uint16)m_nPort );
+	addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+
+	if ( connect( nSocket, (sockaddr *)&addr, sizeof( addr ) ) != 0 )
+	{
+		Warning( "imgui_remote_loopback: Failed to connect to port %d\n", m_nPort );
+		CloseRemoteSocket( nSocket );
+		return;
+	}
+
+	CUtlVector<unsigned char> payload, decoded, previous;
+	double flLastInput = 0.0;
+
+	RemoteMsgHeader_t header;
+	while ( RecvAll( nSocket, &header, sizeof( header ) ) )
+	{
+		if ( header.nMagic != IMGUI_REMOTE_MAGIC )
+			break;
+
+		payload.SetCount( header.nSize );
+		if ( header.nSize && !RecvAll( nSocket, payload.Base(), header.nSize ) )
+			break;
+
+		decoded.SetCount( header.nRawSize );
+		if ( header.nFlags & REMOTE_FLAG_COMPRESSED )
+		{
+			CLZSS lzss;
+			if ( CLZSS::GetActualSize( payload.Base() ) != header.nRawSize || lzss.Uncompress( payload.Base(), decoded.Base() ) != header.nRawSize )
+			{
+				m_nMismatches++;
+				continue;
+			}
+		}
+		else if ( header.nSize )
+		{
+			memcpy( decoded.Base(), payload.Base(), header.nSize );
+		}
+
+		if ( header.nFlags & REMOTE_FLAG_DELTA )
+		{
+			XorBuffers( decoded.Base(), decoded.Base(), decoded.Count(), previous.Base(), previous.Count() );
+			m_nDeltaFrames++;
+		}
+
+		if ( CRC32_ProcessSingleBuffer( decoded.Base(), decoded.Count() ) != header.nCRC )
+			m_nMismatches++;
+
+		if ( header.nType == REMOTE_MSG_FRAME )
+		{
+			previous.Swap( decoded );
+			m_nFrames++;
+		}
+
+		// Send a harmless mouse move now and then, so the input path gets used
+		const double flNow = Plat_FloatTime();
+		if ( flNow - flLastInput > 1.0 )
+		{
+			flLastInput = flNow;
+
+			RemoteInputEvent_t event = {};
+			event.nType = REMOTE_INPUT_MOUSE_POS;
+			event.x = event.y = -FLT_MAX;
+
+			RemoteMsgHeader_t inputHeader = {};
+			inputHeader.nMagic = IMGUI_REMOTE_MAGIC;
+			inputHeader.nType = REMOTE_MSG_INPUT;
+			inputHeader.nSize = inputHeader.nRawSize = sizeof( event );
+			inputHeader.nCRC = CRC32_ProcessSingleBuffer( &event, sizeof( event ) );
+
+			unsigned char msg[sizeof( inputHeader ) + sizeof( event )];
+			memcpy( msg, &inputHeader, sizeof( inputHeader ) );
+			memcpy( msg + sizeof( inputHeader ), &event, sizeof( event ) );
+			send( nSocket, (const char *)msg, sizeof( msg ), IMGUI_SEND_FLAGS );
+		}
+	}
+
+	CloseRemoteSocket( nSocket );
+}
+
+void CDearImGuiRemoteLoopback::PrintStatus() const
+{
+	Msg( "imgui_remote_loopback: %s, %d frames (%d deltas), %d KB received, %d decode mismatches\n",
+		IsRunning() ? "running" : "stopped", (int)m_nFrames, (int)m_nDeltaFrames, m_nBytes / 1024, (int)m_nMismatches );
+}
+
+CON_COMMAND_F( imgui_remote_loopback, "Starts or stops an in-process viewer that decodes and verifies imgui_remote frames", FCVAR_CLIENTDLL )
+{
+	if ( g_ImGuiRemoteLoopback.IsRunning() )
+	{
+		g_ImGuiRemoteLoopback.Stop();
+		g_ImGuiRemoteLoopback.PrintStatus();
+		return;
+	}
+
+	if ( !imgui_remote.GetBool() )
+		imgui_remote.SetValue( 1 );
+	g_ImGuiRemoteLoopback.Start();
+}
+
+CON_COMMAND_F( imgui_remote_loopback_status, "Prints what the imgui_remote_loopback viewer has received", FCVAR_CLIENTDLL )
+{
+	g_ImGuiRemoteLoopback.PrintStatus();
+}
@@ -0,0 +1,181 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#pragma once
+
+#include "imgui/imgui.h"
+#include "utlvector.h"
+
+//--------------------------------------------------------------------------------//
+// Wire format shared with viewers. Every message starts with a RemoteMsgHeader_t,
+// all values are little endian.
+//--------------------------------------------------------------------------------//
+#define IMGUI_REMOTE_MAGIC		0x49474d49	// 'IMGI'
+#define IMGUI_REMOTE_VERSION	1
+
+enum RemoteMsgType_t
+{
+	REMOTE_MSG_HELLO = 0,		// Server -> viewer, payload is RemoteHello_t
+	REMOTE_MSG_FONT_ATLAS,		// Server -> viewer, RemoteAtlasHeader_t followed by RGBA8888 pixels
+	REMOTE_MSG_FRAME,			// Server -> viewer, a serialized ImDrawData, see SerializeFrame
+	REMOTE_MSG_INPUT,			// Viewer -> server, an array of RemoteInputEvent_t
+};
+
+enum RemoteMsgFlags_t
+{
+	REMOTE_FLAG_COMPRESSED	= ( 1 << 0 ),	// Payload is CLZSS compressed
+	REMOTE_FLAG_DELTA		= ( 1 << 1 ),	// Payload is XORed against the previous frame
+};
+
+#pragma pack( push, 1 )
+struct RemoteMsgHeader_t
+{
+	uint32 nMagic;
+	uint16 nType;
+	uint16 nFlags;
+	uint32 nSize;			// Bytes of payload following this header
+	uint32 nRawSize;		// Bytes of payload once decompressed
+	uint32 nCRC;			// CRC32 of the decoded payload
+};
+
+struct RemoteHello_t
+{
+	uint32 nVersion;
+	uint32 nVertexSize;
+	uint32 nIndexSize;
+};
+
+struct RemoteAtlasHeader_t
+{
+	uint32 nWidth;
+	uint32 nHeight;
+};
+
+struct RemoteFrameHeader_t
+{
+	float flDisplayPos[2];
+	float flDisplaySize[2];
+	uint32 nLists;
+};
+
+struct RemoteListHeader_t
+{
+	uint32 nCmds;
+	uint32 nVertices;
+	uint32 nIndices;
+};
+
+struct RemoteCmd_t
+{
+	float flClipRect[4];
+	uint32 nTexture;		// 0 for the font atlas, 1 for anything else
+	uint32 nVtxOffset;
+	uint32 nIdxOffset;
+	uint32 nElemCount;
+};
+
+enum RemoteInputType_t
+{
+	REMOTE_INPUT_MOUSE_POS = 0,
+	REMOTE_INPUT_MOUSE_BUTTON,
+	REMOTE_INPUT_MOUSE_WHEEL,
+	REMOTE_INPUT_KEY,			// nCode is an ImGuiKey
+	REMOTE_INPUT_CHAR,			// nCode is a UTF-32 codepoint
+};
+
+struct RemoteInputEvent_t
+{
+	uint8 nType;
+	uint8 bDown;
+	uint16 nPad;
+	uint32 nCode;
+	float x, y;
+};
+#pragma pack( pop )
+
+//--------------------------------------------------------------------------------//
+// Purpose: Streams each frame's draw data to an external viewer over a local TCP
+//  socket, and feeds the viewer's input back into ImGuiIO
+//--------------------------------------------------------------------------------//
+class CDearImGuiRemote
+{
+public:
+	// Accepts viewers and applies their input. Called before NewFrame.
+	void Update();
+
+	// Encodes and queues the frame for the connected viewer. Called after ImGui::Render.
+	void SendFrame( const ImDrawData *pDrawData );
+
+	void Shutdown();
+
+	// Resends the atlas and a full frame to the connected viewer
+	void OnFontAtlasChanged();
+
+	bool IsConnected() const;
+
+	// False while a viewer is connected and local rendering has been turned off
+	bool ShouldRenderLocally() const;
+
+	void PrintStatus() const;
+
+private:
+	bool Listen();
+	void Disconnect();
+	void Flush();
+	void ReceiveInput();
+	void QueueMessage( RemoteMsgType_t eType, const unsigned char *pData, int nSize, uint16 nFlags, uint32 nCRC );
+	void QueueCompressed( RemoteMsgType_t eType, const unsigned char *pData, int nSize, uint16 nFlags, uint32 nCRC );
+	void SendFontAtlas();
+	void SerializeFrame( const ImDrawData *pDrawData );
+
+	intp m_nListenSocket = -1;
+	intp m_nViewerSocket = -1;
+	int m_nListenPort = 0;
+
+	bool m_bNeedKeyFrame = true;
+	int m_nFramesSinceKeyFrame = 0;
+
+	CUtlVector<unsigned char> m_Frame;
+	CUtlVector<unsigned char> m_PrevFrame;
+	CUtlVector<unsigned char> m_Delta;
+	CUtlVector<unsigned char> m_Compressed;
+	CUtlVector<unsigned char> m_SendQueue;
+	CUtlVector<unsigned char> m_RecvBuffer;
+
+	// Counters, reset every second
+	double m_flStatsStart = 0.0;
+	int m_nBytesSent = 0;
+	int m_nFramesSent = 0;
+	int m_nFramesDropped = 0;
+	float m_flEncodeTime = 0.0f;
+	int m_nRawBytes = 0;
+
+	// Last complete second
+	float m_flBandwidth = 0.0f;		// Bytes per second
+	float m_flFrameRate = 0.0f;
+	float m_flAvgEncodeTime = 0.0f;	// Milliseconds per frame
+	float m_flCompressionRatio = 0.0f;
+	int m_nDroppedPerSecond = 0;
+};
+
+extern CDearImGuiRemote g_ImGuiRemote;
@@ -24,16 +24,35 @@
 #include "imgui_system.h"
 #include "imgui_window.h"
 
+#include "cdll_client_int.h"
 #include "filesystem.h"
 #include "fmtstr.h"
+#include "imgui_allocstats.h"
+#include "imgui_commandpalette.h"
+#include "imgui_dataprovider.h"
+#include "imgui_debugdraw.h"
+#include "imgui_drawcapture.h"
+#include "imgui_fontatlas.h"
+#include "imgui_format.h"
+#include "imgui_glyphcache.h"
 #include "imgui_impl_source.h"
+#include "imgui_playback.h"
+#include "imgui_remote.h"
+#include "imgui_trace.h"
+#include "imgui_worldlabels.h"
 #include "inputsystem/iinputsystem.h"
 #include "materialsystem/imaterialsystem.h"
 #include "strtools.h"
+#include "tier0/fasttimer.h"
+#include "tier0/vprof.h"
 #include "tier2/tier2.h"
 #include "tier3/tier3.h"
 #include "utldict.h"
+#include "utlmap.h"
+#include "utlsymbol.h"
+#include "vstdlib/jobthread.h"
 #include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
 
 #include <vgui/IInput.h>
 #include <vgui/ISurface.h>
@@ -53,15 +72,57 @@ CUtlVector<IImguiWindow *> &ImGuiWindows();
 
 static ConVar imgui_font_scale( "imgui_font_scale", "1", FCVAR_ARCHIVE, "Global scale applied to Imgui fonts" );
 static ConVar imgui_display_scale( "imgui_display_scale", "1", FCVAR_ARCHIVE, "Global imgui scale, usually used for Hi-DPI displays" );
+static ConVar imgui_window_budget( "imgui_window_budget", "2", FCVAR_ARCHIVE, "Milliseconds per frame shared by throttled windows when rebuilding their contents" );
+static ConVar imgui_window_scheduler( "imgui_window_scheduler", "1", FCVAR_NONE, "Throttle windows that declare a refresh rate or frame budget" );
+static ConVar imgui_memory_budget( "imgui_memory_budget", "8192", FCVAR_ARCHIVE, "KB imgui may keep allocated before buffers of inactive windows are released early, 0 for no limit" );
+static ConVar imgui_memory_compact_time( "imgui_memory_compact_time", "30", FCVAR_ARCHIVE, "Seconds a window has to be closed or inactive before its buffers are released, -1 to never release them" );
+static ConVar imgui_font_keep_pixels( "imgui_font_keep_pixels", "0", FCVAR_NONE, "Keep a CPU copy of the font atlas after it's been uploaded" );
+
+// Running totals, sampled around each frame for ImGuiFrameStats_t
+static CInterlockedInt g_nImGuiAllocations;
+static CInterlockedInt g_nImGuiAllocatedBytes;
+
+// Bytes currently allocated by imgui, checked against imgui_memory_budget
+static CInterlockedInt g_nImGuiLiveBytes;
+
+// Blocks start with the size imgui asked for, so frees don't have to ask tier0. Keeps the
+// alignment of what tier0 returned.
+#define IMGUI_ALLOC_HEADER	16
 
 void *ImGui_MemAlloc( size_t sz, void *user_data )
 {
-	return MemAlloc_Alloc( sz, "Dear ImGui", 0 );
+	++g_nImGuiAllocations;
+	g_nImGuiAllocatedBytes += static_cast<int>( sz );
+
+	// Tagged by what the thread is doing, which also names it in tier0's dumps
+	const char *pszTag = "Dear ImGui";
+	if ( const CDearImGuiAllocScope *pScope = CDearImGuiAllocScope::GetCurrent() )
+	{
+		pszTag = pScope->GetTagName();
+		g_ImGuiAllocStats.Record( pScope->GetTag(), static_cast<int>( sz ) );
+	}
+	else
+	{
+		IMGUI_ALLOC_RECORD( "Dear ImGui", static_cast<int>( sz ) );
+	}
+
+	unsigned char *pBlock = static_cast<unsigned char *>( MemAlloc_Alloc( sz + IMGUI_ALLOC_HEADER, pszTag, 0 ) );
+	if ( !pBlock )
+		return nullptr;
+
+	*reinterpret_cast<size_t *>( pBlock ) = sz;
+	g_nImGuiLiveBytes += static_cast<int>( sz );
+	return pBlock + IMGUI_ALLOC_HEADER;
 }
 
 static void ImGui_MemFree( void *ptr, void *user_data )
 {
-	MemAlloc_Free( ptr );
+	if ( !ptr )
+		return;
+
+	unsigned char *pBlock = static_cast<unsigned char *>( ptr ) - IMGUI_ALLOC_HEADER;
+	g_nImGuiLiveBytes -= static_cast<int>( *reinterpret_cast<size_t *>( pBlock ) );
+	MemAlloc_Free( pBlock );
 }
 
 //---------------------------------------------------------------------------------------//
@@ -80,6 +141,70 @@ void RegisterImGuiWindowFactory( IImguiWindow *pWindow )
 }
 
 
+//---------------------------------------------------------------------------------------//
+// Purpose: Works out whether any part of an active window can be seen. Windows in front
+//  of it use their rects from the previous frame, they haven't been submitted yet.
+//---------------------------------------------------------------------------------------//
+static ImguiWindowVisibility_t ComputeWindowVisibility( ImGuiWindow *pWindow )
+{
+	ImGuiContext &g = *GImGui;
+	const ImRect rect = pWindow->Rect();
+
+	if ( !rect.Overlaps( ImRect( ImVec2( 0.0f, 0.0f ), g.IO.DisplaySize ) ) )
+		return IMGUI_WINDOW_OFFSCREEN;
+
+	if ( g.Style.Alpha < 1.0f )
+		return IMGUI_WINDOW_VISIBLE;
+
+	// g.Windows is in display order, back to front
+	const int nIndex = g.Windows.index_from_ptr( g.Windows.find( pWindow ) );
+	for ( int i = g.Windows.Size - 1; i > nIndex; i-- )
+	{
+		ImGuiWindow *pOther = g.Windows[i];
+		if ( pOther->RootWindow != pOther || !pOther->WasActive || pOther->Hidden || pOther->Collapsed )
+			continue;
+
+		if ( pOther->Flags & ImGuiWindowFlags_NoBackground )
+			continue;
+
+		const ImGuiCol bgCol = ( pOther->Flags & ImGuiWindowFlags_Popup ) ? ImGuiCol_PopupBg : ImGuiCol_WindowBg;
+		if ( g.Style.Colors[bgCol].w < 1.0f )
+			continue;
+
+		if ( pOther->Rect().Contains( rect ) )
+			return IMGUI_WINDOW_OCCLUDED;
+	}
+
+	return IMGUI_WINDOW_VISIBLE;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: VProf nodes and trace events keep the name pointer, which would dangle once the
+//			DLL that registered a window unloads. The table is never freed so neither can.
+//---------------------------------------------------------------------------------------//
+static const char *InternWindowName( const char *pszName )
+{
+	static CUtlSymbolTable *s_pNames = new CUtlSymbolTable;
+	return s_pNames->String( s_pNames->AddString( pszName ) );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Bytes held by an imgui window's buffers between frames
+//---------------------------------------------------------------------------------------//
+static int GetImGuiWindowRetainedBytes( const ImGuiWindow *pWindow )
+{
+	const ImDrawList *pDrawList = pWindow->DrawList;
+	int nBytes = pDrawList->CmdBuffer.Capacity * sizeof( ImDrawCmd ) +
+				 pDrawList->IdxBuffer.Capacity * sizeof( ImDrawIdx ) +
+				 pDrawList->VtxBuffer.Capacity * sizeof( ImDrawVert ) +
+				 pDrawList->_Path.Capacity * sizeof( ImVec2 );
+
+	nBytes += pWindow->IDStack.Capacity * sizeof( ImGuiID ) +
+			  pWindow->ColumnsStorage.Capacity * sizeof( ImGuiOldColumns ) +
+			  pWindow->StateStorage.Data.Capacity * sizeof( ImGuiStoragePair );
+	return nBytes;
+}
+
 //---------------------------------------------------------------------------------------//
 // Purpose: Implementation of the imgui system
 //---------------------------------------------------------------------------------------//
@@ -88,6 +213,8 @@ class CDearImGuiSystem : public IImguiSystem
 	using BaseClass = IImguiSystem;
 
 public:
+	CDearImGuiSystem() : m_WindowSchedules( DefLessFunc( IImguiWindow * ) ), m_RetainedFragments( DefLessFunc( ImGuiID ) ) {}
+
 	// IAppSystem
 	bool Init() override;
 	void Shutdown() override;
@@ -95,14 +222,65 @@ public:
 	// IDearImGuiSystem
 	DearImGuiSysData_t GetData() override;
 	void Render() override;
+	void RenderOverlay() override;
 	void RegisterWindowFactories( IImguiWindow **arrpWindows, int nCount ) override;
 	IImguiWindow *FindWindow( const char *szName ) override;
 	void UnregisterWindowFactories( IImguiWindow **ppWindows, int nCount ) override;
 	void GetAllWindows( CUtlVector<IImguiWindow *> &windows ) override;
 	void SetWindowVisible( IImguiWindow* pWindow, bool bVisible, bool bEnableInput ) override;
-
+	const ImGuiFrameStats_t &GetFrameStats() override { return m_FrameStats; }
+	void AddDebugLine( float x1, float y1, float x2, float y2, Color color, float flDuration, int nFlags ) override;
+	void AddDebugRect( float x1, float y1, float x2, float y2, Color color, float flDuration, int nFlags ) override;
+	void AddDebugCircle( float x, float y, float flRadius, Color color, float flDuration, int nFlags ) override;
+	void AddDebugText( float x, float y, Color color, float flDuration, int nFlags, const char *pszFormat, ... ) override;
+	void AddWorldLabel( const Vector &vecOrigin, const char *pszText, Color color, int nPriority, float flMaxDistance ) override;
+	void RegisterDataProvider( IImguiDataProvider *pProvider ) override;
+	void UnregisterDataProvider( IImguiDataProvider *pProvider ) override;
+	bool BeginRetained( const char *pszId, int nVersion ) override;
+	void EndRetained() override;
+
+	bool BeginFrame();
+	void EndFrame();
+	void OnFontAtlasChanged();
+	void CompactMemory();
+	void RunDataProviders();
+	void DrawMemoryWindow();
 	bool DrawWindow( IImguiWindow *pWindow );
 
+	// State kept for windows throttled by the scheduler
+	struct WindowSchedule_t
+	{
+		CImDrawListCapture capture;
+		bool bCaptured = false;
+		bool bRebuild = false;
+		ImVec2 vecPos;
+		ImVec2 vecSize;
+		ImVec2 vecScroll;
+		ImVec2 vecContentSize;
+		double flLastBuildTime = 0.0;
+		double flLastUsedTime = 0.0;
+		int nFramesSinceBuild = 0;
+		float flAverageCost = 0.0f;
+	};
+
+	WindowSchedule_t *GetWindowSchedule( IImguiWindow *pWindow );
+	void ScheduleWindows( bool bOverlaysOnly );
+	bool ReplayWindow( WindowSchedule_t *pSchedule );
+	void CaptureWindow( WindowSchedule_t *pSchedule, float flCost );
+
+	// A block of a window recorded with BeginRetained, keyed by its imgui ID
+	struct RetainedFragment_t
+	{
+		CImDrawListCapture capture;
+		bool bCaptured = false;
+		int nVersion = 0;
+		ImVec2 vecPos;
+		ImVec2 vecSize;
+		double flLastUsedTime = 0.0;
+	};
+
+	void PurgeRetainedFragments( double flUnusedSince );
+
 	void PushInputContext();
 	void PopInputContext();
 
@@ -116,15 +294,37 @@ public:
 	bool IsDrawingMenuBar() const { return m_bDrawMenuBar; }
 	void ToggleMenuBar() { m_bDrawMenuBar = !m_bDrawMenuBar; }
 
+	struct DataProviderState_t
+	{
+		IImguiDataProvider *pProvider;
+		CJob *pJob;
+		double flLastRunTime;
+	};
+
 public:
 	CUtlDict<IImguiWindow *> m_ImGuiWindows;
+	CUtlVector<DataProviderState_t> m_DataProviders;
+	CUtlMap<IImguiWindow *, WindowSchedule_t *> m_WindowSchedules;
+	CUtlMap<ImGuiID, RetainedFragment_t *> m_RetainedFragments;
+	CUtlVector<RetainedFragment_t *> m_RetainedStack;	// Fragments being recorded
 
 	double m_flLastFrameTime;
+	double m_flFrameStartTime = 0.0;
+	ImGuiFrameStats_t m_FrameStats = {};
+	CFastTimer m_FrameTimer;
+	int m_nFrameAllocationsStart = 0;
+	int m_nFrameAllocatedBytesStart = 0;
+	int m_nGlyphGeneration = 0;
+
+	// True while drawing from RenderOverlay, without the input popup
+	bool m_bOverlayFrame = false;
 	bool m_bInputEnabled = false;
 
 	bool m_bDrawMenuBar = false;
 	bool m_bDrawMetrics = false;
 	bool m_bDrawDemo = false;
+	bool m_bDrawMemory = false;
+	bool m_bCompactNow = false;
 	CDummyOverlayPanel* m_pInputOverlay = nullptr;
 };
 
@@ -153,7 +353,10 @@ public:
 	{
 		auto& io = ImGui::GetIO();
 		if ( io.WantCaptureMouse )
+		{
+			g_ImGuiTrace.Instant( "Mouse pressed" );
 			io.AddMouseButtonEvent( code - MOUSE_FIRST, true );
+		}
 	}
 	
 	void OnMouseReleased( ButtonCode_t code ) override
@@ -161,6 +364,7 @@ public:
 		auto& io = ImGui::GetIO();
 		if ( io.WantCaptureMouse )
 		{
+			g_ImGuiTrace.Instant( "Mouse released" );
 			io.AddMouseButtonEvent( code - MOUSE_FIRST, false );
 		}
 	}
@@ -168,6 +372,7 @@ public:
 	void OnMouseWheeled( int delta ) override
 	{
 		auto& io = ImGui::GetIO();
+		g_ImGuiTrace.Instant( "Mouse wheeled" );
 		io.AddMouseWheelEvent( 0, delta );
 	}
 	
@@ -185,20 +390,27 @@ public:
 	{
 		auto& io = ImGui::GetIO();
 		if ( io.WantCaptureKeyboard )
+		{
+			g_ImGuiTrace.Instant( "Key typed" );
 			io.AddInputCharacter( code );
+		}
 	}
 	
 	// always pass keycodes to imgui, WantCaptureKeyboard should NOT affect whether or not we do this
 	void OnKeyCodePressed( vgui::KeyCode code ) override
 	{
 		auto& io = ImGui::GetIO();
+		g_ImGuiTrace.Instant( "Key pressed" );
 		io.AddKeyEvent( IMGUI_KEY_TABLE[code], true );
+		ImGui_ImplSource_AddModifierEvent( io, IMGUI_KEY_TABLE[code], true );
 	}
 	
 	void OnKeyCodeReleased( vgui::KeyCode code ) override
 	{
 		auto& io = ImGui::GetIO();
+		g_ImGuiTrace.Instant( "Key released" );
 		io.AddKeyEvent( IMGUI_KEY_TABLE[code], false );
+		ImGui_ImplSource_AddModifierEvent( io, IMGUI_KEY_TABLE[code], false );
 	}
 	
 	void Paint() override
@@ -228,8 +440,9 @@ public:
 bool CDearImGuiSystem::Init()
 {
 	ImGui::SetAllocatorFunctions( ImGui_MemAlloc, ImGui_MemFree, nullptr );
-	ImFontAtlas *atlas = new ImFontAtlas();
+	ImFontAtlas *atlas = IM_NEW( ImFontAtlas );
 	ImGui::CreateContext( atlas );
+	g_ImGuiGlyphCache.Reserve( atlas );
 	ImGui_ImplSource_Init();
 
 	SetStyle();
@@ -249,9 +462,21 @@ bool CDearImGuiSystem::Init()
 void CDearImGuiSystem::Shutdown()
 {
 	g_pImguiSystem->UnregisterWindowFactories( ImGuiWindows().Base(), ImGuiWindows().Count() );
+	while ( m_DataProviders.Count() )
+		UnregisterDataProvider( m_DataProviders.Tail().pProvider );
+	PurgeRetainedFragments( DBL_MAX );
+	g_ImGuiTextCache.Purge();
+	g_ImGuiGlyphCache.Reset();
+	g_ImGuiFontAtlas.Shutdown();
 	ImGui_ImplSource_Shutdown();
+	g_ImGuiRemote.Shutdown();
+	g_ImGuiDebugDraw.Clear();
+	g_ImGuiWorldLabels.Clear();
 
+	// The atlas was handed to CreateContext, so it's ours to free
+	ImFontAtlas *pAtlas = ImGui::GetIO().Fonts;
 	ImGui::DestroyContext();
+	IM_DELETE( pAtlas );
 }
 
 DearImGuiSysData_t CDearImGuiSystem::GetData()
@@ -264,48 +489,199 @@ DearImGuiSysData_t CDearImGuiSystem::GetData()
 }
 
 //---------------------------------------------------------------------------------------//
-// Purpose: Render all imgui windows
+// Purpose: Update the IO and start a new imgui frame. Returns false if there's nothing
+//  to draw into.
 //---------------------------------------------------------------------------------------//
-void CDearImGuiSystem::Render()
+bool CDearImGuiSystem::BeginFrame()
 {
+	// Captures start and end between frames, so no scope is left open
+	g_ImGuiTrace.Update();
+	IMGUI_TRACE_SCOPE( "BeginFrame" );
+
+	// A window returned without ending its retained fragments
+	Assert( !m_RetainedStack.Count() );
+	m_RetainedStack.RemoveAll();
+
 	// Update the IO
 	auto &io = ImGui::GetIO();
 
-	// Create input overlay helper if it doesn't yet exist
-	if ( !m_pInputOverlay )
-	{
-		m_pInputOverlay = new CDummyOverlayPanel();
-	}
-
 	// Update the screen size before drawing
 	CMatRenderContextPtr pRenderContext( materials );
 	int w, h;
 	pRenderContext->GetWindowSize( w, h );
 	if ( !w || !h )
-		return;
+		return false;
 
-	m_pInputOverlay->SetSize( w, h );
-	
 	io.DisplaySize.x = static_cast<float>( w );
 	io.DisplaySize.y = static_cast<float>( h );
 	io.DisplayFramebufferScale.x = io.DisplayFramebufferScale.y = imgui_display_scale.GetFloat();
-	io.FontGlobalScale = imgui_font_scale.GetFloat();
+	io.ConfigMemoryCompactTimer = imgui_memory_compact_time.GetFloat();
+
+	// Fonts are baked at the UI scale, FontGlobalScale only stretches them while a rebake
+	// is catching up
+	if ( g_ImGuiFontAtlas.Update( imgui_font_scale.GetFloat() * imgui_display_scale.GetFloat() ) )
+		OnFontAtlasChanged();
+	io.FontGlobalScale = g_ImGuiFontAtlas.GetFontGlobalScale();
+
+	// Typed characters may be outside the baked ranges. Added or evicted glyphs invalidate
+	// vertices the same way a new atlas does: captures replayed from before would keep
+	// drawing the fallback glyph, or a cell that now holds another one.
+	for ( int i = 0; i < io.InputQueueCharacters.Size; i++ )
+		g_ImGuiGlyphCache.Request( io.InputQueueCharacters[i] );
+	g_ImGuiGlyphCache.Update();
+	if ( m_nGlyphGeneration != g_ImGuiGlyphCache.GetGeneration() )
+	{
+		m_nGlyphGeneration = g_ImGuiGlyphCache.GetGeneration();
+		OnFontAtlasChanged();
+	}
+
+	// Scripted playback replaces real input and the frame delta
+	if ( g_ImGuiPlayback.IsActive() )
+		g_ImGuiPlayback.BeginFrame( io );
+
+	m_FrameTimer.Start();
+	m_flFrameStartTime = Plat_FloatTime();
+
+	{
+		IMGUI_TRACE_SCOPE( "RunDataProviders" );
+		RunDataProviders();
+	}
+	m_nFrameAllocationsStart = g_nImGuiAllocations;
+	m_nFrameAllocatedBytesStart = g_nImGuiAllocatedBytes;
 
 	// Create new frame
-	ImGui::NewFrame();
+	{
+		VPROF_BUDGET( "ImGui::NewFrame", VPROF_BUDGETGROUP_IMGUI );
+		tmZone( TELEMETRY_LEVEL1, TMZF_NONE, "ImGui::NewFrame" );
+		// The input events queued by the panel are applied in here
+		IMGUI_TRACE_SCOPE( "ImGui::NewFrame" );
+		ImGui::NewFrame();
+	}
 
-	// Draw menubar first
-	if ( m_bDrawMenuBar )
-		DrawMenuBar();
+	return true;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: A rebaked font atlas was swapped in, drop anything built from the old one
+//---------------------------------------------------------------------------------------//
+void CDearImGuiSystem::OnFontAtlasChanged()
+{
+	FOR_EACH_MAP_FAST( m_WindowSchedules, i )
+	{
+		m_WindowSchedules[i]->capture.Purge();
+		m_WindowSchedules[i]->bCaptured = false;
+	}
+
+	FOR_EACH_MAP_FAST( m_RetainedFragments, i )
+	{
+		m_RetainedFragments[i]->capture.Purge();
+		m_RetainedFragments[i]->bCaptured = false;
+	}
+
+	g_ImGuiTextCache.Purge();
+	g_ImGuiRemote.OnFontAtlasChanged();
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Finish the frame started by BeginFrame and submit it
+//---------------------------------------------------------------------------------------//
+void CDearImGuiSystem::EndFrame()
+{
+	IMGUI_TRACE_SCOPE( "EndFrame" );
+	IMGUI_ALLOC_SCOPE( "ImGui render" );
+	auto &io = ImGui::GetIO();
+
+	if ( g_ImGuiWorldLabels.HasWork() )
+		g_ImGuiWorldLabels.Flush( ImGui::GetForegroundDrawList(), engine->WorldToScreenMatrix(), io.DisplaySize.x, io.DisplaySize.y );
+
+	if ( g_ImGuiDebugDraw.HasWork() )
+		g_ImGuiDebugDraw.Flush( ImGui::GetBackgroundDrawList(), ImGui::GetForegroundDrawList() );
+
+	{
+		VPROF_BUDGET( "ImGui::Render", VPROF_BUDGETGROUP_IMGUI );
+		tmZone( TELEMETRY_LEVEL1, TMZF_NONE, "ImGui::Render" );
+		IMGUI_TRACE_SCOPE( "ImGui::Render" );
+		ImGui::Render();
+	}
+
+	ImDrawData *drawdata = ImGui::GetDrawData();
+	g_ImGuiGlyphCache.MarkDrawn( drawdata );
+	if ( drawdata && g_ImGuiRemote.ShouldRenderLocally() )
+		m_FrameStats.nDrawCalls = ImGui_ImplSource_RenderDrawData( drawdata );
+	else
+		m_FrameStats.nDrawCalls = 0;
+
+	g_ImGuiRemote.SendFrame( drawdata );
+
+	m_FrameTimer.End();
+	m_FrameStats.flCpuTime = m_FrameTimer.GetDuration().GetMillisecondsF();
+	m_FrameStats.nAllocations = g_nImGuiAllocations - m_nFrameAllocationsStart;
+	m_FrameStats.nAllocatedBytes = g_nImGuiAllocatedBytes - m_nFrameAllocatedBytesStart;
+	m_FrameStats.nVertices = drawdata ? drawdata->TotalVtxCount : 0;
+	m_FrameStats.nIndices = drawdata ? drawdata->TotalIdxCount : 0;
+	m_FrameStats.nDrawLists = drawdata ? drawdata->CmdListsCount : 0;
+
+	VPROF_INCREMENT_COUNTER( "ImGui allocations", m_FrameStats.nAllocations );
+	VPROF_INCREMENT_COUNTER( "ImGui allocated bytes", m_FrameStats.nAllocatedBytes );
 
-	// Draw imgui-specific debug menus
-	if ( m_bDrawDemo )
-		ImGui::ShowDemoWindow( &m_bDrawDemo );
+	if ( g_ImGuiPlayback.IsActive() )
+		g_ImGuiPlayback.EndFrame( m_FrameStats );
 
-	if ( m_bDrawMetrics )
-		ImGui::ShowMetricsWindow( &m_bDrawMetrics );
+	CompactMemory();
+
+	// Post render, update deltas
+	auto curtime = Plat_FloatTime();
+	auto dt = curtime - m_flLastFrameTime;
+	m_flLastFrameTime = curtime;
+
+	io.DeltaTime = static_cast<float>( dt );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Render all imgui windows
+//---------------------------------------------------------------------------------------//
+void CDearImGuiSystem::Render()
+{
+	VPROF_BUDGET( "CDearImGuiSystem::Render", VPROF_BUDGETGROUP_IMGUI );
+	tmZone( TELEMETRY_LEVEL0, TMZF_NONE, "%s", __FUNCTION__ );
+	IMGUI_ALLOC_SCOPE( "ImGui frame" );
+
+	// Create input overlay helper if it doesn't yet exist
+	if ( !m_pInputOverlay )
+	{
+		m_pInputOverlay = new CDummyOverlayPanel();
+	}
+
+	g_ImGuiRemote.Update();
+
+	const bool bPlayback = g_ImGuiPlayback.IsActive();
+	if ( !BeginFrame() )
+		return;
+
+	const ImVec2 &displaySize = ImGui::GetIO().DisplaySize;
+	m_pInputOverlay->SetSize( static_cast<int>( displaySize.x ), static_cast<int>( displaySize.y ) );
+
+	// Playback only measures its own windows
+	if ( !bPlayback )
+	{
+		// Draw menubar first
+		if ( m_bDrawMenuBar )
+			DrawMenuBar();
+
+		// Draw imgui-specific debug menus
+		if ( m_bDrawDemo )
+			ImGui::ShowDemoWindow( &m_bDrawDemo );
+
+		if ( m_bDrawMetrics )
+			ImGui::ShowMetricsWindow( &m_bDrawMetrics );
+
+		if ( m_bDrawMemory )
+			DrawMemoryWindow();
+	}
 
 	// Draw everything else
+	ScheduleWindows( false );
+
 	bool bDrawn = false;
 	FOR_EACH_DICT( m_ImGuiWindows, i )
 	{
@@ -317,39 +693,512 @@ void CDearImGuiSystem::Render()
 		}
 	}
 
-	ImGui::Render();
-	ImDrawData *drawdata = ImGui::GetDrawData();
-	if ( drawdata )
-		ImGui_ImplSource_RenderDrawData( drawdata );
+	// Drawn last so it opens on top of everything
+	if ( !bPlayback )
+	{
+		if ( ImGui::IsKeyChordPressed( ImGuiMod_Ctrl | ImGuiKey_P ) )
+			g_ImGuiCommandPalette.Open();
 
-	// Post render, update deltas
-	auto curtime = Plat_FloatTime();
-	auto dt = curtime - m_flLastFrameTime;
-	m_flLastFrameTime = curtime;
+		if ( g_ImGuiCommandPalette.IsOpen() )
+			g_ImGuiCommandPalette.Draw();
+	}
 
-	io.DeltaTime = static_cast<float>( dt );
+	EndFrame();
 	
 	// Deactivate our overlay if nothing is being drawn anymore
-	if ( !bDrawn && !m_bDrawDemo && !m_bDrawMetrics && !m_bDrawMenuBar )
+	if ( !bDrawn && !m_bDrawDemo && !m_bDrawMetrics && !m_bDrawMenuBar && !g_ImGuiCommandPalette.IsOpen() )
 	{
 		PopInputContext();
 	}
 }
 
+//---------------------------------------------------------------------------------------//
+// Purpose: Draw overlay windows without the input popup. Called from the client's
+//  post-HUD render, does nothing while Render() is being driven by the popup.
+//  While a remote viewer is connected every window is drawn here, so it can be
+//  used without the popup.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiSystem::RenderOverlay()
+{
+	if ( m_bInputEnabled || g_ImGuiPlayback.IsActive() )
+		return;
+
+	g_ImGuiRemote.Update();
+	const bool bRemote = g_ImGuiRemote.IsConnected();
+
+	bool bHasOverlays = bRemote || g_ImGuiDebugDraw.HasWork() || g_ImGuiWorldLabels.HasWork();
+	FOR_EACH_DICT( m_ImGuiWindows, i )
+	{
+		if ( m_ImGuiWindows[i]->IsOverlay() && m_ImGuiWindows[i]->ShouldDraw() )
+		{
+			bHasOverlays = true;
+			break;
+		}
+	}
+
+	if ( !bHasOverlays )
+		return;
+
+	IMGUI_ALLOC_SCOPE( "ImGui frame" );
+	VPROF_BUDGET( "CDearImGuiSystem::RenderOverlay", VPROF_BUDGETGROUP_IMGUI );
+	tmZone( TELEMETRY_LEVEL0, TMZF_NONE, "%s", __FUNCTION__ );
+
+	if ( !BeginFrame() )
+		return;
+
+	// The remote viewer gets regular, interactive windows
+	m_bOverlayFrame = !bRemote;
+	ScheduleWindows( !bRemote );
+
+	if ( bRemote && m_bDrawMenuBar )
+		DrawMenuBar();
+
+	FOR_EACH_DICT( m_ImGuiWindows, i )
+	{
+		auto *pWindow = m_ImGuiWindows[i];
+		if ( ( bRemote || pWindow->IsOverlay() ) && pWindow->ShouldDraw() )
+			DrawWindow( pWindow );
+	}
+
+	if ( bRemote && g_ImGuiCommandPalette.IsOpen() )
+		g_ImGuiCommandPalette.Draw();
+
+	m_bOverlayFrame = false;
+	EndFrame();
+}
+
 //---------------------------------------------------------------------------------------//
 // Purpose: Draws a window
 //---------------------------------------------------------------------------------------//
 bool CDearImGuiSystem::DrawWindow( IImguiWindow *pWindow )
 {
+	IMGUI_ALLOC_SCOPE( "ImGui windows" );
+	if ( g_ImGuiPlayback.IsActive() )
+		g_ImGuiPlayback.SetupWindow( pWindow );
+
+	ImGuiWindowFlags flags = pWindow->GetFlags();
+	if ( m_bOverlayFrame )
+		flags |= ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoFocusOnAppearing | ImGuiWindowFlags_NoBringToFrontOnFocus;
+
 	bool closeButton = pWindow->ShouldDraw();
-	ImGui::Begin( pWindow->GetWindowTitle(), &closeButton, pWindow->GetFlags() );
+	const bool bBegun = ImGui::Begin( pWindow->GetWindowTitle(), &closeButton, flags );
 	pWindow->SetDraw( closeButton );
 
-	bool stayOpen = pWindow->Draw();
+	// Begin returns false when collapsed or clipped, anything submitted would be thrown away
+	if ( !bBegun )
+	{
+		pWindow->SetVisibility( IMGUI_WINDOW_COLLAPSED );
+		ImGui::End();
+		return true;
+	}
+
+	const ImguiWindowVisibility_t eVisibility = ComputeWindowVisibility( ImGui::GetCurrentWindow() );
+	pWindow->SetVisibility( eVisibility );
+	if ( eVisibility != IMGUI_WINDOW_VISIBLE && pWindow->SkipDrawWhenHidden() )
+	{
+		ImGui::End();
+		return true;
+	}
+
+	// Throttled windows re-use their previous output when they aren't due
+	WindowSchedule_t *pSchedule = GetWindowSchedule( pWindow );
+	if ( pSchedule )
+		pSchedule->flLastUsedTime = Plat_FloatTime();
+
+	if ( pSchedule && ReplayWindow( pSchedule ) )
+	{
+		ImGui::End();
+		return true;
+	}
+
+	if ( pSchedule )
+		pSchedule->capture.Begin( ImGui::GetWindowDrawList() );
+
+	CFastTimer drawTimer;
+	drawTimer.Start();
+
+	bool stayOpen;
+	{
+		const char *pszName = InternWindowName( pWindow->GetName() );
+		VPROF_BUDGET( pszName, VPROF_BUDGETGROUP_IMGUI );
+		tmZone( TELEMETRY_LEVEL1, TMZF_NONE, "%s", pszName );
+		IMGUI_TRACE_SCOPE( pszName );
+		stayOpen = pWindow->Draw();
+	}
+
+	drawTimer.End();
+	if ( pSchedule )
+		CaptureWindow( pSchedule, drawTimer.GetDuration().GetMillisecondsF() );
+
 	ImGui::End();
 	return stayOpen;
 }
 
+//---------------------------------------------------------------------------------------//
+// Purpose: Returns the scheduler state for a window, or null if it isn't throttled
+//---------------------------------------------------------------------------------------//
+CDearImGuiSystem::WindowSchedule_t *CDearImGuiSystem::GetWindowSchedule( IImguiWindow *pWindow )
+{
+	if ( !imgui_window_scheduler.GetBool() || g_ImGuiPlayback.IsActive() )
+		return nullptr;
+
+	if ( pWindow->GetRefreshRate() <= 0.0f && pWindow->GetFrameBudget() <= 0.0f )
+		return nullptr;
+
+	auto it = m_WindowSchedules.Find( pWindow );
+	if ( it == m_WindowSchedules.InvalidIndex() )
+		it = m_WindowSchedules.Insert( pWindow, new WindowSchedule_t );
+	return m_WindowSchedules[it];
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Decide which throttled windows get rebuilt this frame. Windows that are due
+//  are rebuilt longest-waiting first, for as long as the global budget allows. Only
+//  the windows drawn this frame count against it.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiSystem::ScheduleWindows( bool bOverlaysOnly )
+{
+	const double flNow = Plat_FloatTime();
+
+	CUtlVector<WindowSchedule_t *> due;
+	FOR_EACH_DICT( m_ImGuiWindows, i )
+	{
+		IImguiWindow *pWindow = m_ImGuiWindows[i];
+		if ( !pWindow->ShouldDraw() || ( bOverlaysOnly && !pWindow->IsOverlay() ) )
+			continue;
+
+		WindowSchedule_t *pSchedule = GetWindowSchedule( pWindow );
+		if ( !pSchedule )
+			continue;
+
+		pSchedule->bRebuild = false;
+		pSchedule->nFramesSinceBuild++;
+
+		if ( !pSchedule->bCaptured )
+		{
+			pSchedule->bRebuild = true;
+			continue;
+		}
+
+		const float flRate = pWindow->GetRefreshRate();
+		if ( flRate > 0.0f && flNow - pSchedule->flLastBuildTime < 1.0 / flRate )
+			continue;
+
+		// Over budget windows are rebuilt every Nth frame so their average cost stays within it
+		const float flBudget = pWindow->GetFrameBudget();
+		if ( flBudget > 0.0f && pSchedule->nFramesSinceBuild * flBudget < pSchedule->flAverageCost )
+			continue;
+
+		due.AddToTail( pSchedule );
+	}
+
+	due.Sort( []( WindowSchedule_t *const *a, WindowSchedule_t *const *b )
+		{
+			if ( ( *a )->flLastBuildTime == ( *b )->flLastBuildTime )
+				return 0;
+			return ( *a )->flLastBuildTime < ( *b )->flLastBuildTime ? -1 : 1;
+		} );
+
+	// The longest waiting window always gets to go, so nothing starves
+	const float flGlobalBudget = imgui_window_budget.GetFloat();
+	float flSpent = 0.0f;
+	FOR_EACH_VEC( due, i )
+	{
+		if ( i > 0 && flSpent + due[i]->flAverageCost > flGlobalBudget )
+			break;
+
+		due[i]->bRebuild = true;
+		flSpent += due[i]->flAverageCost;
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Replays a throttled window's previous output. Returns false if it has to be
+//  rebuilt instead, either because it's due or because the user is interacting with it.
+//---------------------------------------------------------------------------------------//
+bool CDearImGuiSystem::ReplayWindow( WindowSchedule_t *pSchedule )
+{
+	if ( pSchedule->bRebuild || !pSchedule->bCaptured )
+		return false;
+
+	ImGuiWindow *pImWindow = ImGui::GetCurrentWindow();
+	if ( pImWindow->Size.x != pSchedule->vecSize.x || pImWindow->Size.y != pSchedule->vecSize.y ||
+		 pImWindow->Scroll.x != pSchedule->vecScroll.x || pImWindow->Scroll.y != pSchedule->vecScroll.y )
+		return false;
+
+	if ( ImGui::IsWindowHovered( ImGuiHoveredFlags_RootAndChildWindows ) || ImGui::IsWindowFocused( ImGuiFocusedFlags_RootAndChildWindows ) )
+		return false;
+
+	ImVec2 vecOffset( pImWindow->Pos.x - pSchedule->vecPos.x, pImWindow->Pos.y - pSchedule->vecPos.y );
+	pSchedule->capture.Replay( pImWindow->DrawList, vecOffset );
+
+	// Keep the content size, so scrollbars and auto-resize don't collapse
+	ImGui::Dummy( pSchedule->vecContentSize );
+	return true;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Store what a throttled window just drew, including its child windows
+//---------------------------------------------------------------------------------------//
+void CDearImGuiSystem::CaptureWindow( WindowSchedule_t *pSchedule, float flCost )
+{
+	IMGUI_ALLOC_SCOPE( "ImGui retained" );
+	ImGuiWindow *pImWindow = ImGui::GetCurrentWindow();
+	pSchedule->capture.End( pImWindow->DrawList );
+
+	CUtlVector<ImGuiWindow *> children;
+	children.AddMultipleToTail( pImWindow->DC.ChildWindows.Size, pImWindow->DC.ChildWindows.Data );
+	for ( int i = 0; i < children.Count(); i++ )
+	{
+		ImGuiWindow *pChild = children[i];
+		if ( !pChild->Active || pChild->Hidden )
+			continue;
+
+		pSchedule->capture.AddDrawList( pChild->DrawList );
+		children.AddMultipleToTail( pChild->DC.ChildWindows.Size, pChild->DC.ChildWindows.Data );
+	}
+
+	pSchedule->bCaptured = true;
+	pSchedule->vecPos = pImWindow->Pos;
+	pSchedule->vecSize = pImWindow->Size;
+	pSchedule->vecScroll = pImWindow->Scroll;
+	pSchedule->vecContentSize = ImVec2( pImWindow->DC.CursorMaxPos.x - pImWindow->DC.CursorStartPos.x,
+										pImWindow->DC.CursorMaxPos.y - pImWindow->DC.CursorStartPos.y );
+	pSchedule->flLastBuildTime = Plat_FloatTime();
+	pSchedule->nFramesSinceBuild = 0;
+	pSchedule->flAverageCost = pSchedule->flAverageCost > 0.0f ? pSchedule->flAverageCost * 0.8f + flCost * 0.2f : flCost;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Replays a retained fragment at the cursor if its version hasn't changed,
+//  otherwise starts recording it
+//---------------------------------------------------------------------------------------//
+bool CDearImGuiSystem::BeginRetained( const char *pszId, int nVersion )
+{
+	ImGuiWindow *pImWindow = ImGui::GetCurrentWindow();
+	const ImGuiID id = ImGui::GetID( pszId );
+	const ImVec2 vecPos = ImGui::GetCursorScreenPos();
+
+	auto it = m_RetainedFragments.Find( id );
+	if ( it == m_RetainedFragments.InvalidIndex() )
+		it = m_RetainedFragments.Insert( id, new RetainedFragment_t );
+
+	RetainedFragment_t *pFragment = m_RetainedFragments[it];
+	pFragment->flLastUsedTime = m_flFrameStartTime;
+
+	if ( pFragment->bCaptured && pFragment->nVersion == nVersion )
+	{
+		VPROF_BUDGET( "CDearImGuiSystem::ReplayRetained", VPROF_BUDGETGROUP_IMGUI );
+		if ( ImGui::IsRectVisible( pFragment->vecSize ) )
+			pFragment->capture.Replay( pImWindow->DrawList, ImVec2( vecPos.x - pFragment->vecPos.x, vecPos.y - pFragment->vecPos.y ) );
+		ImGui::Dummy( pFragment->vecSize );
+		return false;
+	}
+
+	pFragment->nVersion = nVersion;
+	pFragment->vecPos = vecPos;
+	pFragment->capture.Begin( pImWindow->DrawList );
+	m_RetainedStack.AddToTail( pFragment );
+	ImGui::BeginGroup();
+	return true;
+}
+
+void CDearImGuiSystem::EndRetained()
+{
+	Assert( m_RetainedStack.Count() );
+	if ( !m_RetainedStack.Count() )
+		return;
+
+	RetainedFragment_t *pFragment = m_RetainedStack.Tail();
+	m_RetainedStack.RemoveMultipleFromTail( 1 );
+	ImGui::EndGroup();
+
+	ImGuiWindow *pImWindow = ImGui::GetCurrentWindow();
+	const ImRect rect( ImGui::GetItemRectMin(), ImGui::GetItemRectMax() );
+	pFragment->vecSize = rect.GetSize();
+
+	// Widgets outside the clip rect skip drawing, so a block that was partly hidden has to
+	// be drawn again instead of replaying what's missing
+	if ( !pImWindow->ClipRect.Contains( rect ) )
+	{
+		pFragment->capture.Purge();
+		pFragment->bCaptured = false;
+		return;
+	}
+
+	IMGUI_ALLOC_SCOPE( "ImGui retained" );
+	pFragment->capture.End( pImWindow->DrawList );
+	pFragment->bCaptured = true;
+}
+
+// Deletes the fragments last used before flUnusedSince
+void CDearImGuiSystem::PurgeRetainedFragments( double flUnusedSince )
+{
+	FOR_EACH_MAP_FAST( m_RetainedFragments, i )
+	{
+		if ( m_RetainedFragments[i]->flLastUsedTime < flUnusedSince )
+		{
+			delete m_RetainedFragments[i];
+			m_RetainedFragments.RemoveAt( i );
+		}
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Custom rects other than imgui's own and the glyph cache's page, which are
+//  restored without the atlas' pixels. Icons painted into them would be lost.
+//---------------------------------------------------------------------------------------//
+static bool HasUserCustomRects( const ImFontAtlas *pAtlas )
+{
+	for ( int i = 0; i < pAtlas->CustomRects.Size; i++ )
+	{
+		if ( i != pAtlas->PackIdMouseCursors && i != pAtlas->PackIdLines && !g_ImGuiGlyphCache.IsPageRect( pAtlas, i ) )
+			return true;
+	}
+	return false;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Release buffers nothing has used for a while. imgui compacts its own windows
+//  after io.ConfigMemoryCompactTimer, this covers our buffers and enforces the budget.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiSystem::CompactMemory()
+{
+	VPROF_BUDGET( "CDearImGuiSystem::CompactMemory", VPROF_BUDGETGROUP_IMGUI );
+
+	const double flNow = Plat_FloatTime();
+	const float flCompactTime = imgui_memory_compact_time.GetFloat();
+
+	g_ImGuiTextCache.Update();
+
+	// Asked for from the memory window, after the frame so nothing it drew is released
+	const bool bCompactAll = m_bCompactNow;
+	m_bCompactNow = false;
+
+	if ( flCompactTime >= 0.0f || bCompactAll )
+	{
+		FOR_EACH_MAP_FAST( m_WindowSchedules, i )
+		{
+			WindowSchedule_t *pSchedule = m_WindowSchedules[i];
+			if ( pSchedule->bCaptured && ( bCompactAll || flNow - pSchedule->flLastUsedTime > flCompactTime ) )
+			{
+				pSchedule->capture.Purge();
+				pSchedule->bCaptured = false;
+			}
+		}
+
+		PurgeRetainedFragments( bCompactAll ? DBL_MAX : flNow - flCompactTime );
+	}
+
+	// The backend can regenerate the texture from the font configs if the device is lost,
+	// but not what was painted into custom rects
+	ImFontAtlas *pAtlas = ImGui::GetIO().Fonts;
+	if ( pAtlas->TexPixelsRGBA32 && !imgui_font_keep_pixels.GetBool() && !HasUserCustomRects( pAtlas ) )
+		pAtlas->ClearTexData();
+
+	const int nBudget = imgui_memory_budget.GetInt() * 1024;
+	if ( !bCompactAll && ( nBudget <= 0 || g_nImGuiLiveBytes <= nBudget ) )
+		return;
+
+	// Over budget, release everything that wasn't drawn this frame without waiting
+	FOR_EACH_MAP_FAST( m_WindowSchedules, i )
+	{
+		WindowSchedule_t *pSchedule = m_WindowSchedules[i];
+		if ( pSchedule->bCaptured && pSchedule->flLastUsedTime < m_flFrameStartTime )
+		{
+			pSchedule->capture.Purge();
+			pSchedule->bCaptured = false;
+		}
+	}
+
+	PurgeRetainedFragments( m_flFrameStartTime );
+
+	ImGuiContext &g = *GImGui;
+	for ( int i = 0; i < g.Windows.Size; i++ )
+	{
+		ImGuiWindow *pImWindow = g.Windows[i];
+		if ( !pImWindow->Active && !pImWindow->WasActive && !pImWindow->MemoryCompacted )
+			ImGui::GcCompactTransientWindowBuffers( pImWindow );
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Debug view of what imgui is holding on to, per window
+//---------------------------------------------------------------------------------------//
+void CDearImGuiSystem::DrawMemoryWindow()
+{
+	if ( !ImGui::Begin( "ImGui Memory", &m_bDrawMemory ) )
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGuiContext &g = *GImGui;
+	const ImFontAtlas *pAtlas = ImGui::GetIO().Fonts;
+
+	ImGui::Text( "Allocated: %d KB", g_nImGuiLiveBytes / 1024 );
+	ImGui::SameLine();
+	if ( imgui_memory_budget.GetInt() > 0 )
+		ImGui::Text( "Budget: %d KB", imgui_memory_budget.GetInt() );
+	else
+		ImGui::TextUnformatted( "Budget: none" );
+	ImGui::Text( "Font atlas: %dx%d, CPU copy %s", pAtlas->TexWidth, pAtlas->TexHeight, pAtlas->TexPixelsRGBA32 ? "kept" : "released" );
+
+	size_t nFragmentBytes = 0;
+	FOR_EACH_MAP_FAST( m_RetainedFragments, i )
+		nFragmentBytes += m_RetainedFragments[i]->capture.GetRetainedBytes();
+	ImGui::Text( "Retained fragments: %d, %.1f KB", m_RetainedFragments.Count(), nFragmentBytes / 1024.0f );
+	ImGui::Text( "Cached text: %d", g_ImGuiTextCache.GetCount() );
+
+	if ( ImGui::Button( "Compact now" ) )
+		m_bCompactNow = true;
+
+	if ( ImGui::BeginTable( "##memory", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_SizingStretchProp ) )
+	{
+		ImGui::TableSetupColumn( "Window" );
+		ImGui::TableSetupColumn( "State" );
+		ImGui::TableSetupColumn( "Buffers (KB)" );
+		ImGui::TableSetupColumn( "Scheduler (KB)" );
+		ImGui::TableHeadersRow();
+
+		FOR_EACH_DICT( m_ImGuiWindows, i )
+		{
+			IImguiWindow *pWindow = m_ImGuiWindows[i];
+
+			// Child windows belong to the window they were created in
+			ImGuiWindow *pRoot = ImGui::FindWindowByName( pWindow->GetWindowTitle() );
+			int nBuffers = 0;
+			bool bCompacted = false;
+			if ( pRoot )
+			{
+				bCompacted = pRoot->MemoryCompacted;
+				for ( int n = 0; n < g.Windows.Size; n++ )
+				{
+					if ( g.Windows[n]->RootWindow == pRoot )
+						nBuffers += GetImGuiWindowRetainedBytes( g.Windows[n] );
+				}
+			}
+
+			auto it = m_WindowSchedules.Find( pWindow );
+			const int nScheduler = it != m_WindowSchedules.InvalidIndex() ? m_WindowSchedules[it]->capture.GetRetainedBytes() : 0;
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted( pWindow->GetName() );
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted( !pRoot ? "never shown" : bCompacted ? "compacted" : pWindow->ShouldDraw() ? "open" : "closed" );
+			ImGui::TableNextColumn();
+			g_ImGuiTextCache.Text( "%.1f", nBuffers / 1024.0f );
+			ImGui::TableNextColumn();
+			g_ImGuiTextCache.Text( "%.1f", nScheduler / 1024.0f );
+		}
+
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
+
 //---------------------------------------------------------------------------------------//
 // Purpose: Register all window factories from another DLL
 //---------------------------------------------------------------------------------------//
@@ -370,6 +1219,20 @@ void CDearImGuiSystem::UnregisterWindowFactories( IImguiWindow **ppWindows, int
 	for ( int i = 0; i < nCount; ++i )
 	{
 		m_ImGuiWindows.Remove( ppWindows[i]->GetName() );
+
+		// Providers are usually members of their window, which is about to be destroyed
+		FOR_EACH_VEC_BACK( m_DataProviders, j )
+		{
+			if ( m_DataProviders[j].pProvider->GetOwner() == ppWindows[i] )
+				UnregisterDataProvider( m_DataProviders[j].pProvider );
+		}
+
+		auto it = m_WindowSchedules.Find( ppWindows[i] );
+		if ( it != m_WindowSchedules.InvalidIndex() )
+		{
+			delete m_WindowSchedules[it];
+			m_WindowSchedules.RemoveAt( it );
+		}
 	}
 }
 
@@ -406,6 +1269,143 @@ void CDearImGuiSystem::SetWindowVisible( IImguiWindow* pWindow, bool bVisible, b
 		PopInputContext();
 }
 
+//---------------------------------------------------------------------------------------//
+// Purpose: Debug drawing from any thread, see CDearImGuiDebugDraw
+//---------------------------------------------------------------------------------------//
+static CDearImGuiDebugDraw::DebugDrawCmd_t MakeDebugDrawCmd( CDearImGuiDebugDraw::DebugDrawType_t eType, float x1, float y1, float x2, float y2, Color color, float flDuration, int nFlags )
+{
+	CDearImGuiDebugDraw::DebugDrawCmd_t cmd;
+	cmd.nType = (uint8)eType;
+	cmd.nFlags = (uint8)nFlags;
+	cmd.color = color;
+	cmd.flDuration = flDuration;
+	cmd.flExpireTime = 0.0;
+	cmd.x1 = x1;
+	cmd.y1 = y1;
+	cmd.x2 = x2;
+	cmd.y2 = y2;
+	cmd.szText[0] = '\0';
+	return cmd;
+}
+
+void CDearImGuiSystem::AddDebugLine( float x1, float y1, float x2, float y2, Color color, float flDuration, int nFlags )
+{
+	g_ImGuiDebugDraw.Add( MakeDebugDrawCmd( CDearImGuiDebugDraw::DEBUGDRAW_LINE, x1, y1, x2, y2, color, flDuration, nFlags ) );
+}
+
+void CDearImGuiSystem::AddDebugRect( float x1, float y1, float x2, float y2, Color color, float flDuration, int nFlags )
+{
+	g_ImGuiDebugDraw.Add( MakeDebugDrawCmd( CDearImGuiDebugDraw::DEBUGDRAW_RECT, x1, y1, x2, y2, color, flDuration, nFlags ) );
+}
+
+void CDearImGuiSystem::AddDebugCircle( float x, float y, float flRadius, Color color, float flDuration, int nFlags )
+{
+	g_ImGuiDebugDraw.Add( MakeDebugDrawCmd( CDearImGuiDebugDraw::DEBUGDRAW_CIRCLE, x, y, flRadius, 0.0f, color, flDuration, nFlags ) );
+}
+
+void CDearImGuiSystem::AddDebugText( float x, float y, Color color, float flDuration, int nFlags, const char *pszFormat, ... )
+{
+	CDearImGuiDebugDraw::DebugDrawCmd_t cmd = MakeDebugDrawCmd( CDearImGuiDebugDraw::DEBUGDRAW_TEXT, x, y, 0.0f, 0.0f, color, flDuration, nFlags );
+
+	va_list args;
+	va_start( args, pszFormat );
+	V_vsnprintf( cmd.szText, sizeof( cmd.szText ), pszFormat, args );
+	va_end( args );
+
+	g_ImGuiDebugDraw.Add( cmd );
+}
+
+void CDearImGuiSystem::AddWorldLabel( const Vector &vecOrigin, const char *pszText, Color color, int nPriority, float flMaxDistance )
+{
+	g_ImGuiWorldLabels.Add( vecOrigin, pszText, color, nPriority, flMaxDistance );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Data providers, see imgui_dataprovider.h
+//---------------------------------------------------------------------------------------//
+void CDearImGuiSystem::RegisterDataProvider( IImguiDataProvider *pProvider )
+{
+	if ( pProvider->IsRegistered() )
+		return;
+
+	DataProviderState_t &state = m_DataProviders[m_DataProviders.AddToTail()];
+	state.pProvider = pProvider;
+	state.pJob = nullptr;
+	state.flLastRunTime = 0.0;
+	pProvider->SetRegistered( true );
+
+	// Run it right away rather than on the next frame, its window is waiting on it
+	if ( pProvider->GatherOnMainThread() )
+	{
+		pProvider->Run();
+		state.flLastRunTime = Plat_FloatTime();
+	}
+}
+
+void CDearImGuiSystem::UnregisterDataProvider( IImguiDataProvider *pProvider )
+{
+	FOR_EACH_VEC( m_DataProviders, i )
+	{
+		DataProviderState_t &state = m_DataProviders[i];
+		if ( state.pProvider != pProvider )
+			continue;
+
+		// A job that hasn't started would otherwise run inline here, possibly on a provider
+		// whose most derived part is already destroyed
+		if ( state.pJob )
+		{
+			state.pJob->Abort();
+			state.pJob->WaitForFinishAndRelease();
+		}
+
+		pProvider->SetRegistered( false );
+		m_DataProviders.Remove( i );
+		return;
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Start every active provider that's due and isn't still running. Inactive ones
+//  are unregistered once they're done, so a hidden window can destroy its providers
+//  without waiting on them. GetSnapshot registers them again when the window is shown.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiSystem::RunDataProviders()
+{
+	VPROF_BUDGET( "CDearImGuiSystem::RunDataProviders", VPROF_BUDGETGROUP_IMGUI );
+
+	const double flNow = Plat_FloatTime();
+	FOR_EACH_VEC_BACK( m_DataProviders, i )
+	{
+		DataProviderState_t &state = m_DataProviders[i];
+		if ( state.pJob )
+		{
+			if ( !state.pJob->IsFinished() )
+				continue;
+
+			state.pJob->Release();
+			state.pJob = nullptr;
+		}
+
+		IImguiDataProvider *pProvider = state.pProvider;
+		if ( !pProvider->IsActive() )
+		{
+			pProvider->SetRegistered( false );
+			m_DataProviders.Remove( i );
+			continue;
+		}
+
+		const float flRate = pProvider->GetUpdateRate();
+		if ( flRate > 0.0f && flNow - state.flLastRunTime < 1.0 / flRate )
+			continue;
+
+		state.flLastRunTime = flNow;
+		if ( pProvider->GatherOnMainThread() )
+			pProvider->Run();
+		else
+			state.pJob = g_pThreadPool->QueueCall( pProvider, &IImguiDataProvider::Run );
+	}
+}
+
 //---------------------------------------------------------------------------------------//
 // Purpose: Push a new input context so we can show the mouse cursor
 //---------------------------------------------------------------------------------------//
@@ -428,6 +1428,9 @@ void CDearImGuiSystem::PopInputContext()
 {
 	m_pInputOverlay->Activate( false );
 	m_bInputEnabled = false;
+
+	// Overlay windows keep drawing, don't leave them hovered
+	ImGui::GetIO().AddMousePosEvent( -FLT_MAX, -FLT_MAX );
 }
 
 //---------------------------------------------------------------------------------------//
@@ -497,6 +1500,8 @@ void CDearImGuiSystem::DrawMenuBar()
 	{
 		if ( ImGui::BeginMenu( "File" ) )
 		{
+			if ( ImGui::MenuItem( "Command Palette", "Ctrl+P" ) )
+				g_ImGuiCommandPalette.Open();
 			if ( ImGui::MenuItem( "Close Menu" ) )
 			{
 				this->m_bDrawMenuBar = false;
@@ -523,6 +1528,7 @@ void CDearImGuiSystem::DrawMenuBar()
 		{
 			ImGui::MenuItem( "Show Demo Window", "", &m_bDrawDemo );
 			ImGui::MenuItem( "Show Metrics Window", "", &m_bDrawMetrics );
+			ImGui::MenuItem( "Show Memory Window", "", &m_bDrawMemory );
 
 			ImGui::EndMenu();
 		}
@@ -560,10 +1566,18 @@ public:
 
 	int CommandCompletionCallback( const char *partial, CUtlVector<CUtlString> &commands ) override
 	{
-		auto &windows = g_ImguiSystem.m_ImGuiWindows;
-		FOR_EACH_DICT( windows, i )
+		// partial is the whole line, including "imgui_show "
+		const char *pszName = V_strstr( partial, " " );
+		pszName = pszName ? pszName + 1 : "";
+
+		CDearImGuiCommandIndex &index = g_ImGuiCommandPalette.GetIndex();
+		index.Update();
+
+		CDearImGuiCommandIndex::Result_t results[COMMAND_COMPLETION_MAXITEMS];
+		const int nCount = index.Query( pszName, CDearImGuiCommandIndex::ENTRY_WINDOW, results, ARRAYSIZE( results ) );
+		for ( int i = 0; i < nCount; i++ )
 		{
-			commands.AddToTail( CFmtStr( "%s %s", "imgui_show", windows[i]->GetName() ).Get() );
+			commands.AddToTail( CFmtStr( "%s %s", "imgui_show", index.GetName( results[i].nEntry ) ).Get() );
 		}
 
 		return commands.Count();
@@ -573,6 +1587,15 @@ public:
 static CImGuiShowAutoCompletionFunctor g_ImGuiShowAutoComplete;
 static ConCommand imgui_show( "imgui_show", &g_ImGuiShowAutoComplete, "Toggles the specified imgui window", FCVAR_CLIENTDLL, &g_ImGuiShowAutoComplete );
 
+//---------------------------------------------------------------------------------------//
+// Purpose: Opens the command palette, bind it to open it from the game
+//---------------------------------------------------------------------------------------//
+CON_COMMAND_F( imgui_palette, "Opens the imgui command palette to search windows, convars and commands", FCVAR_CLIENTDLL )
+{
+	g_ImGuiCommandPalette.Open();
+	g_ImguiSystem.PushInputContext();
+}
+
 //---------------------------------------------------------------------------------------//
 // Purpose: Toggle input for imgui windows
 //---------------------------------------------------------------------------------------//
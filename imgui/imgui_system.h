@@ -24,9 +24,14 @@
 #pragma once
 
 #include "appframework/IAppSystem.h"
+#include "Color.h"
 #include "inputsystem/InputEnums.h"
+#include "mathlib/vector.h"
 #include "utlvector.h"
 
+// VPROF budget group for everything the imgui system does, windows may use it for their own scopes
+#define VPROF_BUDGETGROUP_IMGUI		_T("ImGui")
+
 struct DearImGuiSysData_t
 {
 	void *context;
@@ -35,6 +40,26 @@ struct DearImGuiSysData_t
 };
 
 class IImguiWindow;
+class IImguiDataProvider;
+
+// Cost of the most recent imgui frame, from NewFrame to the end of RenderDrawData
+struct ImGuiFrameStats_t
+{
+	float flCpuTime;			// Milliseconds
+	int nAllocations;			// Allocations made through the imgui allocator
+	int nAllocatedBytes;
+	int nVertices;
+	int nIndices;
+	int nDrawLists;
+	int nDrawCalls;
+};
+
+// Flags for the AddDebug* functions
+enum ImGuiDebugDrawFlags_t
+{
+	IMGUI_DEBUGDRAW_FILLED		= ( 1 << 0 ),	// Fill rects and circles instead of outlining them
+	IMGUI_DEBUGDRAW_BACKGROUND	= ( 1 << 1 ),	// Draw behind all windows instead of on top of them
+};
 
 abstract_class IImguiSystem
 {
@@ -47,6 +72,9 @@ public:
 
 	virtual void Render() = 0;
 
+	// Draws overlay windows while input is disabled, call from the client's post-HUD render
+	virtual void RenderOverlay() = 0;
+
 	virtual void RegisterWindowFactories( IImguiWindow * *arrpWindows, int nCount ) = 0;
 
 	virtual void UnregisterWindowFactories( IImguiWindow * *ppWindows, int nCount ) = 0;
@@ -56,6 +84,40 @@ public:
 	virtual void GetAllWindows( CUtlVector<IImguiWindow *> & windows ) = 0;
 	
 	virtual void SetWindowVisible( IImguiWindow* pWindow, bool bVisible, bool bEnableInput = true ) = 0;
+
+	virtual const ImGuiFrameStats_t &GetFrameStats() = 0;
+
+	// Debug drawing in screen space. These may be called from any thread, shapes show up on
+	// the next imgui frame and stay for flDuration seconds, or a single frame if it's 0.
+	virtual void AddDebugLine( float x1, float y1, float x2, float y2, Color color, float flDuration = 0.0f, int nFlags = 0 ) = 0;
+	virtual void AddDebugRect( float x1, float y1, float x2, float y2, Color color, float flDuration = 0.0f, int nFlags = 0 ) = 0;
+	virtual void AddDebugCircle( float x, float y, float flRadius, Color color, float flDuration = 0.0f, int nFlags = 0 ) = 0;
+	virtual void AddDebugText( float x, float y, Color color, float flDuration, int nFlags, PRINTF_FORMAT_STRING const char *pszFormat, ... ) FMTFUNCTION( 7, 8 ) = 0;
+
+	// World space label for the next frame, main thread only. Labels behind the camera, off
+	// screen, further than flMaxDistance (0 uses imgui_worldlabels_distance) or overlapping
+	// a label with a higher priority aren't drawn. An empty string draws a marker.
+	virtual void AddWorldLabel( const Vector &vecOrigin, const char *pszText, Color color, int nPriority = 0, float flMaxDistance = 0.0f ) = 0;
+
+	// Data providers register themselves the first time their snapshot is read, see imgui_dataprovider.h
+	virtual void RegisterDataProvider( IImguiDataProvider *pProvider ) = 0;
+	virtual void UnregisterDataProvider( IImguiDataProvider *pProvider ) = 0;
+
+	// Retained fragments, for static parts of a window drawn from IImguiWindow::Draw(). Returns
+	// true if the block has to be drawn, which must then be followed by EndRetained(). Returns
+	// false if the block's previous output was replayed at the cursor instead, which happens
+	// while nVersion stays the same. Bump the version whenever the content changes.
+	//
+	//	if ( g_pImguiSystem->BeginRetained( "legend", nLegendVersion ) )
+	//	{
+	//		DrawLegend();
+	//		g_pImguiSystem->EndRetained();
+	//	}
+	//
+	// Widgets in the block aren't submitted while it's replayed, so it should only draw,
+	// and it must not span table columns. It's laid out as a group.
+	virtual bool BeginRetained( const char *pszId, int nVersion ) = 0;
+	virtual void EndRetained() = 0;
 };
 
 extern IImguiSystem *g_pImguiSystem;
@@ -0,0 +1,1225 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#include "imgui_texteditor.h"
+#include "imgui_glyphcache.h"
+#include "imgui_window.h"
+
+#include "convar.h"
+#include "strtools.h"
+#include "tier0/vprof.h"
+#include "imgui/imgui_internal.h"
+
+#include "tier0/memdbgon.h"
+
+// Undo states kept, oldest are dropped first
+#define TEXTEDITOR_MAX_UNDO		256
+
+// Spaces per tab
+#define TEXTEDITOR_TAB_SIZE		4
+
+enum TextColor_t
+{
+	TEXTCOLOR_DEFAULT,
+	TEXTCOLOR_COMMENT,
+	TEXTCOLOR_STRING,
+	TEXTCOLOR_NUMBER,
+	TEXTCOLOR_KEYWORD,
+	TEXTCOLOR_PUNCTUATION,
+
+	TEXTCOLOR_COUNT
+};
+
+static const ImU32 s_TextColors[TEXTCOLOR_COUNT] =
+{
+	IM_COL32( 230, 230, 230, 255 ),
+	IM_COL32( 110, 160, 110, 255 ),
+	IM_COL32( 220, 165, 115, 255 ),
+	IM_COL32( 180, 215, 150, 255 ),
+	IM_COL32( 115, 165, 240, 255 ),
+	IM_COL32( 200, 200, 200, 255 ),
+};
+
+static const char *s_SquirrelKeywords[] =
+{
+	"base", "break", "case", "catch", "class", "clone", "const", "constructor", "continue", "default", "delete",
+	"else", "enum", "extends", "false", "for", "foreach", "function", "if", "in", "instanceof", "local",
+	"null", "resume", "return", "static", "switch", "this", "throw", "true", "try", "typeof", "while", "yield",
+};
+
+// ASCII only, bytes of UTF-8 sequences are never letters or digits
+static inline bool IsDigit( char c ) { return c >= '0' && c <= '9'; }
+static inline bool IsAlpha( char c ) { return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ); }
+static inline bool IsAlnum( char c ) { return IsDigit( c ) || IsAlpha( c ); }
+static inline char ToLower( char c ) { return ( c >= 'A' && c <= 'Z' ) ? c + ( 'a' - 'A' ) : c; }
+
+CDearImGuiTextEditor::CDearImGuiTextEditor()
+{
+	SetText( "", 0 );
+}
+
+CDearImGuiTextEditor::~CDearImGuiTextEditor()
+{
+	ClearUndo();
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Loading and saving
+//---------------------------------------------------------------------------------------//
+bool CDearImGuiTextEditor::Load( const char *pszPath )
+{
+	ImFileHandle f = ImFileOpen( pszPath, "rb" );
+	if ( !f )
+		return false;
+
+	const int nSize = (int)ImFileGetSize( f );
+	CUtlVector<char> text;
+	text.SetCount( nSize );
+	const int nRead = nSize ? (int)ImFileRead( text.Base(), 1, nSize, f ) : 0;
+	ImFileClose( f );
+
+	SetText( text.Base(), nRead );
+	m_Path = pszPath;
+
+	const char *pszExtension = V_GetFileExtension( pszPath );
+	if ( !pszExtension )
+		m_eLanguage = LANGUAGE_PLAIN;
+	else if ( !V_stricmp( pszExtension, "cfg" ) )
+		m_eLanguage = LANGUAGE_CFG;
+	else if ( !V_stricmp( pszExtension, "nut" ) )
+		m_eLanguage = LANGUAGE_SQUIRREL;
+	else if ( !V_stricmp( pszExtension, "txt" ) || !V_stricmp( pszExtension, "res" ) || !V_stricmp( pszExtension, "vmt" ) ||
+			  !V_stricmp( pszExtension, "vdf" ) || !V_stricmp( pszExtension, "kv" ) )
+		m_eLanguage = LANGUAGE_KEYVALUES;
+	else
+		m_eLanguage = LANGUAGE_PLAIN;
+
+	return true;
+}
+
+bool CDearImGuiTextEditor::Save( const char *pszPath )
+{
+	if ( !pszPath )
+		pszPath = m_Path.Get();
+
+	if ( !pszPath || !pszPath[0] )
+		return false;
+
+	ImFileHandle f = ImFileOpen( pszPath, "wb" );
+	if ( !f )
+		return false;
+
+	bool bWritten = true;
+	FOR_EACH_VEC( m_Pieces, i )
+		bWritten &= ImFileWrite( GetPieceData( m_Pieces[i] ), 1, m_Pieces[i].nLength, f ) == (uint64)m_Pieces[i].nLength;
+	ImFileClose( f );
+
+	if ( bWritten )
+	{
+		m_Path = pszPath;
+		m_nSavedGeneration = m_nGeneration;
+	}
+	return bWritten;
+}
+
+void CDearImGuiTextEditor::SetText( const char *pszText, int nLength )
+{
+	ClearUndo();
+
+	m_Original.SetCount( nLength );
+	if ( nLength )
+		V_memcpy( m_Original.Base(), pszText, nLength );
+	m_Added.Purge();
+
+	m_Pieces.RemoveAll();
+	if ( nLength )
+	{
+		Piece_t &piece = m_Pieces[m_Pieces.AddToTail()];
+		piece.nStart = 0;
+		piece.nLength = nLength;
+		piece.bAdded = false;
+	}
+
+	UpdatePieceStarts();
+	RebuildLineIndex();
+
+	m_nGeneration = m_nSavedGeneration = ++m_nGenerationCounter;
+	m_nCursor = m_nAnchor = 0;
+	m_nLastTypedPos = -1;
+	m_flMaxWidth = 0.0f;
+}
+
+void CDearImGuiTextEditor::GetText( CUtlVector<char> &text ) const
+{
+	CopyText( 0, m_nLength, text );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Piece table
+//---------------------------------------------------------------------------------------//
+void CDearImGuiTextEditor::UpdatePieceStarts()
+{
+	m_PieceStarts.SetCount( m_Pieces.Count() );
+
+	int nPos = 0;
+	FOR_EACH_VEC( m_Pieces, i )
+	{
+		m_PieceStarts[i] = nPos;
+		nPos += m_Pieces[i].nLength;
+	}
+	m_nLength = nPos;
+}
+
+// Index of the piece containing nPos, or the piece count at the end of the text
+int CDearImGuiTextEditor::FindPiece( int nPos ) const
+{
+	int nLow = 0, nHigh = m_Pieces.Count();
+	while ( nLow < nHigh )
+	{
+		const int nMid = ( nLow + nHigh ) / 2;
+		if ( m_PieceStarts[nMid] + m_Pieces[nMid].nLength <= nPos )
+			nLow = nMid + 1;
+		else
+			nHigh = nMid;
+	}
+	return nLow;
+}
+
+// Makes sure a piece starts at nPos and returns it
+int CDearImGuiTextEditor::SplitPiece( int nPos )
+{
+	const int i = FindPiece( nPos );
+	if ( i == m_Pieces.Count() || m_PieceStarts[i] == nPos )
+		return i;
+
+	const int nOffset = nPos - m_PieceStarts[i];
+	Piece_t tail = m_Pieces[i];
+	tail.nStart += nOffset;
+	tail.nLength -= nOffset;
+	m_Pieces[i].nLength = nOffset;
+	m_Pieces.InsertAfter( i, tail );
+	UpdatePieceStarts();
+	return i + 1;
+}
+
+char CDearImGuiTextEditor::GetChar( int nPos ) const
+{
+	if ( nPos < 0 || nPos >= m_nLength )
+		return '\0';
+
+	const int i = FindPiece( nPos );
+	return GetPieceData( m_Pieces[i] )[nPos - m_PieceStarts[i]];
+}
+
+void CDearImGuiTextEditor::CopyText( int nPos, int nLength, CUtlVector<char> &out ) const
+{
+	out.RemoveAll();
+	nLength = MIN( nLength, m_nLength - nPos );
+	if ( nLength <= 0 )
+		return;
+
+	out.EnsureCapacity( nLength );
+	for ( int i = FindPiece( nPos ); i < m_Pieces.Count() && out.Count() < nLength; i++ )
+	{
+		const int nOffset = MAX( nPos - m_PieceStarts[i], 0 );
+		const int nCopy = MIN( m_Pieces[i].nLength - nOffset, nLength - out.Count() );
+		out.AddMultipleToTail( nCopy, GetPieceData( m_Pieces[i] ) + nOffset );
+	}
+}
+
+void CDearImGuiTextEditor::Insert( int nPos, const char *pszText, int nLength )
+{
+	nPos = clamp( nPos, 0, m_nLength );
+	if ( nLength <= 0 )
+		return;
+
+	const int nAddStart = m_Added.Count();
+	m_Added.AddMultipleToTail( nLength, pszText );
+
+	// Typing extends the piece it's typing into, instead of adding one per character
+	const int i = SplitPiece( nPos );
+	Piece_t *pPrev = i > 0 ? &m_Pieces[i - 1] : nullptr;
+	if ( pPrev && pPrev->bAdded && pPrev->nStart + pPrev->nLength == nAddStart )
+	{
+		pPrev->nLength += nLength;
+	}
+	else
+	{
+		Piece_t piece;
+		piece.nStart = nAddStart;
+		piece.nLength = nLength;
+		piece.bAdded = true;
+		m_Pieces.InsertBefore( i, piece );
+	}
+	UpdatePieceStarts();
+
+	// Lines after the insertion move, and every newline inserted starts one
+	int nLine = GetLineOf( nPos ) + 1;
+	for ( int l = nLine; l < m_LineStarts.Count(); l++ )
+		m_LineStarts[l] += nLength;
+
+	for ( int c = 0; c < nLength; c++ )
+	{
+		if ( pszText[c] == '\n' )
+			m_LineStarts.InsertBefore( nLine++, nPos + c + 1 );
+	}
+
+	m_nGeneration = ++m_nGenerationCounter;
+}
+
+void CDearImGuiTextEditor::Delete( int nPos, int nLength )
+{
+	nPos = clamp( nPos, 0, m_nLength );
+	nLength = MIN( nLength, m_nLength - nPos );
+	if ( nLength <= 0 )
+		return;
+
+	const int nFirst = SplitPiece( nPos );
+	const int nLast = SplitPiece( nPos + nLength );
+	m_Pieces.RemoveMultiple( nFirst, nLast - nFirst );
+	UpdatePieceStarts();
+
+	// Lines starting inside the deleted range are gone, the ones after it move
+	const int nLine = GetLineOf( nPos ) + 1;
+	int nRemove = 0;
+	while ( nLine + nRemove < m_LineStarts.Count() && m_LineStarts[nLine + nRemove] <= nPos + nLength )
+		nRemove++;
+	m_LineStarts.RemoveMultiple( nLine, nRemove );
+
+	for ( int l = nLine; l < m_LineStarts.Count(); l++ )
+		m_LineStarts[l] -= nLength;
+
+	m_nGeneration = ++m_nGenerationCounter;
+}
+
+void CDearImGuiTextEditor::RebuildLineIndex()
+{
+	m_LineStarts.RemoveAll();
+	m_LineStarts.AddToTail( 0 );
+
+	FOR_EACH_VEC( m_Pieces, i )
+	{
+		const char *pData = GetPieceData( m_Pieces[i] );
+		const char *pEnd = pData + m_Pieces[i].nLength;
+		for ( const char *p = pData; ( p = (const char *)memchr( p, '\n', pEnd - p ) ) != nullptr; p++ )
+			m_LineStarts.AddToTail( m_PieceStarts[i] + ( p - pData ) + 1 );
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Lines
+//---------------------------------------------------------------------------------------//
+int CDearImGuiTextEditor::GetLineOf( int nPos ) const
+{
+	int nLow = 0, nHigh = m_LineStarts.Count() - 1;
+	while ( nLow < nHigh )
+	{
+		const int nMid = ( nLow + nHigh + 1 ) / 2;
+		if ( m_LineStarts[nMid] <= nPos )
+			nLow = nMid;
+		else
+			nHigh = nMid - 1;
+	}
+	return nLow;
+}
+
+// End of the line's text, before the newline and any carriage return
+int CDearImGuiTextEditor::GetLineEnd( int nLine ) const
+{
+	int nEnd = nLine + 1 < m_LineStarts.Count() ? m_LineStarts[nLine + 1] - 1 : m_nLength;
+	if ( nEnd > m_LineStarts[nLine] && GetChar( nEnd - 1 ) == '\r' )
+		nEnd--;
+	return nEnd;
+}
+
+void CDearImGuiTextEditor::GetLine( int nLine, CUtlVector<char> &out ) const
+{
+	CopyText( GetLineStart( nLine ), GetLineEnd( nLine ) - GetLineStart( nLine ), out );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Search. Each piece is searched in place, with the tail of the previous ones
+//  carried over for matches across pieces.
+//---------------------------------------------------------------------------------------//
+static int FindInBlock( const char *pData, int nLength, const char *pszText, int nTextLength )
+{
+	const char cFirst = ToLower( pszText[0] );
+	for ( int i = 0; i + nTextLength <= nLength; i++ )
+	{
+		if ( ToLower( pData[i] ) == cFirst && !V_strnicmp( pData + i, pszText, nTextLength ) )
+			return i;
+	}
+	return -1;
+}
+
+int CDearImGuiTextEditor::FindForward( const char *pszText, int nTextLength, int nFrom ) const
+{
+	char carry[256];
+	int nCarry = 0;
+	int nCarryPos = nFrom;
+
+	for ( int i = FindPiece( nFrom ); i < m_Pieces.Count(); i++ )
+	{
+		const int nSkip = MAX( nFrom - m_PieceStarts[i], 0 );
+		const char *pData = GetPieceData( m_Pieces[i] ) + nSkip;
+		const int nLength = m_Pieces[i].nLength - nSkip;
+
+		// Matches starting in the carried tail and ending in this piece
+		if ( nCarry )
+		{
+			const int nHead = MIN( nLength, nTextLength - 1 );
+			V_memcpy( carry + nCarry, pData, nHead );
+			const int nFound = FindInBlock( carry, nCarry + nHead, pszText, nTextLength );
+			if ( nFound >= 0 && nFound < nCarry )
+				return nCarryPos + nFound;
+		}
+
+		const int nFound = FindInBlock( pData, nLength, pszText, nTextLength );
+		if ( nFound >= 0 )
+			return m_PieceStarts[i] + nSkip + nFound;
+
+		// Keep the last nTextLength - 1 bytes seen, which may span several short pieces
+		const int nKeep = nTextLength - 1;
+		if ( nLength >= nKeep )
+		{
+			V_memcpy( carry, pData + nLength - nKeep, nKeep );
+			nCarry = nKeep;
+		}
+		else
+		{
+			const int nOld = MIN( nCarry, nKeep - nLength );
+			V_memmove( carry, carry + nCarry - nOld, nOld );
+			V_memcpy( carry + nOld, pData, nLength );
+			nCarry = nOld + nLength;
+		}
+		nCarryPos = m_PieceStarts[i] + nSkip + nLength - nCarry;
+	}
+
+	return -1;
+}
+
+int CDearImGuiTextEditor::Find( const char *pszText, int nFrom, bool bForward ) const
+{
+	const int nTextLength = V_strlen( pszText );
+	if ( !nTextLength || nTextLength >= 128 )
+		return -1;
+
+	if ( bForward )
+		return FindForward( pszText, nTextLength, clamp( nFrom, 0, m_nLength ) );
+
+	// Last match starting before nFrom
+	int nLast = -1;
+	for ( int nFound = FindForward( pszText, nTextLength, 0 ); nFound >= 0 && nFound < nFrom; nFound = FindForward( pszText, nTextLength, nFound + 1 ) )
+		nLast = nFound;
+	return nLast;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Undo keeps copies of the piece list, the buffers they point into never change.
+//  Characters typed one after another are undone together.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiTextEditor::PushUndo( bool bTyping )
+{
+	if ( bTyping && m_nCursor == m_nLastTypedPos && !HasSelection() )
+		return;
+
+	UndoState_t *pState = new UndoState_t;
+	pState->pieces = m_Pieces;
+	pState->nCursor = m_nCursor;
+	pState->nAnchor = m_nAnchor;
+	pState->nGeneration = m_nGeneration;
+	m_Undo.AddToTail( pState );
+
+	if ( m_Undo.Count() > TEXTEDITOR_MAX_UNDO )
+	{
+		delete m_Undo[0];
+		m_Undo.Remove( 0 );
+	}
+
+	m_Redo.PurgeAndDeleteElements();
+}
+
+void CDearImGuiTextEditor::ApplyUndo( CUtlVector<UndoState_t *> &from, CUtlVector<UndoState_t *> &to )
+{
+	if ( !from.Count() )
+		return;
+
+	UndoState_t *pCurrent = new UndoState_t;
+	pCurrent->pieces = m_Pieces;
+	pCurrent->nCursor = m_nCursor;
+	pCurrent->nAnchor = m_nAnchor;
+	pCurrent->nGeneration = m_nGeneration;
+	to.AddToTail( pCurrent );
+
+	UndoState_t *pState = from.Tail();
+	from.RemoveMultipleFromTail( 1 );
+
+	m_Pieces = pState->pieces;
+	m_nCursor = pState->nCursor;
+	m_nAnchor = pState->nAnchor;
+	m_nGeneration = pState->nGeneration;
+	delete pState;
+
+	UpdatePieceStarts();
+	RebuildLineIndex();
+	m_nLastTypedPos = -1;
+	m_bScrollToCursor = true;
+}
+
+void CDearImGuiTextEditor::ClearUndo()
+{
+	m_Undo.PurgeAndDeleteElements();
+	m_Redo.PurgeAndDeleteElements();
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Editing at the cursor
+//---------------------------------------------------------------------------------------//
+void CDearImGuiTextEditor::DeleteSelection()
+{
+	const int nStart = MIN( m_nCursor, m_nAnchor );
+	Delete( nStart, abs( m_nCursor - m_nAnchor ) );
+	m_nCursor = m_nAnchor = nStart;
+}
+
+void CDearImGuiTextEditor::InsertAtCursor( const char *pszText, int nLength, bool bTyping )
+{
+	if ( m_bReadOnly )
+		return;
+
+	PushUndo( bTyping );
+	if ( HasSelection() )
+		DeleteSelection();
+
+	Insert( m_nCursor, pszText, nLength );
+	m_nCursor = m_nAnchor = m_nCursor + nLength;
+	m_nLastTypedPos = bTyping ? m_nCursor : -1;
+	m_flPreferredX = -1.0f;
+	m_bScrollToCursor = true;
+}
+
+void CDearImGuiTextEditor::MoveCursor( int nPos, bool bSelect )
+{
+	m_nCursor = clamp( nPos, 0, m_nLength );
+	if ( !bSelect )
+		m_nAnchor = m_nCursor;
+	m_nLastTypedPos = -1;
+	m_flPreferredX = -1.0f;
+	m_bScrollToCursor = true;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Layout of a line, in pixels from its start
+//---------------------------------------------------------------------------------------//
+float CDearImGuiTextEditor::GetAdvance( unsigned int c, float flX ) const
+{
+	ImFont *pFont = ImGui::GetFont();
+	const float flScale = ImGui::GetFontSize() / pFont->FontSize;
+	if ( c == '\t' )
+	{
+		const float flTab = pFont->GetCharAdvance( ' ' ) * flScale * TEXTEDITOR_TAB_SIZE;
+		return ( floorf( flX / flTab ) + 1.0f ) * flTab - flX;
+	}
+	return pFont->GetCharAdvance( (ImWchar)c ) * flScale;
+}
+
+float CDearImGuiTextEditor::MeasureColumn( const char *pszLine, int nLength, int nColumn ) const
+{
+	float flX = 0.0f;
+	const char *pEnd = pszLine + MIN( nLength, nColumn );
+	for ( const char *p = pszLine; p < pEnd; )
+	{
+		unsigned int c;
+		p += ImTextCharFromUtf8( &c, p, pEnd );
+		flX += GetAdvance( c, flX );
+	}
+	return flX;
+}
+
+int CDearImGuiTextEditor::FindColumn( const char *pszLine, int nLength, float flTarget ) const
+{
+	float flX = 0.0f;
+	const char *pEnd = pszLine + nLength;
+	for ( const char *p = pszLine; p < pEnd; )
+	{
+		unsigned int c;
+		const int nBytes = ImTextCharFromUtf8( &c, p, pEnd );
+		const float flAdvance = GetAdvance( c, flX );
+		if ( flTarget < flX + flAdvance * 0.5f )
+			return p - pszLine;
+
+		flX += flAdvance;
+		p += nBytes;
+	}
+	return nLength;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Colors each byte of a line. Strings and // comments for everything, then
+//  what tells each language apart. Block comments are only recognised within a line.
+//---------------------------------------------------------------------------------------//
+void CDearImGuiTextEditor::ColorLine( const char *pszLine, int nLength )
+{
+	m_Colors.SetCount( nLength );
+	if ( !nLength )
+		return;
+	V_memset( m_Colors.Base(), TEXTCOLOR_DEFAULT, nLength );
+
+	if ( m_eLanguage == LANGUAGE_PLAIN )
+		return;
+
+	bool bCommandStart = true;
+	for ( int i = 0; i < nLength; )
+	{
+		const char c = pszLine[i];
+
+		if ( ( c == '/' && i + 1 < nLength && pszLine[i + 1] == '/' ) || ( c == '#' && m_eLanguage == LANGUAGE_SQUIRREL ) )
+		{
+			V_memset( m_Colors.Base() + i, TEXTCOLOR_COMMENT, nLength - i );
+			return;
+		}
+
+		if ( c == '/' && i + 1 < nLength && pszLine[i + 1] == '*' && m_eLanguage == LANGUAGE_SQUIRREL )
+		{
+			int nEnd = i + 2;
+			while ( nEnd + 1 < nLength && !( pszLine[nEnd] == '*' && pszLine[nEnd + 1] == '/' ) )
+				nEnd++;
+			nEnd = MIN( nEnd + 2, nLength );
+			V_memset( m_Colors.Base() + i, TEXTCOLOR_COMMENT, nEnd - i );
+			i = nEnd;
+			continue;
+		}
+
+		if ( c == '"' || ( c == '\'' && m_eLanguage == LANGUAGE_SQUIRREL ) )
+		{
+			int nEnd = i + 1;
+			while ( nEnd < nLength && pszLine[nEnd] != c )
+				nEnd += ( pszLine[nEnd] == '\\' && m_eLanguage != LANGUAGE_CFG ) ? 2 : 1;
+			nEnd = MIN( nEnd + 1, nLength );
+
+			// The key of a KeyValues pair, or a quoted command in a cfg
+			const bool bKey = ( m_eLanguage == LANGUAGE_KEYVALUES || m_eLanguage == LANGUAGE_CFG ) && bCommandStart;
+			V_memset( m_Colors.Base() + i, bKey ? TEXTCOLOR_KEYWORD : TEXTCOLOR_STRING, nEnd - i );
+			bCommandStart = false;
+			i = nEnd;
+			continue;
+		}
+
+		if ( IsDigit( c ) || ( ( c == '-' || c == '.' ) && i + 1 < nLength && IsDigit( pszLine[i + 1] ) ) )
+		{
+			const bool bWordStart = i == 0 || !( IsAlnum( pszLine[i - 1] ) || pszLine[i - 1] == '_' );
+			int nEnd = i + 1;
+			while ( nEnd < nLength && ( IsAlnum( pszLine[nEnd] ) || pszLine[nEnd] == '.' ) )
+				nEnd++;
+			if ( bWordStart )
+				V_memset( m_Colors.Base() + i, TEXTCOLOR_NUMBER, nEnd - i );
+			bCommandStart = false;
+			i = nEnd;
+			continue;
+		}
+
+		if ( IsAlpha( c ) || c == '_' || c == '+' || c == '-' || c == '$' )
+		{
+			int nEnd = i + 1;
+			while ( nEnd < nLength && ( IsAlnum( pszLine[nEnd] ) || pszLine[nEnd] == '_' || pszLine[nEnd] == '.' ) )
+				nEnd++;
+
+			bool bKeyword = false;
+			if ( m_eLanguage == LANGUAGE_SQUIRREL )
+			{
+				for ( int k = 0; k < ARRAYSIZE( s_SquirrelKeywords ) && !bKeyword; k++ )
+					bKeyword = (int)V_strlen( s_SquirrelKeywords[k] ) == nEnd - i && !V_strncmp( s_SquirrelKeywords[k], pszLine + i, nEnd - i );
+			}
+			else
+			{
+				// Commands and KeyValues keys, with or without quotes
+				bKeyword = bCommandStart;
+			}
+
+			if ( bKeyword )
+				V_memset( m_Colors.Base() + i, TEXTCOLOR_KEYWORD, nEnd - i );
+			bCommandStart = false;
+			i = nEnd;
+			continue;
+		}
+
+		if ( c == '{' || c == '}' || c == '[' || c == ']' || c == '(' || c == ')' || c == ';' || c == ',' )
+		{
+			m_Colors[i] = TEXTCOLOR_PUNCTUATION;
+
+			// A cfg line holds several commands separated by semicolons
+			if ( c == ';' && m_eLanguage == LANGUAGE_CFG )
+				bCommandStart = true;
+
+			// KeyValues conditionals, [$WIN32]
+			if ( c == '[' && m_eLanguage == LANGUAGE_KEYVALUES )
+			{
+				int nEnd = i + 1;
+				while ( nEnd < nLength && pszLine[nEnd] != ']' )
+					nEnd++;
+				V_memset( m_Colors.Base() + i, TEXTCOLOR_KEYWORD, MIN( nEnd + 1, nLength ) - i );
+				i = nEnd + 1;
+				continue;
+			}
+		}
+
+		i++;
+	}
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Keyboard input while the text has focus
+//---------------------------------------------------------------------------------------//
+static bool IsWordChar( char c )
+{
+	return IsAlnum( c ) || c == '_' || (unsigned char)c >= 0x80;
+}
+
+void CDearImGuiTextEditor::HandleKeyboard( int nPageLines )
+{
+	ImGuiIO &io = ImGui::GetIO();
+	const bool bShift = io.KeyShift;
+	const bool bCtrl = io.KeyCtrl;
+
+	const int nLine = GetLineOf( m_nCursor );
+	const int nLineStart = GetLineStart( nLine );
+
+	auto MoveToLine = [&]( int nTarget )
+	{
+		nTarget = clamp( nTarget, 0, GetLineCount() - 1 );
+		GetLine( nLine, m_Line );
+		if ( m_flPreferredX < 0.0f )
+			m_flPreferredX = MeasureColumn( m_Line.Base(), m_Line.Count(), m_nCursor - nLineStart );
+
+		const float flPreferredX = m_flPreferredX;
+		GetLine( nTarget, m_Line );
+		MoveCursor( GetLineStart( nTarget ) + FindColumn( m_Line.Base(), m_Line.Count(), flPreferredX ), bShift );
+		m_flPreferredX = flPreferredX;
+	};
+
+	if ( ImGui::IsKeyPressed( ImGuiKey_UpArrow ) )
+		MoveToLine( nLine - 1 );
+	else if ( ImGui::IsKeyPressed( ImGuiKey_DownArrow ) )
+		MoveToLine( nLine + 1 );
+	else if ( ImGui::IsKeyPressed( ImGuiKey_PageUp ) )
+		MoveToLine( nLine - nPageLines );
+	else if ( ImGui::IsKeyPressed( ImGuiKey_PageDown ) )
+		MoveToLine( nLine + nPageLines );
+
+	if ( ImGui::IsKeyPressed( ImGuiKey_LeftArrow ) )
+	{
+		int nPos = m_nCursor;
+		if ( HasSelection() && !bShift )
+			nPos = MIN( m_nCursor, m_nAnchor );
+		else if ( bCtrl )
+		{
+			while ( nPos > 0 && !IsWordChar( GetChar( nPos - 1 ) ) )
+				nPos--;
+			while ( nPos > 0 && IsWordChar( GetChar( nPos - 1 ) ) )
+				nPos--;
+		}
+		else if ( nPos > 0 )
+		{
+			nPos--;
+			while ( nPos > 0 && ( GetChar( nPos ) & 0xC0 ) == 0x80 )
+				nPos--;
+			if ( nPos > 0 && GetChar( nPos ) == '\n' && GetChar( nPos - 1 ) == '\r' )
+				nPos--;
+		}
+		MoveCursor( nPos, bShift );
+	}
+
+	if ( ImGui::IsKeyPressed( ImGuiKey_RightArrow ) )
+	{
+		int nPos = m_nCursor;
+		if ( HasSelection() && !bShift )
+			nPos = MAX( m_nCursor, m_nAnchor );
+		else if ( bCtrl )
+		{
+			while ( nPos < m_nLength && !IsWordChar( GetChar( nPos ) ) )
+				nPos++;
+			while ( nPos < m_nLength && IsWordChar( GetChar( nPos ) ) )
+				nPos++;
+		}
+		else if ( nPos < m_nLength )
+		{
+			if ( GetChar( nPos ) == '\r' && GetChar( nPos + 1 ) == '\n' )
+				nPos++;
+			nPos++;
+			while ( nPos < m_nLength && ( GetChar( nPos ) & 0xC0 ) == 0x80 )
+				nPos++;
+		}
+		MoveCursor( nPos, bShift );
+	}
+
+	if ( ImGui::IsKeyPressed( ImGuiKey_Home ) )
+		MoveCursor( bCtrl ? 0 : nLineStart, bShift );
+	if ( ImGui::IsKeyPressed( ImGuiKey_End ) )
+		MoveCursor( bCtrl ? m_nLength : GetLineEnd( nLine ), bShift );
+
+	if ( bCtrl && ImGui::IsKeyPressed( ImGuiKey_A, false ) )
+	{
+		m_nAnchor = 0;
+		m_nCursor = m_nLength;
+	}
+
+	if ( bCtrl && ( ImGui::IsKeyPressed( ImGuiKey_C, false ) || ImGui::IsKeyPressed( ImGuiKey_X, false ) ) && HasSelection() )
+	{
+		CUtlVector<char> text;
+		CopyText( MIN( m_nCursor, m_nAnchor ), abs( m_nCursor - m_nAnchor ), text );
+		text.AddToTail( '\0' );
+		ImGui::SetClipboardText( text.Base() );
+
+		if ( ImGui::IsKeyPressed( ImGuiKey_X, false ) && !m_bReadOnly )
+		{
+			PushUndo( false );
+			DeleteSelection();
+			m_bScrollToCursor = true;
+		}
+	}
+
+	if ( bCtrl && ImGui::IsKeyPressed( ImGuiKey_F, false ) )
+	{
+		m_bSearchOpen = true;
+		m_bFocusSearch = true;
+		m_nSearchOrigin = MIN( m_nCursor, m_nAnchor );
+	}
+
+	if ( ImGui::IsKeyPressed( ImGuiKey_F3 ) && m_szSearch[0] )
+		Search( !bShift, true );
+
+	if ( m_bReadOnly )
+		return;
+
+	if ( bCtrl && ImGui::IsKeyPressed( ImGuiKey_V ) )
+	{
+		if ( const char *pszClipboard = ImGui::GetClipboardText() )
+			InsertAtCursor( pszClipboard, V_strlen( pszClipboard ), false );
+	}
+
+	if ( bCtrl && ImGui::IsKeyPressed( ImGuiKey_Z ) )
+		ApplyUndo( m_Undo, m_Redo );
+	if ( bCtrl && ImGui::IsKeyPressed( ImGuiKey_Y ) )
+		ApplyUndo( m_Redo, m_Undo );
+
+	if ( ImGui::IsKeyPressed( ImGuiKey_Backspace ) || ImGui::IsKeyPressed( ImGuiKey_Delete ) )
+	{
+		PushUndo( false );
+		if ( !HasSelection() )
+		{
+			// Select the character being deleted, whole UTF-8 sequences and CRLFs
+			int nPos = m_nCursor;
+			if ( ImGui::IsKeyPressed( ImGuiKey_Backspace ) )
+			{
+				if ( nPos > 0 )
+					nPos--;
+				while ( nPos > 0 && ( GetChar( nPos ) & 0xC0 ) == 0x80 )
+					nPos--;
+				if ( nPos > 0 && GetChar( nPos ) == '\n' && GetChar( nPos - 1 ) == '\r' )
+					nPos--;
+			}
+			else if ( nPos < m_nLength )
+			{
+				if ( GetChar( nPos ) == '\r' && GetChar( nPos + 1 ) == '\n' )
+					nPos++;
+				nPos++;
+				while ( nPos < m_nLength && ( GetChar( nPos ) & 0xC0 ) == 0x80 )
+					nPos++;
+			}
+			m_nAnchor = nPos;
+		}
+		DeleteSelection();
+		m_bScrollToCursor = true;
+	}
+
+	if ( ImGui::IsKeyPressed( ImGuiKey_Enter ) || ImGui::IsKeyPressed( ImGuiKey_KeypadEnter ) )
+	{
+		// Keep the indentation of the line
+		char szIndent[128];
+		int nIndent = 0;
+		szIndent[nIndent++] = '\n';
+		for ( int nPos = nLineStart; nPos < m_nCursor && nIndent < (int)sizeof( szIndent ); nPos++ )
+		{
+			const char c = GetChar( nPos );
+			if ( c != ' ' && c != '\t' )
+				break;
+			szIndent[nIndent++] = c;
+		}
+		InsertAtCursor( szIndent, nIndent, false );
+	}
+
+	if ( ImGui::IsKeyPressed( ImGuiKey_Tab ) )
+		InsertAtCursor( "\t", 1, true );
+
+	// Typed characters, shortcuts are handled above
+	if ( bCtrl && !io.KeyAlt )
+	{
+		io.InputQueueCharacters.resize( 0 );
+		return;
+	}
+
+	for ( int i = 0; i < io.InputQueueCharacters.Size; i++ )
+	{
+		const ImWchar c = io.InputQueueCharacters[i];
+		if ( c < ' ' || c == 127 )
+			continue;
+
+		char szUtf8[5];
+		ImTextCharToUtf8( szUtf8, c );
+		InsertAtCursor( szUtf8, V_strlen( szUtf8 ), true );
+	}
+	io.InputQueueCharacters.resize( 0 );
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Incremental search, moves to the first match from where the search started
+//  while typing
+//---------------------------------------------------------------------------------------//
+void CDearImGuiTextEditor::Search( bool bForward, bool bNext )
+{
+	int nFrom = m_nSearchOrigin;
+	if ( bNext )
+		nFrom = bForward ? MAX( m_nCursor, m_nAnchor ) : MIN( m_nCursor, m_nAnchor );
+
+	int nFound = Find( m_szSearch, nFrom, bForward );
+	if ( nFound < 0 )
+		nFound = Find( m_szSearch, bForward ? 0 : m_nLength, bForward );
+
+	if ( nFound < 0 )
+		return;
+
+	m_nAnchor = nFound;
+	m_nCursor = nFound + V_strlen( m_szSearch );
+	m_nLastTypedPos = -1;
+	m_bScrollToCursor = true;
+}
+
+void CDearImGuiTextEditor::DrawSearchBar()
+{
+	if ( m_bFocusSearch )
+	{
+		ImGui::SetKeyboardFocusHere();
+		m_bFocusSearch = false;
+	}
+
+	ImGui::SetNextItemWidth( ImGui::GetFontSize() * 16.0f );
+	if ( ImGui::InputTextWithHint( "##search", "Find", m_szSearch, sizeof( m_szSearch ) ) )
+		Search( true, false );
+
+	if ( ImGui::IsItemDeactivated() && ImGui::IsKeyPressed( ImGuiKey_Enter ) )
+	{
+		Search( !ImGui::GetIO().KeyShift, true );
+		m_bFocusSearch = true;
+	}
+
+	if ( ImGui::IsItemDeactivated() && ImGui::IsKeyPressed( ImGuiKey_Escape ) )
+	{
+		m_bSearchOpen = false;
+		m_bFocusText = true;
+	}
+
+	ImGui::SameLine();
+	if ( ImGui::ArrowButton( "##prev", ImGuiDir_Up ) )
+		Search( false, true );
+	ImGui::SameLine();
+	if ( ImGui::ArrowButton( "##next", ImGuiDir_Down ) )
+		Search( true, true );
+	ImGui::SameLine();
+	if ( ImGui::SmallButton( "x" ) )
+		m_bSearchOpen = false;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Draw the editor. Only the lines inside the clip rect are fetched from the
+//  piece table, colored and drawn, the rest of the content is one Dummy for the
+//  scrollbars.
+//---------------------------------------------------------------------------------------//
+bool CDearImGuiTextEditor::Render( const char *pszLabel, const ImVec2 &size )
+{
+	VPROF_BUDGET( "CDearImGuiTextEditor::Render", VPROF_BUDGETGROUP_IMGUI );
+
+	ImGui::PushID( pszLabel );
+	const int nGeneration = m_nGeneration;
+
+	if ( m_bSearchOpen )
+		DrawSearchBar();
+
+	if ( m_bFocusText )
+	{
+		ImGui::SetNextWindowFocus();
+		m_bFocusText = false;
+	}
+
+	ImGui::PushStyleColor( ImGuiCol_ChildBg, ImGui::GetStyleColorVec4( ImGuiCol_FrameBg ) );
+	const bool bVisible = ImGui::BeginChild( "##text", size, ImGuiChildFlags_Borders, ImGuiWindowFlags_HorizontalScrollbar | ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoMove );
+	ImGui::PopStyleColor();
+
+	if ( !bVisible )
+	{
+		ImGui::EndChild();
+		ImGui::PopID();
+		return false;
+	}
+
+	ImDrawList *pDrawList = ImGui::GetWindowDrawList();
+	ImFont *pFont = ImGui::GetFont();
+	const float flFontSize = ImGui::GetFontSize();
+	const float flLineHeight = ImGui::GetTextLineHeight();
+	const ImVec2 vecOrigin = ImGui::GetCursorScreenPos();
+	const ImVec2 vecClipMin = pDrawList->GetClipRectMin();
+	const ImVec2 vecClipMax = pDrawList->GetClipRectMax();
+	const int nPageLines = MAX( (int)( ( vecClipMax.y - vecClipMin.y ) / flLineHeight ) - 1, 1 );
+
+	char szLineNumber[16];
+	V_snprintf( szLineNumber, sizeof( szLineNumber ), "%d", GetLineCount() );
+	const float flGutter = ImGui::CalcTextSize( szLineNumber ).x + ImGui::GetStyle().ItemSpacing.x * 2.0f;
+	const float flTextX = vecOrigin.x + flGutter;
+
+	// Mouse, click places the cursor and dragging selects
+	ImGuiIO &io = ImGui::GetIO();
+	if ( ImGui::IsWindowHovered() && ImGui::IsMouseClicked( ImGuiMouseButton_Left ) && io.MousePos.x < vecClipMax.x - ImGui::GetStyle().ScrollbarSize )
+		m_bSelecting = true;
+	if ( !ImGui::IsMouseDown( ImGuiMouseButton_Left ) )
+		m_bSelecting = false;
+
+	if ( m_bSelecting )
+	{
+		const int nLine = clamp( (int)( ( io.MousePos.y - vecOrigin.y ) / flLineHeight ), 0, GetLineCount() - 1 );
+		GetLine( nLine, m_Line );
+		const int nPos = GetLineStart( nLine ) + FindColumn( m_Line.Base(), m_Line.Count(), io.MousePos.x - flTextX );
+		MoveCursor( nPos, !ImGui::IsMouseClicked( ImGuiMouseButton_Left ) || io.KeyShift );
+
+		// Keep scrolling while dragging past the edges
+		m_bScrollToCursor = !ImGui::IsMouseClicked( ImGuiMouseButton_Left );
+	}
+
+	if ( ImGui::IsWindowFocused() )
+	{
+		ImGui::SetNextFrameWantCaptureKeyboard( true );
+		HandleKeyboard( nPageLines );
+	}
+
+	// Visible lines
+	const int nFirstLine = clamp( (int)( ( vecClipMin.y - vecOrigin.y ) / flLineHeight ), 0, GetLineCount() - 1 );
+	const int nLastLine = clamp( (int)( ( vecClipMax.y - vecOrigin.y ) / flLineHeight ) + 1, 0, GetLineCount() );
+
+	const int nSelStart = MIN( m_nCursor, m_nAnchor );
+	const int nSelEnd = MAX( m_nCursor, m_nAnchor );
+	const int nSearchLength = m_bSearchOpen ? V_strlen( m_szSearch ) : 0;
+	const ImU32 selectionCol = ImGui::GetColorU32( ImGuiCol_TextSelectedBg );
+	const ImU32 matchCol = ImGui::GetColorU32( ImGuiCol_PlotHistogram, 0.35f );
+	const ImU32 lineNumberCol = ImGui::GetColorU32( ImGuiCol_TextDisabled );
+
+	for ( int nLine = nFirstLine; nLine < nLastLine; nLine++ )
+	{
+		const int nStart = GetLineStart( nLine );
+		GetLine( nLine, m_Line );
+		const char *pszLine = m_Line.Base();
+		const int nLength = m_Line.Count();
+		const float y = vecOrigin.y + nLine * flLineHeight;
+
+		V_snprintf( szLineNumber, sizeof( szLineNumber ), "%d", nLine + 1 );
+		pDrawList->AddText( ImVec2( vecOrigin.x + flGutter - ImGui::GetStyle().ItemSpacing.x - ImGui::CalcTextSize( szLineNumber ).x, y ), lineNumberCol, szLineNumber );
+
+		// Search matches on this line
+		for ( int nMatch = nSearchLength ? FindInBlock( pszLine, nLength, m_szSearch, nSearchLength ) : -1; nMatch >= 0; )
+		{
+			const float x0 = flTextX + MeasureColumn( pszLine, nLength, nMatch );
+			const float x1 = flTextX + MeasureColumn( pszLine, nLength, nMatch + nSearchLength );
+			pDrawList->AddRectFilled( ImVec2( x0, y ), ImVec2( x1, y + flLineHeight ), matchCol );
+
+			const int nNext = FindInBlock( pszLine + nMatch + 1, nLength - nMatch - 1, m_szSearch, nSearchLength );
+			nMatch = nNext >= 0 ? nMatch + 1 + nNext : -1;
+		}
+
+		// Selection, including the newline when it carries on past the line
+		const int nLineEnd = nStart + nLength;
+		if ( nSelStart < nSelEnd && nSelStart <= nLineEnd && nSelEnd >= nStart )
+		{
+			const float x0 = flTextX + MeasureColumn( pszLine, nLength, MAX( nSelStart - nStart, 0 ) );
+			float x1 = flTextX + MeasureColumn( pszLine, nLength, MIN( nSelEnd, nLineEnd ) - nStart );
+			if ( nSelEnd > nLineEnd )
+				x1 += pFont->GetCharAdvance( ' ' ) * ( flFontSize / pFont->FontSize );
+			pDrawList->AddRectFilled( ImVec2( x0, y ), ImVec2( x1, y + flLineHeight ), selectionCol );
+		}
+
+		// Text, in runs of one color broken at tabs
+		g_ImGuiGlyphCache.Request( pszLine, pszLine + nLength );
+		ColorLine( pszLine, nLength );
+		float x = 0.0f;
+		for ( int nRun = 0; nRun < nLength; )
+		{
+			if ( pszLine[nRun] == '\t' )
+			{
+				x += GetAdvance( '\t', x );
+				nRun++;
+				continue;
+			}
+
+			int nRunEnd = nRun + 1;
+			while ( nRunEnd < nLength && m_Colors[nRunEnd] == m_Colors[nRun] && pszLine[nRunEnd] != '\t' )
+				nRunEnd++;
+
+			// Runs entirely right of the clip rect don't need drawing
+			if ( flTextX + x > vecClipMax.x )
+				break;
+
+			pDrawList->AddText( pFont, flFontSize, ImVec2( flTextX + x, y ), s_TextColors[m_Colors[nRun]], pszLine + nRun, pszLine + nRunEnd );
+			x += MeasureColumn( pszLine + nRun, nRunEnd - nRun, nRunEnd - nRun );
+			nRun = nRunEnd;
+		}
+		m_flMaxWidth = MAX( m_flMaxWidth, MeasureColumn( pszLine, nLength, nLength ) );
+
+		if ( m_nCursor >= nStart && m_nCursor <= nLineEnd && GetLineOf( m_nCursor ) == nLine && ImGui::IsWindowFocused() )
+		{
+			const float flCursorX = flTextX + MeasureColumn( pszLine, nLength, m_nCursor - nStart );
+			pDrawList->AddLine( ImVec2( flCursorX, y ), ImVec2( flCursorX, y + flLineHeight ), s_TextColors[TEXTCOLOR_DEFAULT] );
+		}
+	}
+
+	if ( m_bScrollToCursor )
+	{
+		const int nLine = GetLineOf( m_nCursor );
+		const float flCursorY = nLine * flLineHeight;
+		const float flViewHeight = vecClipMax.y - vecClipMin.y;
+		if ( flCursorY < ImGui::GetScrollY() )
+			ImGui::SetScrollY( flCursorY );
+		else if ( flCursorY + flLineHeight > ImGui::GetScrollY() + flViewHeight )
+			ImGui::SetScrollY( flCursorY + flLineHeight - flViewHeight );
+
+		GetLine( nLine, m_Line );
+		const float flCursorX = flGutter + MeasureColumn( m_Line.Base(), m_Line.Count(), m_nCursor - GetLineStart( nLine ) );
+		const float flViewWidth = vecClipMax.x - vecClipMin.x;
+		if ( flCursorX < ImGui::GetScrollX() + flGutter )
+			ImGui::SetScrollX( MAX( flCursorX - flGutter, 0.0f ) );
+		else if ( flCursorX > ImGui::GetScrollX() + flViewWidth - flFontSize )
+			ImGui::SetScrollX( flCursorX - flViewWidth + flFontSize );
+
+		m_bScrollToCursor = false;
+	}
+
+	ImGui::Dummy( ImVec2( flGutter + m_flMaxWidth + flFontSize, GetLineCount() * flLineHeight ) );
+	ImGui::EndChild();
+	ImGui::PopID();
+
+	return m_nGeneration != nGeneration;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Editor window, opened with imgui_edit
+//---------------------------------------------------------------------------------------//
+class CDearImGuiTextEditorWindow : public IImguiWindow
+{
+public:
+	CDearImGuiTextEditorWindow() : IImguiWindow( "editor", "Text Editor" ) {}
+
+	ImGuiWindowFlags GetFlags() const override { return ImGuiWindowFlags_MenuBar; }
+
+	void Open( const char *pszPath )
+	{
+		SetDraw( true );
+
+		// Loading replaces the buffer, so unsaved edits need confirming first
+		if ( m_Editor.IsModified() )
+		{
+			V_strncpy( m_szPendingPath, pszPath, sizeof( m_szPendingPath ) );
+			m_bConfirmDiscard = true;
+			return;
+		}
+
+		Load( pszPath );
+	}
+
+	bool Draw() override
+	{
+		if ( ImGui::BeginMenuBar() )
+		{
+			ImGui::SetNextItemWidth( ImGui::GetFontSize() * 20.0f );
+			const bool bOpen = ImGui::InputTextWithHint( "##path", "Path", m_szPath, sizeof( m_szPath ), ImGuiInputTextFlags_EnterReturnsTrue );
+			if ( ImGui::MenuItem( "Open" ) || bOpen )
+			{
+				char szPath[MAX_PATH];
+				V_strncpy( szPath, m_szPath, sizeof( szPath ) );
+				Open( szPath );
+			}
+
+			if ( ImGui::MenuItem( "Save", nullptr, false, m_szPath[0] != '\0' ) )
+			{
+				if ( !m_Editor.Save( m_szPath ) )
+					Warning( "Couldn't save %s\n", m_szPath );
+			}
+
+			ImGui::TextDisabled( "%s%d lines, %d KB", m_Editor.IsModified() ? "* " : "", m_Editor.GetLineCount(), m_Editor.GetLength() / 1024 );
+			ImGui::EndMenuBar();
+		}
+
+		if ( m_bConfirmDiscard )
+		{
+			ImGui::OpenPopup( "Discard changes?" );
+			m_bConfirmDiscard = false;
+		}
+
+		if ( ImGui::BeginPopupModal( "Discard changes?", nullptr, ImGuiWindowFlags_AlwaysAutoResize ) )
+		{
+			ImGui::Text( "Opening %s will discard unsaved changes.", m_szPendingPath );
+			if ( ImGui::Button( "Discard" ) )
+			{
+				Load( m_szPendingPath );
+				ImGui::CloseCurrentPopup();
+			}
+			ImGui::SameLine();
+			if ( ImGui::Button( "Cancel" ) )
+				ImGui::CloseCurrentPopup();
+			ImGui::EndPopup();
+		}
+
+		m_Editor.Render( "##editor" );
+		return true;
+	}
+
+private:
+	void Load( const char *pszPath )
+	{
+		V_strncpy( m_szPath, pszPath, sizeof( m_szPath ) );
+		if ( !m_Editor.Load( pszPath ) )
+			Warning( "Couldn't open %s\n", pszPath );
+	}
+
+	CDearImGuiTextEditor m_Editor;
+	char m_szPath[MAX_PATH] = {};
+	char m_szPendingPath[MAX_PATH] = {};
+	bool m_bConfirmDiscard = false;
+};
+
+static CDearImGuiTextEditorWindow s_TextEditorWindow;
+
+CON_COMMAND_F( imgui_edit, "Opens a file in the imgui text editor, through the game's search paths", FCVAR_CLIENTDLL )
+{
+	if ( args.ArgC() < 2 )
+	{
+		Msg( "Format: imgui_edit <path>\n" );
+		return;
+	}
+
+	s_TextEditorWindow.Open( args.Arg( 1 ) );
+}
@@ -0,0 +1,158 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#pragma once
+
+#include "utlstring.h"
+#include "utlvector.h"
+#include "imgui/imgui.h"
+
+//--------------------------------------------------------------------------------//
+// Purpose: Text editor widget for files too large for InputTextMultiline. Text is
+//  a piece table over the file as loaded and an append-only buffer of everything
+//  typed, plus an index of line starts, so an edit costs the pieces and lines after
+//  it instead of the whole file. Only lines on screen are laid out and colored.
+//  Files are read and written through ImFileOpen and friends, which go through
+//  the engine filesystem, so files inside VPKs can be opened.
+//--------------------------------------------------------------------------------//
+class CDearImGuiTextEditor
+{
+public:
+	enum Language_t
+	{
+		LANGUAGE_PLAIN,
+		LANGUAGE_CFG,
+		LANGUAGE_KEYVALUES,
+		LANGUAGE_SQUIRREL,
+	};
+
+	CDearImGuiTextEditor();
+	~CDearImGuiTextEditor();
+
+	// Loading picks the language from the file extension
+	bool Load( const char *pszPath );
+	bool Save( const char *pszPath = nullptr );
+	void SetText( const char *pszText, int nLength );
+	void GetText( CUtlVector<char> &text ) const;
+
+	// Draws the editor. Returns true if the text was changed this frame.
+	bool Render( const char *pszLabel, const ImVec2 &size = ImVec2( 0.0f, 0.0f ) );
+
+	// Edits, positions are byte offsets into the text
+	void Insert( int nPos, const char *pszText, int nLength );
+	void Delete( int nPos, int nLength );
+
+	// Case insensitive, returns the position of the match or -1
+	int Find( const char *pszText, int nFrom, bool bForward ) const;
+
+	int GetLength() const { return m_nLength; }
+	int GetLineCount() const { return m_LineStarts.Count(); }
+	bool IsModified() const { return m_nGeneration != m_nSavedGeneration; }
+	const char *GetPath() const { return m_Path.Get(); }
+
+	void SetLanguage( Language_t eLanguage ) { m_eLanguage = eLanguage; }
+	void SetReadOnly( bool bReadOnly ) { m_bReadOnly = bReadOnly; }
+
+private:
+	struct Piece_t
+	{
+		int nStart;
+		int nLength;
+		bool bAdded;		// In m_Added rather than m_Original
+	};
+
+	struct UndoState_t
+	{
+		CUtlVector<Piece_t> pieces;
+		int nCursor;
+		int nAnchor;
+		int nGeneration;
+	};
+
+	const char *GetPieceData( const Piece_t &piece ) const { return ( piece.bAdded ? m_Added.Base() : m_Original.Base() ) + piece.nStart; }
+	int FindPiece( int nPos ) const;
+	int SplitPiece( int nPos );
+	void UpdatePieceStarts();
+	void RebuildLineIndex();
+	char GetChar( int nPos ) const;
+	void CopyText( int nPos, int nLength, CUtlVector<char> &out ) const;
+	int FindForward( const char *pszText, int nLength, int nFrom ) const;
+
+	int GetLineOf( int nPos ) const;
+	int GetLineStart( int nLine ) const { return m_LineStarts[nLine]; }
+	int GetLineEnd( int nLine ) const;
+	void GetLine( int nLine, CUtlVector<char> &out ) const;
+
+	void PushUndo( bool bTyping );
+	void ApplyUndo( CUtlVector<UndoState_t *> &from, CUtlVector<UndoState_t *> &to );
+	void ClearUndo();
+
+	bool HasSelection() const { return m_nCursor != m_nAnchor; }
+	void DeleteSelection();
+	void InsertAtCursor( const char *pszText, int nLength, bool bTyping );
+	void MoveCursor( int nPos, bool bSelect );
+
+	float GetAdvance( unsigned int c, float flX ) const;
+	float MeasureColumn( const char *pszLine, int nLength, int nColumn ) const;
+	int FindColumn( const char *pszLine, int nLength, float flX ) const;
+	void ColorLine( const char *pszLine, int nLength );
+
+	void HandleKeyboard( int nPageLines );
+	void DrawSearchBar();
+	void Search( bool bForward, bool bNext );
+
+	CUtlVector<char> m_Original;
+	CUtlVector<char> m_Added;
+	CUtlVector<Piece_t> m_Pieces;
+	CUtlVector<int> m_PieceStarts;
+	CUtlVector<int> m_LineStarts;
+	int m_nLength = 0;
+
+	CUtlVector<UndoState_t *> m_Undo;
+	CUtlVector<UndoState_t *> m_Redo;
+	int m_nGeneration = 0;
+	int m_nGenerationCounter = 0;
+	int m_nSavedGeneration = 0;
+	int m_nLastTypedPos = -1;
+
+	int m_nCursor = 0;
+	int m_nAnchor = 0;
+	float m_flPreferredX = -1.0f;		// Kept while moving up and down
+	float m_flMaxWidth = 0.0f;
+	bool m_bScrollToCursor = false;
+	bool m_bSelecting = false;
+
+	char m_szSearch[128] = {};
+	int m_nSearchOrigin = 0;
+	bool m_bSearchOpen = false;
+	bool m_bFocusSearch = false;
+	bool m_bFocusText = false;
+
+	// Scratch for the line being drawn
+	CUtlVector<char> m_Line;
+	CUtlVector<uint8> m_Colors;
+
+	CUtlString m_Path;
+	Language_t m_eLanguage = LANGUAGE_PLAIN;
+	bool m_bReadOnly = false;
+};
@@ -0,0 +1,225 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#include "imgui_trace.h"
+
+#include "convar.h"
+#include "filesystem.h"
+#include "tier0/fasttimer.h"
+#include "tier0/vprof.h"
+
+#include "tier0/memdbgon.h"
+
+static ConVar imgui_trace_events( "imgui_trace_events", "262144", FCVAR_NONE, "Events each thread can record in an imgui trace capture, 24 bytes each" );
+
+CDearImGuiTrace g_ImGuiTrace;
+
+static CThreadLocalPtr<void> s_pTraceThreadBuffer;
+
+static inline int64 GetTraceTicks()
+{
+	CCycleCount count;
+	count.Sample();
+	return count.GetLongCycles();
+}
+
+CDearImGuiTrace::~CDearImGuiTrace()
+{
+	m_Buffers.PurgeAndDeleteElements();
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: The calling thread's buffer, created the first time it records anything
+//---------------------------------------------------------------------------------------//
+CDearImGuiTrace::ThreadBuffer_t *CDearImGuiTrace::GetThreadBuffer()
+{
+	ThreadBuffer_t *pBuffer = static_cast<ThreadBuffer_t *>( s_pTraceThreadBuffer.Get() );
+	if ( pBuffer )
+		return pBuffer;
+
+	pBuffer = new ThreadBuffer_t;
+	pBuffer->nThreadId = ThreadGetCurrentId();
+	pBuffer->bMainThread = ThreadInMainThread();
+	pBuffer->events.EnsureCapacity( MAX( imgui_trace_events.GetInt(), 1 ) );
+	pBuffer->nDropped = 0;
+	s_pTraceThreadBuffer.Set( pBuffer );
+
+	AUTO_LOCK( m_BuffersMutex );
+	m_Buffers.AddToTail( pBuffer );
+	return pBuffer;
+}
+
+// Buffers never grow while capturing, so recording doesn't allocate
+void CDearImGuiTrace::Record( const char *pszName, char nPhase )
+{
+	if ( !m_bCapturing )
+		return;
+
+	ThreadBuffer_t *pBuffer = GetThreadBuffer();
+	if ( pBuffer->events.Count() == pBuffer->events.NumAllocated() )
+	{
+		pBuffer->nDropped++;
+		return;
+	}
+
+	Event_t &event = pBuffer->events[pBuffer->events.AddToTail()];
+	event.nTicks = GetTraceTicks();
+	event.pszName = pszName;
+	event.nPhase = nPhase;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Starting and stopping, on the main thread between frames
+//---------------------------------------------------------------------------------------//
+void CDearImGuiTrace::Start( float flSeconds, const char *pszPath )
+{
+	if ( m_bCapturing )
+		Stop();
+
+	{
+		AUTO_LOCK( m_BuffersMutex );
+		const int nEvents = MAX( imgui_trace_events.GetInt(), 1 );
+		FOR_EACH_VEC( m_Buffers, i )
+		{
+			m_Buffers[i]->events.RemoveAll();
+			m_Buffers[i]->events.EnsureCapacity( nEvents );
+			m_Buffers[i]->nDropped = 0;
+		}
+	}
+
+	m_Path = pszPath;
+	m_flEndTime = Plat_FloatTime() + flSeconds;
+	m_nStartTicks = GetTraceTicks();
+	m_bCapturing = true;
+}
+
+void CDearImGuiTrace::Update()
+{
+	if ( m_bCapturing && Plat_FloatTime() >= m_flEndTime )
+		Stop();
+}
+
+void CDearImGuiTrace::Stop()
+{
+	if ( !m_bCapturing )
+		return;
+
+	m_bCapturing = false;
+	Write();
+
+	// The events aren't needed until the next capture
+	AUTO_LOCK( m_BuffersMutex );
+	FOR_EACH_VEC( m_Buffers, i )
+		m_Buffers[i]->events.Purge();
+}
+
+static void WriteJSONString( CUtlBuffer &buf, const char *pszString )
+{
+	buf.PutChar( '"' );
+	for ( const char *p = pszString; *p; p++ )
+	{
+		if ( *p == '"' || *p == '\\' )
+			buf.PutChar( '\\' );
+		if ( (unsigned char)*p >= ' ' )
+			buf.PutChar( *p );
+	}
+	buf.PutChar( '"' );
+}
+
+void CDearImGuiTrace::Write()
+{
+	VPROF_BUDGET( "CDearImGuiTrace::Write", VPROF_BUDGETGROUP_IMGUI );
+
+	CUtlBuffer buf( 0, 0, CUtlBuffer::TEXT_BUFFER );
+	buf.PutString( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+
+	CCycleCount ticks;
+	int nEvents = 0, nDropped = 0;
+	bool bFirst = true;
+
+	AUTO_LOCK( m_BuffersMutex );
+	FOR_EACH_VEC( m_Buffers, i )
+	{
+		const ThreadBuffer_t *pBuffer = m_Buffers[i];
+		if ( !pBuffer->events.Count() )
+			continue;
+
+		buf.Printf( "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+			bFirst ? "" : ",\n", (uint32)pBuffer->nThreadId, pBuffer->bMainThread ? "Main" : "Worker", (uint32)pBuffer->nThreadId );
+		bFirst = false;
+
+		FOR_EACH_VEC( pBuffer->events, j )
+		{
+			const Event_t &event = pBuffer->events[j];
+			ticks.Init( (uint64)( event.nTicks - m_nStartTicks ) );
+
+			buf.Printf( ",\n{\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u", event.nPhase, ticks.GetMicrosecondsF(), (uint32)pBuffer->nThreadId );
+			if ( event.pszName )
+			{
+				buf.PutString( ",\"name\":" );
+				WriteJSONString( buf, event.pszName );
+			}
+			if ( event.nPhase == 'i' )
+				buf.PutString( ",\"s\":\"t\"" );
+			buf.PutChar( '}' );
+		}
+
+		nEvents += pBuffer->events.Count();
+		nDropped += pBuffer->nDropped;
+	}
+
+	buf.PutString( "\n]}\n" );
+
+	if ( !g_pFullFileSystem->WriteFile( m_Path, "MOD", buf ) )
+	{
+		Warning( "imgui_trace_capture: Failed to write %s\n", m_Path.Get() );
+		return;
+	}
+
+	Msg( "imgui_trace_capture: Wrote %d events to %s\n", nEvents, m_Path.Get() );
+	if ( nDropped )
+		Warning( "imgui_trace_capture: %d events were dropped, raise imgui_trace_events\n", nDropped );
+}
+
+CON_COMMAND_F( imgui_trace_capture, "Records imgui frame phases for a number of seconds and writes them as Chrome trace JSON. Format: imgui_trace_capture <seconds> [file]", FCVAR_CLIENTDLL )
+{
+	if ( args.ArgC() < 2 )
+	{
+		if ( g_ImGuiTrace.IsCapturing() )
+			g_ImGuiTrace.Stop();
+		else
+			Msg( "Format: imgui_trace_capture <seconds> [file]\n" );
+		return;
+	}
+
+	const float flSeconds = V_atof( args.Arg( 1 ) );
+	const char *pszPath = args.ArgC() >= 3 ? args.Arg( 2 ) : "imgui_trace.json";
+	if ( flSeconds <= 0.0f )
+	{
+		Msg( "imgui_trace_capture: Seconds must be positive\n" );
+		return;
+	}
+
+	g_ImGuiTrace.Start( flSeconds, pszPath );
+	Msg( "imgui_trace_capture: Recording for %.1f seconds\n", flSeconds );
+}
@@ -0,0 +1,108 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#pragma once
+
+#include "utlstring.h"
+#include "utlvector.h"
+#include "tier0/threadtools.h"
+
+//--------------------------------------------------------------------------------//
+// Purpose: Captures begin and end events of the imgui frame phases for a number of
+//  seconds and writes them as Chrome trace event JSON, for chrome://tracing, Perfetto
+//  and friends. Each thread records into its own fixed size buffer, so recording is
+//  a timestamp and a store with no locking; events past the end are counted and
+//  dropped. Event names aren't copied and must outlive the capture.
+//--------------------------------------------------------------------------------//
+class CDearImGuiTrace
+{
+public:
+	~CDearImGuiTrace();
+
+	void Start( float flSeconds, const char *pszPath );
+
+	// Once per frame, between frames. Writes the trace once the time is up.
+	void Update();
+
+	// Ends the capture early, writing what was recorded so far
+	void Stop();
+
+	bool IsCapturing() const { return m_bCapturing; }
+
+	void Begin( const char *pszName ) { Record( pszName, 'B' ); }
+	void End() { Record( nullptr, 'E' ); }
+	void Instant( const char *pszName ) { Record( pszName, 'i' ); }
+
+private:
+	struct Event_t
+	{
+		int64 nTicks;
+		const char *pszName;
+		char nPhase;
+	};
+
+	struct ThreadBuffer_t
+	{
+		ThreadId_t nThreadId;
+		bool bMainThread;
+		CUtlVector<Event_t> events;
+		int nDropped;
+	};
+
+	void Record( const char *pszName, char nPhase );
+	ThreadBuffer_t *GetThreadBuffer();
+	void Write();
+
+	volatile bool m_bCapturing = false;
+	double m_flEndTime = 0.0;
+	int64 m_nStartTicks = 0;
+	CUtlString m_Path;
+
+	// Buffers are kept for the life of their thread, and reset when a capture starts
+	CThreadFastMutex m_BuffersMutex;
+	CUtlVector<ThreadBuffer_t *> m_Buffers;
+};
+
+extern CDearImGuiTrace g_ImGuiTrace;
+
+// Records a begin event now and the matching end event when the scope is left
+class CDearImGuiTraceScope
+{
+public:
+	CDearImGuiTraceScope( const char *pszName ) : m_bActive( g_ImGuiTrace.IsCapturing() )
+	{
+		if ( m_bActive )
+			g_ImGuiTrace.Begin( pszName );
+	}
+
+	~CDearImGuiTraceScope()
+	{
+		if ( m_bActive )
+			g_ImGuiTrace.End();
+	}
+
+private:
+	bool m_bActive;
+};
+
+#define IMGUI_TRACE_SCOPE( name )	CDearImGuiTraceScope _imguiTraceScope( name )
@@ -28,6 +28,15 @@
 #include "imgui_system.h"
 #include "utlmap.h"
 
+// How much of a window could be seen when it was last submitted
+enum ImguiWindowVisibility_t
+{
+	IMGUI_WINDOW_VISIBLE = 0,
+	IMGUI_WINDOW_COLLAPSED,		// ImGui::Begin returned false, Draw() is never called
+	IMGUI_WINDOW_OFFSCREEN,		// Entirely outside of the display
+	IMGUI_WINDOW_OCCLUDED,		// Entirely covered by an opaque window in front of it
+};
+
 // Implemented by devui_static
 extern void RegisterImGuiWindowFactory( IImguiWindow *pWindow );
 
@@ -80,8 +89,31 @@ public:
 
 	virtual void OnChangeVisibility() {}
 
+	// Overlay windows keep drawing through IImguiSystem::RenderOverlay while input is disabled,
+	// without the input popup. They can't be interacted with until input is enabled again.
+	virtual bool IsOverlay() const { return false; }
+
+	// Return true to skip Draw() while the window is off screen or covered by another window.
+	// Only opt in if Draw() has no side effects the window relies on, and doesn't auto-resize.
+	virtual bool SkipDrawWhenHidden() const { return false; }
+
+	// Windows returning non-zero values here are throttled by the system's scheduler, which
+	// rebuilds their contents on some frames and replays the previous output on the others.
+	// Interacting with a throttled window always rebuilds it.
+
+	// Rate in Hz at which the contents need to be rebuilt. 0 means every frame.
+	virtual float GetRefreshRate() const { return 0.0f; }
+
+	// Average milliseconds per frame Draw() may cost. 0 means unlimited.
+	virtual float GetFrameBudget() const { return 0.0f; }
+
+	// Visibility for the current frame, updated by the system right before Draw()
+	ImguiWindowVisibility_t GetVisibility() const { return m_eVisibility; }
+	void SetVisibility( ImguiWindowVisibility_t eVisibility ) { m_eVisibility = eVisibility; }
+
 protected:
 	bool m_bEnabled = false;
+	ImguiWindowVisibility_t m_eVisibility = IMGUI_WINDOW_VISIBLE;
 	const char *m_pName;
 	const char* m_pTitle;
 };
@@ -0,0 +1,191 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#include "imgui_worldlabels.h"
+
+#include "convar.h"
+#include "mathlib/vmatrix.h"
+#include "tier0/vprof.h"
+#include "imgui/imgui.h"
+
+#include "tier0/memdbgon.h"
+
+static ConVar imgui_worldlabels( "imgui_worldlabels", "1", FCVAR_NONE, "Draw world labels" );
+static ConVar imgui_worldlabels_distance( "imgui_worldlabels_distance", "2048", FCVAR_ARCHIVE, "Default distance past which world labels are culled" );
+static ConVar imgui_worldlabels_max( "imgui_worldlabels_max", "256", FCVAR_ARCHIVE, "Most world labels drawn in a frame" );
+static ConVar imgui_worldlabels_cell( "imgui_worldlabels_cell", "8", FCVAR_NONE, "Size in pixels of the grid used to reject overlapping world labels", true, 2, true, 64 );
+static ConVar imgui_worldlabels_queue( "imgui_worldlabels_queue", "16384", FCVAR_NONE, "Most world labels collected between two imgui frames, more are dropped" );
+
+CDearImGuiWorldLabels g_ImGuiWorldLabels;
+
+void CDearImGuiWorldLabels::Add( const Vector &vecOrigin, const char *pszText, Color color, int nPriority, float flMaxDistance )
+{
+	if ( !imgui_worldlabels.GetBool() || m_Labels.Count() >= imgui_worldlabels_queue.GetInt() )
+		return;
+
+	WorldLabel_t &label = m_Labels[m_Labels.AddToTail()];
+	label.vecOrigin = vecOrigin;
+	label.color = color;
+	label.nPriority = nPriority;
+	label.flMaxDistance = flMaxDistance > 0.0f ? flMaxDistance : imgui_worldlabels_distance.GetFloat();
+
+	const int nLength = pszText ? V_strlen( pszText ) : 0;
+	label.nText = m_Text.AddMultipleToTail( nLength + 1 );
+	if ( nLength )
+		V_memcpy( m_Text.Base() + label.nText, pszText, nLength );
+	m_Text[label.nText + nLength] = '\0';
+}
+
+void CDearImGuiWorldLabels::Clear()
+{
+	m_Labels.RemoveAll();
+	m_Text.RemoveAll();
+}
+
+// Higher priority first, then closer first
+int CDearImGuiWorldLabels::SortVisible( const VisibleLabel_t *a, const VisibleLabel_t *b )
+{
+	if ( a->nPriority != b->nPriority )
+		return a->nPriority > b->nPriority ? -1 : 1;
+	if ( a->flDistance != b->flDistance )
+		return a->flDistance < b->flDistance ? -1 : 1;
+	return a->nLabel - b->nLabel;
+}
+
+//---------------------------------------------------------------------------------------//
+// Purpose: Project, cull, sort and place this frame's labels
+//---------------------------------------------------------------------------------------//
+void CDearImGuiWorldLabels::Flush( ImDrawList *pDrawList, const VMatrix &worldToScreen, float flScreenWidth, float flScreenHeight )
+{
+	VPROF_BUDGET( "CDearImGuiWorldLabels::Flush", VPROF_BUDGETGROUP_IMGUI );
+
+	// Projection. The w row of a perspective projection is the depth along the view axis,
+	// which doubles as the distance for culling.
+	const float flHalfWidth = flScreenWidth * 0.5f;
+	const float flHalfHeight = flScreenHeight * 0.5f;
+	const float flMargin = 32.0f;
+
+	m_Visible.RemoveAll();
+	m_Visible.EnsureCapacity( m_Labels.Count() );
+	for ( int i = 0; i < m_Labels.Count(); i++ )
+	{
+		const WorldLabel_t &label = m_Labels[i];
+		const Vector &v = label.vecOrigin;
+
+		const float w = worldToScreen[3][0] * v.x + worldToScreen[3][1] * v.y + worldToScreen[3][2] * v.z + worldToScreen[3][3];
+		if ( w < 0.001f || w > label.flMaxDistance )
+			continue;
+
+		const float flInvW = 1.0f / w;
+		const float x = flHalfWidth + flHalfWidth * flInvW * ( worldToScreen[0][0] * v.x + worldToScreen[0][1] * v.y + worldToScreen[0][2] * v.z + worldToScreen[0][3] );
+		const float y = flHalfHeight - flHalfHeight * flInvW * ( worldToScreen[1][0] * v.x + worldToScreen[1][1] * v.y + worldToScreen[1][2] * v.z + worldToScreen[1][3] );
+		if ( x < -flMargin || y < -flMargin || x > flScreenWidth + flMargin || y > flScreenHeight + flMargin )
+			continue;
+
+		VisibleLabel_t &visible = m_Visible[m_Visible.AddToTail()];
+		visible.x = x;
+		visible.y = y;
+		visible.flDistance = w;
+		visible.nPriority = label.nPriority;
+		visible.nLabel = i;
+	}
+
+	VPROF_INCREMENT_COUNTER( "ImGui world labels submitted", m_Labels.Count() );
+	VPROF_INCREMENT_COUNTER( "ImGui world labels on screen", m_Visible.Count() );
+
+	m_Visible.Sort( SortVisible );
+
+	// Overlap rejection. Labels are placed in priority order and claim the grid cells they
+	// cover, anything landing on a claimed cell is dropped.
+	const int nCell = imgui_worldlabels_cell.GetInt();
+	const int nGridWidth = (int)flScreenWidth / nCell + 1;
+	const int nGridHeight = (int)flScreenHeight / nCell + 1;
+	m_Grid.SetCount( nGridWidth * nGridHeight );
+	V_memset( m_Grid.Base(), 0, m_Grid.Count() );
+
+	const int nMaxDrawn = imgui_worldlabels_max.GetInt();
+	const float flMarkerRadius = 3.0f;
+	int nDrawn = 0;
+	for ( int i = 0; i < m_Visible.Count() && nDrawn < nMaxDrawn; i++ )
+	{
+		const VisibleLabel_t &visible = m_Visible[i];
+
+		// Cheap test on the anchor before measuring any text
+		const int nAnchorX = clamp( (int)visible.x / nCell, 0, nGridWidth - 1 );
+		const int nAnchorY = clamp( (int)visible.y / nCell, 0, nGridHeight - 1 );
+		if ( m_Grid[nAnchorY * nGridWidth + nAnchorX] )
+			continue;
+
+		const WorldLabel_t &label = m_Labels[visible.nLabel];
+		const char *pszText = m_Text.Base() + label.nText;
+
+		ImVec2 vecMin, vecMax;
+		if ( *pszText )
+		{
+			const ImVec2 vecSize = ImGui::CalcTextSize( pszText );
+			vecMin = ImVec2( visible.x - vecSize.x * 0.5f, visible.y - vecSize.y * 0.5f );
+			vecMax = ImVec2( vecMin.x + vecSize.x, vecMin.y + vecSize.y );
+		}
+		else
+		{
+			vecMin = ImVec2( visible.x - flMarkerRadius, visible.y - flMarkerRadius );
+			vecMax = ImVec2( visible.x + flMarkerRadius, visible.y + flMarkerRadius );
+		}
+
+		const int nMinX = clamp( (int)vecMin.x / nCell, 0, nGridWidth - 1 );
+		const int nMinY = clamp( (int)vecMin.y / nCell, 0, nGridHeight - 1 );
+		const int nMaxX = clamp( (int)vecMax.x / nCell, 0, nGridWidth - 1 );
+		const int nMaxY = clamp( (int)vecMax.y / nCell, 0, nGridHeight - 1 );
+
+		bool bOverlaps = false;
+		for ( int cy = nMinY; cy <= nMaxY && !bOverlaps; cy++ )
+		{
+			for ( int cx = nMinX; cx <= nMaxX; cx++ )
+			{
+				if ( m_Grid[cy * nGridWidth + cx] )
+				{
+					bOverlaps = true;
+					break;
+				}
+			}
+		}
+
+		if ( bOverlaps )
+			continue;
+
+		for ( int cy = nMinY; cy <= nMaxY; cy++ )
+			V_memset( m_Grid.Base() + cy * nGridWidth + nMinX, 1, nMaxX - nMinX + 1 );
+
+		const ImU32 col = IM_COL32( label.color.r(), label.color.g(), label.color.b(), label.color.a() );
+		if ( *pszText )
+			pDrawList->AddText( vecMin, col, pszText );
+		else
+			pDrawList->AddCircleFilled( ImVec2( visible.x, visible.y ), flMarkerRadius, col, 8 );
+
+		nDrawn++;
+	}
+
+	VPROF_INCREMENT_COUNTER( "ImGui world labels drawn", nDrawn );
+
+	Clear();
+}
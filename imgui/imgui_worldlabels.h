@@ -0,0 +1,79 @@
+/*********************************************************************************
+*  MIT License
+*  
+*  Copyright (c) 2023 Strata Source Contributors
+*  
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*  
+*  The above copyright notice and this permission notice shall be included in all
+*  copies or substantial portions of the Software.
+*  
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+*  SOFTWARE.
+*********************************************************************************/
+#pragma once
+
+#include "imgui_system.h"
+#include "utlvector.h"
+
+struct ImDrawList;
+class VMatrix;
+
+//--------------------------------------------------------------------------------//
+// Purpose: World space labels. Labels are collected during the frame, then projected
+//  in one pass and thinned out so the cost follows what ends up on screen rather than
+//  how many labels were submitted.
+//--------------------------------------------------------------------------------//
+class CDearImGuiWorldLabels
+{
+public:
+	void Add( const Vector &vecOrigin, const char *pszText, Color color, int nPriority, float flMaxDistance );
+
+	bool HasWork() const { return m_Labels.Count() > 0; }
+
+	// Main thread, between NewFrame and Render. Draws this frame's labels and clears them.
+	void Flush( ImDrawList *pDrawList, const VMatrix &worldToScreen, float flScreenWidth, float flScreenHeight );
+
+	void Clear();
+
+private:
+	struct WorldLabel_t
+	{
+		Vector vecOrigin;
+		Color color;
+		int nPriority;
+		float flMaxDistance;
+		int nText;			// Offset into m_Text
+	};
+
+	struct VisibleLabel_t
+	{
+		float x, y;
+		float flDistance;
+		int nPriority;
+		int nLabel;
+	};
+
+	static int SortVisible( const VisibleLabel_t *a, const VisibleLabel_t *b );
+
+	CUtlVector<WorldLabel_t> m_Labels;
+	CUtlVector<VisibleLabel_t> m_Visible;
+
+	// Label strings for this frame, so submitting doesn't allocate per label
+	CUtlVector<char> m_Text;
+
+	// Screen space occupancy, one byte per imgui_worldlabels_cell square
+	CUtlVector<uint8> m_Grid;
+};
+
+extern CDearImGuiWorldLabels g_ImGuiWorldLabels;